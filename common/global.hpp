@@ -31,6 +31,8 @@ this hpp initialize and finalize the global enviroment
 #include <openssl/sha.h>
 #include <openssl/err.h>
 
+#include "thread_pool.hpp"
+
 using namespace std;
 
 /* global constants */
@@ -48,8 +50,38 @@ BIGNUM *BN_0;
 BIGNUM *BN_1; 
 BIGNUM *BN_2; 
 
-/* initialize global variables */
-bool global_initialize(int curve_id)
+/* 
+** the arithmetic behind the bulk point operations (table build, Shanks search) on P-256, see src/p256.hpp, 
+** and behind the variable-base multiplications on secp256k1, see src/secp256k1.hpp 
+*/
+enum GROUP_Backend {GROUP_OPENSSL = 0, GROUP_P256_NATIVE = 1, GROUP_SECP256K1_GLV = 2}; 
+int group_backend = GROUP_OPENSSL; 
+
+/* 
+** OpenSSL 3.0 deprecates the batch normalisation and the Jacobian coordinates of EC_POINT without a replacement 
+** in its public API, and EC_POINT_get_affine_coordinates pays an inversion per point (nistz256 even for an affine one); 
+** the table builds and the searches reach them through these wrappers only 
+*/
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+inline int ECP_batch_make_affine(size_t num, EC_POINT *A[], BN_CTX *ctx)
+{
+    return EC_POINTs_make_affine(group, num, A, ctx); 
+}
+
+inline int ECP_get_Jprojective_coordinates(const EC_POINT *A, BIGNUM *x, BIGNUM *y, BIGNUM *z, BN_CTX *ctx)
+{
+    return EC_POINT_get_Jprojective_coordinates_GFp(group, A, x, y, z, ctx); 
+}
+
+inline int ECP_set_Jprojective_coordinates(EC_POINT *A, const BIGNUM *x, const BIGNUM *y, const BIGNUM *z, BN_CTX *ctx)
+{
+    return EC_POINT_set_Jprojective_coordinates_GFp(group, A, x, y, z, ctx); 
+}
+#pragma GCC diagnostic pop
+
+/* initialize global variables, THREAD_NUM threads (including the caller) serve the parallel operations */
+bool global_initialize(int curve_id, size_t THREAD_NUM = thread::hardware_concurrency())
 {
     #ifdef DEBUG
         cout << "initialize global enviroment" << endl; 
@@ -61,6 +93,10 @@ bool global_initialize(int curve_id)
     if (group == NULL || order == NULL || bn_ctx == NULL) return false; 
     
     EC_GROUP_precompute_mult((EC_GROUP *) group, bn_ctx); // pre-compute the table of g     
+
+    group_backend = GROUP_OPENSSL; 
+    if(curve_id == NID_X9_62_prime256v1) group_backend = GROUP_P256_NATIVE; 
+    if(curve_id == NID_secp256k1) group_backend = GROUP_SECP256K1_GLV; 
     
     #ifdef DEBUG
     if(EC_GROUP_have_precompute_mult((EC_GROUP *)group)){ 
@@ -78,6 +114,8 @@ bool global_initialize(int curve_id)
     BN_2 = BN_new(); 
     BN_set_word(BN_2, 2); // set bn_2 = 2
     if (BN_0 == NULL || BN_1 == NULL || BN_2 == NULL) return false; 
+
+    THREAD_POOL_new(max<size_t>(THREAD_NUM, 1), group); 
     
     return true;
 }
@@ -88,6 +126,8 @@ void global_finalize()
     #ifdef DEMO
         cout << "finalize global enviroment" << endl; 
     #endif
+    THREAD_POOL_free(); 
+
     EC_GROUP_free(group);
     BN_CTX_free(bn_ctx);
     
@@ -0,0 +1,219 @@
+/****************************************************************************
+this hpp implements a persistent thread pool shared by all parallel operations
+*****************************************************************************
+* @author     This file is part of PGC, developed by Yu Chen
+* @paper      https://eprint.iacr.org/2019/319
+* @copyright  MIT license (see LICENSE file)
+*****************************************************************************/
+
+/*
+    the pool is created once (global_initialize) and every Parallel_* routine submits its tasks to it,
+    so no thread is spawned per call. the submitting thread runs the first task itself and helps with
+    the queued ones while waiting, hence nested submissions cannot deadlock.
+    each thread that executes tasks owns a WORKER_CONTEXT: OpenSSL requires a BN_CTX to be used
+    by a single thread, tasks therefore take the BN_CTX and scratch points from THREAD_POOL_context()
+    the pool lives on the heap and is never destroyed: a program may exit (exit(EXIT_FAILURE) on a failed
+    decryption, or return from main without global_finalize) while the workers wait on its condition variables.
+    THREAD_POOL_exit, registered with atexit, stops and joins the workers before the static objects go away
+*/
+
+#ifndef __THREAD_POOL__
+#define __THREAD_POOL__
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <cstdlib>
+
+#include <openssl/ec.h>
+#include <openssl/bn.h>
+
+using namespace std;
+
+const size_t WORKER_SCRATCH_NUM = 4; // the number of scratch points owned by each thread
+
+struct WORKER_CONTEXT
+{
+    BN_CTX *bn_ctx;
+    EC_POINT *scratch[WORKER_SCRATCH_NUM];
+};
+
+// a set of tasks submitted together, pending is guarded by the pool mutex
+struct TASK_GROUP
+{
+    size_t pending;
+};
+
+struct POOL_TASK
+{
+    function<void()> job;
+    TASK_GROUP *task_group;
+};
+
+struct THREAD_POOL
+{
+    const EC_GROUP *group;
+    vector<thread> worker;
+    vector<WORKER_CONTEXT *> context; // contexts of the workers and of the threads that submitted tasks
+    deque<POOL_TASK> queue;
+    mutex mtx;
+    condition_variable task_cv; // signalled when a task is queued or the pool stops
+    condition_variable done_cv; // signalled when a task finishes
+    bool stop;
+    uint64_t generation; // tells the contexts of the current pool from those of a freed one
+};
+
+THREAD_POOL &thread_pool = *new THREAD_POOL();
+
+thread_local WORKER_CONTEXT *local_context = NULL;
+thread_local uint64_t local_generation = 0;
+thread_local bool local_worker = false; // the calling thread is a worker of the pool
+
+void WORKER_CONTEXT_new(WORKER_CONTEXT *&context, const EC_GROUP *group)
+{
+    context = new WORKER_CONTEXT;
+    context->bn_ctx = BN_CTX_new();
+    for(auto i = 0; i < WORKER_SCRATCH_NUM; i++){
+        context->scratch[i] = EC_POINT_new(group);
+    }
+}
+
+void WORKER_CONTEXT_free(WORKER_CONTEXT *&context)
+{
+    BN_CTX_free(context->bn_ctx);
+    for(auto i = 0; i < WORKER_SCRATCH_NUM; i++){
+        EC_POINT_free(context->scratch[i]);
+    }
+    delete context;
+    context = NULL;
+}
+
+/* return the context of the calling thread, it is created on first use and freed with the pool */
+WORKER_CONTEXT* THREAD_POOL_context()
+{
+    if(local_context == NULL || local_generation != thread_pool.generation)
+    {
+        WORKER_CONTEXT_new(local_context, thread_pool.group);
+        local_generation = thread_pool.generation;
+
+        lock_guard<mutex> lock(thread_pool.mtx);
+        thread_pool.context.push_back(local_context);
+    }
+    return local_context;
+}
+
+/* run a task and report its completion to the task group */
+void THREAD_POOL_execute(POOL_TASK &task)
+{
+    task.job();
+
+    lock_guard<mutex> lock(thread_pool.mtx);
+    task.task_group->pending--;
+    if(task.task_group->pending == 0) thread_pool.done_cv.notify_all();
+}
+
+void THREAD_POOL_worker()
+{
+    local_worker = true;
+    THREAD_POOL_context();
+    while(true)
+    {
+        POOL_TASK task;
+        {
+            unique_lock<mutex> lock(thread_pool.mtx);
+            while(thread_pool.stop == false && thread_pool.queue.empty() == true){
+                thread_pool.task_cv.wait(lock);
+            }
+            if(thread_pool.queue.empty() == true) return; // the pool stops
+            task = thread_pool.queue.front();
+            thread_pool.queue.pop_front();
+        }
+        THREAD_POOL_execute(task);
+    }
+}
+
+/* stop the workers and wait for them, the queued tasks are dropped */
+void THREAD_POOL_stop()
+{
+    {
+        lock_guard<mutex> lock(thread_pool.mtx);
+        thread_pool.stop = true;
+        thread_pool.queue.clear();
+    }
+    thread_pool.task_cv.notify_all();
+    for(auto i = 0; i < thread_pool.worker.size(); i++){
+        thread_pool.worker[i].join();
+    }
+    thread_pool.worker.clear();
+}
+
+/* atexit handler: a worker cannot join itself, if it calls exit the others are left to the process exit */
+void THREAD_POOL_exit()
+{
+    if(local_worker == false) THREAD_POOL_stop();
+}
+
+/* start THREAD_NUM-1 workers: the thread that submits tasks is the remaining one */
+void THREAD_POOL_new(size_t THREAD_NUM, const EC_GROUP *group)
+{
+    static bool EXIT_REGISTERED = false;
+    if(EXIT_REGISTERED == false){
+        atexit(THREAD_POOL_exit);
+        EXIT_REGISTERED = true;
+    }
+    thread_pool.group = group;
+    thread_pool.stop = false;
+    thread_pool.generation++;
+    for(auto i = 1; i < THREAD_NUM; i++){
+        thread_pool.worker.push_back(thread(THREAD_POOL_worker));
+    }
+}
+
+void THREAD_POOL_free()
+{
+    THREAD_POOL_stop();
+
+    for(auto i = 0; i < thread_pool.context.size(); i++){
+        WORKER_CONTEXT_free(thread_pool.context[i]);
+    }
+    thread_pool.context.clear();
+    thread_pool.generation++; // contexts still referenced by other threads are stale now
+}
+
+/* run all tasks and wait for them: task[0] runs on the calling thread, the others are queued */
+void THREAD_POOL_run(vector<function<void()>> &task)
+{
+    if(task.empty() == true) return;
+
+    TASK_GROUP task_group;
+    task_group.pending = task.size() - 1;
+    {
+        lock_guard<mutex> lock(thread_pool.mtx);
+        for(auto i = 1; i < task.size(); i++){
+            thread_pool.queue.push_back({task[i], &task_group});
+        }
+    }
+    thread_pool.task_cv.notify_all();
+
+    task[0]();
+
+    // help with the queued tasks until the whole group finishes
+    unique_lock<mutex> lock(thread_pool.mtx);
+    while(task_group.pending > 0)
+    {
+        if(thread_pool.queue.empty() == false)
+        {
+            POOL_TASK other = thread_pool.queue.front();
+            thread_pool.queue.pop_front();
+            lock.unlock();
+            THREAD_POOL_execute(other);
+            lock.lock();
+        }
+        else thread_pool.done_cv.wait(lock);
+    }
+}
+
+#endif
@@ -6,409 +6,1902 @@ this hpp implements DLOG algorithm
 * @copyright  MIT license (see LICENSE file)
 *****************************************************************************/
 
+#ifndef __CALCULATE_DLOG__
+#define __CALCULATE_DLOG__
+
 #include "../common/global.hpp"
+#include "fast_mul.hpp"
+#include "p256_lanes.hpp"
+#include "plaintext_cache.hpp"
+#include <atomic>
+
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
+/* 
+    Shanks algorithm for DLOG problem: given (g, h) find x \in [lo, hi) s.t. g^x = h 
+    g^{lo + j*giantstep_size + i} = g^x; giantstep_num = ceil((hi - lo)/giantstep_size)
+    the interval and the number of baby steps (TABLE_SIZE = giantstep_size) are free parameters, 
+    the table only depends on TABLE_SIZE, so one table serves every interval. 
+    the old parameters (RANGE_LEN, TUNNING) stand for [0, 2^RANGE_LEN) with 2^{RANGE_LEN/2 + TUNNING} baby steps
+*/
+
+/*
+    The baby-step table is a flat open-addressing hash table with linear probing.
+    Instead of the 33-byte compressed EC point, each slot only keeps a 64-bit fingerprint of it
+    together with a 32-bit index, so a lookup costs roughly one cache miss.
+    Since the fingerprint is truncated, a hit is confirmed by recomputing g^i.
+
+    The hashmap file is the slot array itself prefixed by a header (see HASHMAP_Header),
+    so it is mapped read-only into memory and used as is: processes on the same host share the page cache copy.
+
+    In x-only mode the y-parity bit is dropped from the key, so the entry of g^i also matches g^{-i}
+    and the sign is worked out when the hit is verified. The table keeps i in [0, giantstep_size],
+    the giant step doubles and the candidate h - 2j*giantstep_size*g covers x = 2j*giantstep_size +- i,
+    so the search loop runs half as long for the same table.
+*/
+
+// the DLOG algorithm used by decryption
+enum DLOG_Method {SHANKS = 0, KANGAROO = 1, SHANKS_X_ONLY = 2};
+
+const uint32_t HASHMAP_XY_MODE = 0; // the key is the fingerprint of the compressed point
+const uint32_t HASHMAP_X_MODE = 1;  // the key ignores the y-parity: an entry serves both g^i and g^{-i}
+
+const uint32_t HASHMAP_EMPTY_SLOT = 0xFFFFFFFF; // value of an empty slot: the table holds less than 2^32 entries
+
+// where the table lives once it is loaded (see HASHMAP_place)
+enum HASHMAP_Placement {HASHMAP_MAPPED = 0, HASHMAP_HUGEPAGE = 1, HASHMAP_NUMA_REPLICA = 2, HASHMAP_NUMA_INTERLEAVE = 3};
+
+const size_t HASHMAP_MAX_NODE = 16; // NUMA nodes beyond this share the first copy
+
+struct HASHMAP_Entry
+{
+    uint64_t key;   // 64-bit fingerprint of the compressed EC point
+    uint32_t value; // DLOG of the EC point w.r.t. g
+};
+
+struct HASHMAP
+{
+    HASHMAP_Entry *table;
+    uint64_t slot_num;  // power of 2, at least twice the number of entries (load factor <= 1/2)
+    uint64_t mask;      // slot_num - 1
+    uint64_t entry_num; // number of inserted entries
+
+    unsigned char *mapping; // the mapped hashmap file if the table lives there, otherwise NULL
+    size_t mapping_len;
+
+    uint32_t mode;      // HASHMAP_XY_MODE or HASHMAP_X_MODE
+
+    HASHMAP_Entry *replica[HASHMAP_MAX_NODE]; // the copy probed by the threads of each NUMA node 
+    size_t replica_num; // the number of anonymous copies made by HASHMAP_place (replica_num = 0 otherwise)
+    size_t replica_len[HASHMAP_MAX_NODE]; // the mapped length of replica[n]
+
+    uint64_t filter_bucket_num;    // the buckets of the cuckoo filter behind the slot array, 0 if there is no filter
+    uint32_t filter_offset[256];   // the alternate bucket of a tag (see CUCKOO_alt_index)
+};
+
+HASHMAP point2index_map = {NULL, 0, 0, 0, NULL, 0, HASHMAP_XY_MODE}; // key-value hash table: key is fingerprint of EC POINT, value is its DLOG w.r.t. g
+
+/*
+    The cuckoo filter in front of the slot array: all but one probe of a search miss, so the probe first asks
+    a compact filter (about 9 bits per entry, a few MB for common tables) that stays in the last level cache,
+    and only touches the slot array if the filter says yes. A bucket holds 4 one-byte tags, the tag of a key 
+    lives in bucket i1 or i2 = filter_offset[tag] - i1 (mod bucket_num), so the filter passes about 2*4/256 = 3% 
+    of the misses. The filter is built by the same pass as the table and stored right behind the slot array,
+    in memory and in the hashmap file alike.
+*/
+const uint64_t CUCKOO_BUCKET_SIZE = 4; // tags per bucket (one uint32_t)
+const double CUCKOO_MAX_LOAD = 0.9; 
+const size_t CUCKOO_MAX_KICK = 500;  // the insertion gives up after this many relocations
+
+inline uint64_t CUCKOO_bucket_num(uint64_t entry_num)
+{
+    return max<uint64_t>(1, uint64_t(ceil(entry_num/(CUCKOO_BUCKET_SIZE*CUCKOO_MAX_LOAD)))); 
+}
+
+/* set up a filter of bucket_num buckets: the alternate offsets are derived from bucket_num alone */
+void CUCKOO_init(HASHMAP &map, uint64_t bucket_num)
+{
+    map.filter_bucket_num = bucket_num;
+    for(auto tag = 0; tag < 256; tag++){
+        uint64_t hash = uint32_t(((tag + 1) * 0x9E3779B97F4A7C15ULL) >> 32); 
+        map.filter_offset[tag] = uint32_t((hash * bucket_num) >> 32); 
+    }
+}
+
+/* the filter follows the slot array of every copy of the table */
+inline uint32_t* CUCKOO_filter(HASHMAP &map, HASHMAP_Entry *table)
+{
+    return reinterpret_cast<uint32_t *>(table + map.slot_num);
+}
+
+/* bits 1-8 of the key (bit 0 is the y-parity), a tag is never 0 since 0 marks an empty place */
+inline uint8_t CUCKOO_tag(uint64_t key)
+{
+    uint8_t tag = uint8_t(key >> 1);
+    return (tag == 0) ? 1 : tag;
+}
+
+/* the first bucket comes from the upper half of the key */
+inline uint64_t CUCKOO_index(HASHMAP &map, uint64_t key)
+{
+    return ((key >> 32) * map.filter_bucket_num) >> 32;
+}
+
+/* i -> filter_offset[tag] - i (mod bucket_num) swaps the two buckets of a tag */
+inline uint64_t CUCKOO_alt_index(HASHMAP &map, uint64_t i, uint8_t tag)
+{
+    uint64_t offset = map.filter_offset[tag];
+    return (offset >= i) ? offset - i : offset + map.filter_bucket_num - i;
+}
+
+inline bool CUCKOO_bucket_has(uint32_t bucket, uint8_t tag)
+{
+    uint32_t diff = bucket ^ (tag * 0x01010101U);
+    return ((diff - 0x01010101U) & ~diff & 0x80808080U) != 0; // some byte of diff is zero
+}
+
+inline bool CUCKOO_contains(HASHMAP &map, HASHMAP_Entry *table, uint64_t key)
+{
+    uint32_t *filter = CUCKOO_filter(map, table);
+    uint8_t tag = CUCKOO_tag(key);
+    uint64_t i1 = CUCKOO_index(map, key);
+    return CUCKOO_bucket_has(filter[i1], tag) || CUCKOO_bucket_has(filter[CUCKOO_alt_index(map, i1, tag)], tag);
+}
+
+/* put tag into a free place of bucket i: return false if the bucket is full */
+inline bool CUCKOO_bucket_put(uint32_t &bucket, uint8_t tag)
+{
+    for(auto k = 0; k < CUCKOO_BUCKET_SIZE; k++){
+        if(((bucket >> (8*k)) & 0xFF) == 0){
+            bucket |= uint32_t(tag) << (8*k);
+            return true;
+        }
+    }
+    return false;
+}
+
+/* return false if the filter overflows: a tag is lost then, so the caller must drop the filter */
+bool CUCKOO_insert(HASHMAP &map, uint64_t key)
+{
+    uint32_t *filter = CUCKOO_filter(map, map.table);
+    uint8_t tag = CUCKOO_tag(key);
+    uint64_t i = CUCKOO_index(map, key);
+    if(CUCKOO_bucket_put(filter[i], tag) || CUCKOO_bucket_put(filter[CUCKOO_alt_index(map, i, tag)], tag)) return true;
+
+    // evict a tag of a full bucket to its other bucket
+    for(size_t kick = 0; kick < CUCKOO_MAX_KICK; kick++){
+        size_t k = (key >> (2*(kick % 16))) % CUCKOO_BUCKET_SIZE;
+        uint8_t victim = uint8_t(filter[i] >> (8*k));
+        filter[i] = (filter[i] & ~(0xFFU << (8*k))) | (uint32_t(tag) << (8*k));
+        tag = victim;
+        i = CUCKOO_alt_index(map, i, tag);
+        if(CUCKOO_bucket_put(filter[i], tag)) return true;
+    }
+    return false;
+}
+
+/* the bytes of the slot array and the filter */
+inline size_t HASHMAP_len(HASHMAP &map)
+{
+    return map.slot_num*sizeof(HASHMAP_Entry) + map.filter_bucket_num*sizeof(uint32_t);
+}
+
+/* allocate an empty hash table for entry_num entries */
+void HASHMAP_new(HASHMAP &map, uint64_t entry_num, uint32_t mode = HASHMAP_XY_MODE)
+{
+    if(entry_num >= HASHMAP_EMPTY_SLOT)
+    {
+        cout << "hash map supports at most 2^32-1 entries" << endl;
+        exit(EXIT_FAILURE);
+    }
+    map.slot_num = 1;
+    while(map.slot_num < 2*entry_num) map.slot_num <<= 1;
+    map.mask = map.slot_num - 1;
+    map.entry_num = 0;
+
+    map.mapping = NULL;
+    map.mapping_len = 0;
+    map.mode = mode;
+    map.replica_num = 0;
+    CUCKOO_init(map, CUCKOO_bucket_num(entry_num));
+
+    // the filter lives behind the slot array
+    size_t filter_slot_num = (map.filter_bucket_num*sizeof(uint32_t) + sizeof(HASHMAP_Entry) - 1)/sizeof(HASHMAP_Entry);
+    map.table = new HASHMAP_Entry[map.slot_num + filter_slot_num];
+    memset(map.table, 0, (map.slot_num + filter_slot_num)*sizeof(HASHMAP_Entry)); // zero the padding as well, the table is written to disk as is
+    for(uint64_t k = 0; k < map.slot_num; k++) map.table[k].value = HASHMAP_EMPTY_SLOT;
+}
+
+void HASHMAP_free(HASHMAP &map)
+{
+    if(map.mapping != NULL) munmap(map.mapping, map.mapping_len);
+    else if(map.replica_num > 0){
+        // the nodes without a copy of their own share the first one (map.table)
+        size_t table_len = 0;
+        for(auto n = 0; n < HASHMAP_MAX_NODE; n++){
+            if(map.replica[n] != map.table) munmap(map.replica[n], map.replica_len[n]);
+            else table_len = map.replica_len[n];
+        }
+        munmap(map.table, table_len);
+    }
+    else delete[] map.table;
+    map.table = NULL;
+    map.mapping = NULL;
+    map.slot_num = map.mask = map.entry_num = map.mapping_len = 0;
+    map.replica_num = 0;
+    map.filter_bucket_num = 0;
+}
+
+/* the NUMA node of the calling thread, looked up once per thread */
+inline int HASHMAP_thread_node()
+{
+    static thread_local int node = -1;
+    if(node < 0){
+        unsigned cpu = 0, n = 0;
+        #ifdef __linux__
+            if(syscall(SYS_getcpu, &cpu, &n, NULL) != 0) n = 0;
+        #endif
+        node = (n < HASHMAP_MAX_NODE) ? n : 0;
+    }
+    return node;
+}
+
+inline bool HASHMAP_empty(HASHMAP &map)
+{
+    return map.entry_num == 0;
+}
+
+/* the fingerprint: leading 63 bits of the x-coordinate, followed by the parity bit of the y-coordinate */
+inline uint64_t ECP_fingerprint(const unsigned char *buffer)
+{
+    uint64_t fingerprint = 0;
+    for(auto k = 1; k <= 8; k++) fingerprint = (fingerprint << 8) | buffer[k];
+    return (fingerprint << 1) | (buffer[0] & 1);
+}
+
+/* the point at infinity is encoded as all zero bytes (and thus its fingerprint is 0) */
+inline uint64_t ECP_fingerprint(EC_POINT *&A, BN_CTX *ctx)
+{
+    unsigned char buffer[POINT_LEN] = {0};
+    EC_POINT_point2oct(group, A, POINT_CONVERSION_COMPRESSED, buffer, POINT_LEN, ctx);
+    return ECP_fingerprint(buffer);
+}
+
+/*
+    batch version of the above (ctx must not be NULL): normalise all points with one shared inversion
+    (Montgomery's trick), then read the affine coordinates directly.
+    EC_POINT_point2oct would pay a field inversion for every point, even for an affine one.
+*/
+void ECP_batch_fingerprint(EC_POINT **A, size_t num, uint64_t *fingerprint, BN_CTX *ctx)
+{
+    ECP_batch_make_affine(num, A, ctx);
+
+    BN_CTX_start(ctx);
+    BIGNUM *x = BN_CTX_get(ctx);
+    BIGNUM *y = BN_CTX_get(ctx);
+    BIGNUM *z = BN_CTX_get(ctx);
+    unsigned char buffer[POINT_LEN];
+    for(auto k = 0; k < num; k++)
+    {
+        if(EC_POINT_is_at_infinity(group, A[k]))
+        {
+            fingerprint[k] = 0;
+            continue;
+        }
+        ECP_get_Jprojective_coordinates(A[k], x, y, z, ctx); // z = 1 after normalisation
+        buffer[0] = POINT_CONVERSION_COMPRESSED | BN_is_odd(y);
+        BN_bn2binpad(x, buffer+1, BN_LEN);
+        fingerprint[k] = ECP_fingerprint(buffer);
+    }
+    BN_CTX_end(ctx);
+}
+
+/* the fingerprint of a point of the native backend, equal to the one of the same EC_POINT */
+inline uint64_t P256_fingerprint(const P256_AFFINE &A)
+{
+    if(A.infinity) return 0;
+    P256_FE x, y;
+    P256_fe_canonical(x, A.x);
+    P256_fe_canonical(y, A.y);
+    return (x.v[3] << 1) | (y.v[0] & 1); // x.v[3] holds the leading 64 bits of x
+}
+
+/* the additions of a batch on the native backend: result[k] = lhs[k] + rhs[k] */
+struct P256_BATCH
+{
+    vector<P256_AFFINE> result; 
+    vector<const P256_AFFINE *> lhs; 
+    vector<const P256_AFFINE *> rhs; 
+    vector<uint64_t> scratch; 
+};
+
+void P256_BATCH_new(P256_BATCH &batch, size_t capacity)
+{
+    batch.result.resize(capacity); 
+    batch.lhs.resize(capacity); 
+    batch.rhs.resize(capacity); 
+    batch.scratch.resize(P256_batch_add_scratch_size(capacity)); 
+}
+
+/* compute result[k] for k < num with one shared inversion, and the fingerprints of the first fp_num results */
+inline void P256_BATCH_add(P256_BATCH &batch, size_t num, uint64_t *fingerprint, size_t fp_num)
+{
+    P256_batch_add(batch.result.data(), batch.lhs.data(), batch.rhs.data(), num, batch.scratch.data()); 
+    for(auto k = 0; k < fp_num; k++) fingerprint[k] = P256_fingerprint(batch.result[k]); 
+}
+
+/* the key of a fingerprint: the y-parity bit is cleared in x-only mode */
+inline uint64_t HASHMAP_key(HASHMAP &map, uint64_t fingerprint)
+{
+    return (map.mode == HASHMAP_X_MODE) ? (fingerprint & ~1ULL) : fingerprint;
+}
+
+inline void HASHMAP_insert(HASHMAP &map, uint64_t fingerprint, uint32_t value)
+{
+    uint64_t key = HASHMAP_key(map, fingerprint);
+    uint64_t k = key & map.mask;
+    while(map.table[k].value != HASHMAP_EMPTY_SLOT) k = (k + 1) & map.mask;
+    map.table[k].key = key;
+    map.table[k].value = value;
+    map.entry_num++;
+    if(map.filter_bucket_num > 0 && CUCKOO_insert(map, key) == false){
+        cout << "the cuckoo filter overflows, the hash map goes without it" << endl;
+        map.filter_bucket_num = 0;
+    }
+}
+
+const uint64_t HASHMAP_FIRST_SLOT = ~uint64_t(0); // the cursor of HASHMAP_find_next before the first call
+
+/* 
+** iterate over the slots holding the key of fingerprint: start with slot = HASHMAP_FIRST_SLOT, 
+** each call moves slot to the next one and returns its value. two of n baby steps share a 63/64-bit key 
+** with probability about n^2/2^65, which is no longer negligible for n close to 2^32, 
+** so a hit that fails confirmation goes on to the next slot
+*/
+inline bool HASHMAP_find_next(HASHMAP &map, uint64_t fingerprint, uint64_t &slot, uint64_t &value)
+{
+    HASHMAP_Entry *table = (map.replica_num > 1) ? map.replica[HASHMAP_thread_node()] : map.table;
+    uint64_t key = HASHMAP_key(map, fingerprint);
+    uint64_t k; 
+    if(slot == HASHMAP_FIRST_SLOT){
+        if(map.filter_bucket_num > 0 && CUCKOO_contains(map, table, key) == false) return false;
+        k = key & map.mask;
+    }
+    else k = (slot + 1) & map.mask; 
+    while(table[k].value != HASHMAP_EMPTY_SLOT)
+    {
+        if(table[k].key == key)
+        {
+            value = table[k].value;
+            slot = k; 
+            return true;
+        }
+        k = (k + 1) & map.mask;
+    }
+    return false;
+}
+
+/* return the value of the first slot holding key */
+inline bool HASHMAP_find(HASHMAP &map, uint64_t fingerprint, uint64_t &value)
+{
+    uint64_t slot = HASHMAP_FIRST_SLOT; 
+    return HASHMAP_find_next(map, fingerprint, slot, value);
+}
+
+/*
+    The probes of a batch are independent, so the buckets are requested ahead of time: while fingerprint[k] 
+    is probed, the buckets of the next prefetch_window fingerprints are already on their way from memory, 
+    and up to prefetch_window + 1 table misses overlap instead of stalling the core one after another
+*/
+size_t prefetch_window = 16; // tunable, 0 disables prefetching
+
+inline void HASHMAP_prefetch(HASHMAP &map, uint64_t fingerprint)
+{
+    HASHMAP_Entry *table = (map.replica_num > 1) ? map.replica[HASHMAP_thread_node()] : map.table;
+    uint64_t key = HASHMAP_key(map, fingerprint);
+    if(map.filter_bucket_num == 0){
+        __builtin_prefetch(&table[key & map.mask], 0, 0);
+        return;
+    }
+    // the probe reads the two buckets of the filter, the slot array only for the few keys that pass
+    uint32_t *filter = CUCKOO_filter(map, table);
+    uint64_t i1 = CUCKOO_index(map, key);
+    __builtin_prefetch(&filter[i1], 0, 1);
+    __builtin_prefetch(&filter[CUCKOO_alt_index(map, i1, CUCKOO_tag(key))], 0, 1);
+}
+
+/* call before probing fingerprint[k] of a batch of num fingerprints */
+inline void HASHMAP_prefetch_ahead(HASHMAP &map, const uint64_t *fingerprint, size_t k, size_t num)
+{
+    if(prefetch_window == 0) return;
+    if(k == 0){
+        for(size_t l = 0; l <= prefetch_window && l < num; l++) HASHMAP_prefetch(map, fingerprint[l]);
+    }
+    else if(k + prefetch_window < num) HASHMAP_prefetch(map, fingerprint[k + prefetch_window]);
+}
+
+/* 
+** check ECP_babystep = g^i against A to rule out a false hit caused by the truncated fingerprint; in x-only mode 
+** g^i = -A is a hit too (ECP_babystep is negated then). return the sign s with g^i = s*A, or 0 for a false hit
+*/
+inline int HASHMAP_verify(EC_POINT *ECP_babystep, EC_POINT *&A, BN_CTX *ctx)
+{
+    if(EC_POINT_cmp(group, ECP_babystep, A, ctx) == 0) return 1;
+    if(point2index_map.mode == HASHMAP_X_MODE)
+    {
+        EC_POINT_invert(group, ECP_babystep, ctx);
+        if(EC_POINT_cmp(group, ECP_babystep, A, ctx) == 0) return -1;
+    }
+    return 0;
+}
+
+/*
+    The small tier: a compact table of g^i for i < SMALL_TABLE_SIZE that fits in the L2 cache.
+    Decryption looks h up here before the main table, so a message of small |m| is found
+    without a single DRAM miss. A slot keeps the upper 32 bits of the fingerprint (x-coordinate only,
+    so the slot of g^i serves g^{-i} as well) and i, a hit is confirmed with a fixed-base table of g.
+    The tier is built in memory by Initialize and answers for any interval, since it tests h itself.
+*/
+const uint64_t SMALL_TABLE_SIZE = 1 << 16; // 2^17 slots of 8 bytes (1 MB)
+
+struct SMALL_HASHMAP_Entry
+{
+    uint32_t key;   // upper 32 bits of the fingerprint of g^i
+    uint32_t value; // i
+};
+
+struct SMALL_HASHMAP
+{
+    vector<SMALL_HASHMAP_Entry> table;
+    uint64_t mask;       // slot_num - 1
+    uint64_t entry_num;  // 0 if the tier is not built
+    EC_POINT *base;      // g
+    ECP_Precompute_Table base_table; // g^i in a few additions
+};
+
+SMALL_HASHMAP small_map = {vector<SMALL_HASHMAP_Entry>(), 0, 0, NULL}; 
+
+void SMALL_HASHMAP_free()
+{
+    if(small_map.base == NULL) return; 
+    small_map.table.clear(); 
+    small_map.mask = 0; 
+    small_map.entry_num = 0; 
+    EC_POINT_free(small_map.base); 
+    small_map.base = NULL; 
+    ECP_Precompute_Table_free(small_map.base_table); 
+}
+
+/* build the tier for g^i with i < SMALL_SIZE (SMALL_SIZE = 0 disables it) */
+void SMALL_HASHMAP_build(EC_POINT *&g, uint64_t SMALL_SIZE = SMALL_TABLE_SIZE)
+{
+    SMALL_HASHMAP_free(); 
+    if(SMALL_SIZE == 0) return; 
+
+    uint64_t slot_num = 1; 
+    while(slot_num < 2*SMALL_SIZE) slot_num <<= 1; 
+    SMALL_HASHMAP_Entry empty_slot = {0, HASHMAP_EMPTY_SLOT}; 
+    small_map.table.assign(slot_num, empty_slot); 
+    small_map.mask = slot_num - 1; 
+
+    // walk g^i and fingerprint the points a batch at a time
+    const size_t BATCH_SIZE = 1024; 
+    vector<EC_POINT *> A(BATCH_SIZE); 
+    vector<uint64_t> fingerprint(BATCH_SIZE); 
+    for(auto k = 0; k < BATCH_SIZE; k++) A[k] = EC_POINT_new(group); 
+    EC_POINT *walk = EC_POINT_new(group); 
+    EC_POINT_set_to_infinity(group, walk); 
+    for(uint64_t base = 0; base < SMALL_SIZE; base += BATCH_SIZE)
+    {
+        size_t batch_size = min<uint64_t>(BATCH_SIZE, SMALL_SIZE - base); 
+        for(auto k = 0; k < batch_size; k++){
+            EC_POINT_copy(A[k], walk); 
+            EC_POINT_add(group, walk, walk, g, bn_ctx); 
+        }
+        ECP_batch_fingerprint(A.data(), batch_size, fingerprint.data(), bn_ctx); 
+        for(auto k = 0; k < batch_size; k++){
+            uint32_t key = uint32_t(fingerprint[k] >> 32); 
+            uint64_t slot = key & small_map.mask; 
+            while(small_map.table[slot].value != HASHMAP_EMPTY_SLOT) slot = (slot + 1) & small_map.mask; 
+            small_map.table[slot].key = key; 
+            small_map.table[slot].value = uint32_t(base + k); 
+        }
+    }
+    for(auto k = 0; k < BATCH_SIZE; k++) EC_POINT_free(A[k]); 
+    EC_POINT_free(walk); 
+
+    small_map.entry_num = SMALL_SIZE; 
+    small_map.base = EC_POINT_dup(g, group); 
+    size_t small_len = 1; // the bit length of i < SMALL_SIZE
+    while(small_len < 32 && (uint64_t(1) << small_len) < SMALL_SIZE) small_len++;
+    ECP_Precompute_Table_new(small_map.base_table, DEFAULT_WINDOW_SIZE, small_len); 
+    ECP_Precompute_Table_build(small_map.base_table, g); 
+}
+
+/* look up h = g^x with |x| < SMALL_SIZE in the tier: return false if it is not there (or the tier serves another base) */
+bool SMALL_HASHMAP_find(EC_POINT *&g, EC_POINT *&h, int64_t &x, BN_CTX *ctx)
+{
+    if(small_map.entry_num == 0 || EC_POINT_cmp(group, g, small_map.base, ctx) != 0) return false; 
+
+    uint32_t key = uint32_t(ECP_fingerprint(h, ctx) >> 32); 
+    EC_POINT *ECP_babystep = THREAD_POOL_context()->scratch[3]; 
+    for(uint64_t slot = key & small_map.mask; small_map.table[slot].value != HASHMAP_EMPTY_SLOT; 
+        slot = (slot + 1) & small_map.mask)
+    {
+        if(small_map.table[slot].key != key) continue; 
+        // the 32-bit key may collide: confirm g^i = h or g^i = -h
+        uint32_t i = small_map.table[slot].value; 
+        ECP_Precompute_Table_mul(small_map.base_table, ECP_babystep, uint64_t(i), ctx); 
+        if(EC_POINT_cmp(group, ECP_babystep, h, ctx) == 0){
+            x = i; 
+            return true; 
+        }
+        EC_POINT_invert(group, ECP_babystep, ctx); 
+        if(EC_POINT_cmp(group, ECP_babystep, h, ctx) == 0){
+            x = -int64_t(i); 
+            return true; 
+        }
+    }
+    return false; 
+}
+
+/*
+    layout of the hashmap file (native byte order):
+    [HASHMAP_Header: 128 bytes][slot_num HASHMAP_Entry slots][filter_bucket_num uint32_t buckets of the cuckoo filter]
+*/
+const char HASHMAP_MAGIC[8] = {'P', 'G', 'C', 'D', 'L', 'O', 'G', '\0'};
+const uint32_t HASHMAP_VERSION = 4; // version 2 adds the key mode, version 3 keys the table on its size, version 4 adds the filter
+
+struct HASHMAP_Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t curve_id;  // NID of the elliptic curve
+    uint32_t mode;      // HASHMAP_XY_MODE or HASHMAP_X_MODE
+    uint32_t padding;
+    uint64_t table_size; // the number of baby steps
+    uint64_t entry_num;
+    uint64_t slot_num;
+    uint64_t checksum;  // checksum of the header (with checksum = 0) followed by the slot array and the filter
+    uint64_t filter_bucket_num; // the buckets of the cuckoo filter (0: no filter)
+    unsigned char base_point[POINT_LEN]; // compressed g
+    unsigned char reserved[128 - 64 - POINT_LEN];
+};
+
+static_assert(sizeof(HASHMAP_Header) == 128, "the header of hashmap file must be 128 bytes");
+
+void HASHMAP_Header_new(HASHMAP_Header &header, EC_POINT *&g, uint64_t table_size, uint32_t mode,
+                        uint64_t entry_num, uint64_t slot_num)
+{
+    memset(&header, 0, sizeof(HASHMAP_Header));
+    memcpy(header.magic, HASHMAP_MAGIC, sizeof(HASHMAP_MAGIC));
+    header.version = HASHMAP_VERSION;
+    header.curve_id = EC_GROUP_get_curve_name(group);
+    header.mode = mode;
+    header.table_size = table_size;
+    header.entry_num = entry_num;
+    header.slot_num = slot_num;
+    EC_POINT_point2oct(group, g, POINT_CONVERSION_COMPRESSED, header.base_point, POINT_LEN, bn_ctx);
+}
+
+/* FNV-1a style checksum over 8-byte words (a trailing partial word is padded with zeros) */
+inline uint64_t HASHMAP_checksum(uint64_t checksum, const unsigned char *data, size_t len)
+{
+    uint64_t word;
+    for(size_t k = 0; k < len; k += 8)
+    {
+        word = 0;
+        memcpy(&word, data+k, min<size_t>(8, len-k));
+        checksum = (checksum ^ word) * 0x100000001b3ULL;
+    }
+    return checksum;
+}
+
+inline uint64_t HASHMAP_checksum(HASHMAP_Header header, HASHMAP &map)
+{
+    header.checksum = 0;
+    uint64_t checksum = HASHMAP_checksum(0xcbf29ce484222325ULL, reinterpret_cast<unsigned char *>(&header),
+                                         sizeof(HASHMAP_Header));
+    return HASHMAP_checksum(checksum, reinterpret_cast<unsigned char *>(map.table), HASHMAP_len(map));
+}
+
+/* write the table to hashmap_file: write to a temporary file first, so processes mapping an old file are not affected */
+void HASHMAP_write(HASHMAP &map, HASHMAP_Header &header, string hashmap_file)
+{
+    header.filter_bucket_num = map.filter_bucket_num;
+    header.checksum = HASHMAP_checksum(header, map);
+
+    string temp_file = hashmap_file + ".tmp";
+    ofstream fout;
+    fout.open(temp_file, ios::binary);
+    if(!fout)
+    {
+        cout << temp_file << " open error" << endl;
+        exit(EXIT_FAILURE);
+    }
+    fout.write(reinterpret_cast<char *>(&header), sizeof(HASHMAP_Header));
+    fout.write(reinterpret_cast<char *>(map.table), HASHMAP_len(map));
+    fout.close();
+    if(!fout || rename(temp_file.c_str(), hashmap_file.c_str()) != 0)
+    {
+        cout << hashmap_file << " write error" << endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+void HASHMAP_write(HASHMAP &map, EC_POINT *&g, string hashmap_file, uint64_t TABLE_SIZE)
+{
+    HASHMAP_Header header;
+    HASHMAP_Header_new(header, g, TABLE_SIZE, map.mode, map.entry_num, map.slot_num);
+    HASHMAP_write(map, header, hashmap_file);
+}
+
+/*
+    Note that OpenSSL does not provide substract operation for EC points, 
+    we have to implement substract operation by combining add operation and invert operation. 
+    This means substract operation is more expensive than add operation. 
+    When implementing Shanks algorithm, a repeated operation is "searchpoint = searchpoint - giantstep". 
+    To be more efficient, we set giantstep = - giantstep, than do the above update as "searchpoint = searchpoint + giantstep"   
+*/
+
+/*
+    serialize task (parallelizable): compute the fingerprints of startpoint + i*g for i in [0, length)
+    the points are generated BATCH_SIZE at a time and normalised together, so a chunk costs one field inversion
+*/
+const size_t BATCH_SIZE = 1024;
+
+void ECP_vector_serialize(EC_POINT *&g, EC_POINT *&ECP_startpoint, uint64_t &startindex,
+                          uint64_t &length, uint64_t* fingerprint)
+{
+    BN_CTX *ctx = THREAD_POOL_context()->bn_ctx; // a BN_CTX must only be used by a single thread
+
+    // native backend: the chunk is startpoint + k*g for the precomputed multiples k*g, k <= BATCH_SIZE
+    if(group_backend == GROUP_P256_NATIVE)
+    {
+        vector<P256_AFFINE> multiple; 
+        P256_multiples(multiple, g, BATCH_SIZE, ctx); 
+        P256_BATCH batch; 
+        P256_BATCH_new(batch, BATCH_SIZE+1); 
+        P256_AFFINE startpoint; 
+        P256_from_EC_POINT(startpoint, ECP_startpoint, ctx); 
+        for(uint64_t start = 0; start < length; start += BATCH_SIZE)
+        {
+            size_t batch_num = min<uint64_t>(BATCH_SIZE, length - start);
+            for(auto k = 0; k <= batch_num; k++){
+                batch.lhs[k] = &startpoint; 
+                batch.rhs[k] = &multiple[k]; 
+            }
+            P256_BATCH_add(batch, batch_num+1, fingerprint+startindex+start, batch_num); 
+            startpoint = batch.result[batch_num]; // start point of the next chunk
+        }
+        P256_to_EC_POINT(ECP_startpoint, startpoint, ctx); 
+        return; 
+    }
+
+    vector<EC_POINT *> ECP_batch(BATCH_SIZE);
+    for(auto k = 0; k < BATCH_SIZE; k++) ECP_batch[k] = EC_POINT_new(group);
+
+    for(uint64_t start = 0; start < length; start += BATCH_SIZE)
+    {
+        size_t batch_num = min<uint64_t>(BATCH_SIZE, length - start);
+        EC_POINT_copy(ECP_batch[0], ECP_startpoint);
+        for(auto k = 1; k < batch_num; k++)
+        {
+            EC_POINT_add(group, ECP_batch[k], ECP_batch[k-1], g, ctx);
+        }
+        EC_POINT_add(group, ECP_startpoint, ECP_batch[batch_num-1], g, ctx); // start point of the next chunk
+        ECP_batch_fingerprint(ECP_batch.data(), batch_num, fingerprint+startindex+start, ctx);
+    }
+
+    for(auto k = 0; k < BATCH_SIZE; k++) EC_POINT_free(ECP_batch[k]);
+}
+
+/* the number of baby steps for the parameters (RANGE_LEN, TUNNING) */
+inline uint64_t Shanks_table_size(size_t RANGE_LEN, size_t TUNNING)
+{
+    return uint64_t(1) << (RANGE_LEN/2 + TUNNING); 
+}
+
+/* the table keeps g^i for i < TABLE_SIZE, and g^TABLE_SIZE as well in x-only mode */
+inline uint64_t HASHMAP_entry_num(uint64_t TABLE_SIZE, uint32_t mode)
+{
+    if(TABLE_SIZE == 0 || TABLE_SIZE >= HASHMAP_EMPTY_SLOT)
+    {
+        cout << "the table size must lie in [1, 2^32 - 1)" << endl; 
+        exit(EXIT_FAILURE); 
+    }
+    return TABLE_SIZE + (mode == HASHMAP_X_MODE); 
+}
+
+/* build the hash map: g^i for i < TABLE_SIZE (i <= TABLE_SIZE in x-only mode) */
+void HASHMAP_serialize(EC_POINT *&g, string hashmap_file, uint64_t TABLE_SIZE, uint32_t mode = HASHMAP_XY_MODE)
+{
+    cout << "hash map does not exist, begin to build and serialize >>>" << endl; 
+
+    auto start_time = chrono::steady_clock::now(); // start to count the time
+    uint64_t entry_num = HASHMAP_entry_num(TABLE_SIZE, mode); 
+    EC_POINT *ECP_babystep = EC_POINT_new(group);
+    EC_POINT_set_to_infinity(group, ECP_babystep); // set babystep = 0
+
+    uint64_t *fingerprint = new uint64_t[entry_num]();
+    if(fingerprint == NULL)
+    {
+        cout << "fail to create buffer" << endl;
+        exit(EXIT_FAILURE);
+    }
+    // compute the fingerprints of g^i
+    uint64_t startindex = 0;
+    ECP_vector_serialize(g, ECP_babystep, startindex, entry_num, fingerprint);
+
+    // insert the fingerprints into the table
+    HASHMAP map;
+    HASHMAP_new(map, entry_num, mode);
+    for(uint64_t i = 0; i < entry_num; i++) HASHMAP_insert(map, fingerprint[i], i);
+    delete[] fingerprint;
+
+    // serialize the table to hashmap_file
+    HASHMAP_write(map, g, hashmap_file, TABLE_SIZE);
+    HASHMAP_free(map);
+        
+    auto end_time = chrono::steady_clock::now(); // end to count the time
+    auto running_time = end_time - start_time;
+    cout << "hash map building and serializing takes time = " 
+        << chrono::duration <double, milli> (running_time).count() << " ms" << endl;
+    
+    EC_POINT_free(ECP_babystep); 
+}
+
+/* 
+    map hashmap file into map: the table is used in place without rebuilding
+    return false if the file is missing or its header does not match expected_header (group, base point, table size, key mode)
+    the checksum is only verified on demand, since every hit is confirmed by recomputing g^i anyway
+*/
+bool HASHMAP_map(HASHMAP &map, string hashmap_file, HASHMAP_Header &expected_header, bool VERIFY_CHECKSUM = false)
+{   
+    cout << "hash map already exists, begin to map it into memory >>>" << endl; 
+
+    auto start_time = chrono::steady_clock::now(); // start to count the time
+
+    int fd = open(hashmap_file.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        cout << hashmap_file << " read error" << endl;
+        return false; 
+    }
+    struct stat file_stat; 
+    if(fstat(fd, &file_stat) != 0 || file_stat.st_size < sizeof(HASHMAP_Header))
+    {
+        cout << hashmap_file << " is truncated" << endl;
+        close(fd); 
+        return false; 
+    }
+    size_t FILE_LEN = file_stat.st_size; // get the size of hash table file
+    unsigned char *mapping = reinterpret_cast<unsigned char *>(mmap(NULL, FILE_LEN, PROT_READ, MAP_SHARED, fd, 0)); 
+    close(fd); 
+    if(mapping == MAP_FAILED)
+    {
+        cout << hashmap_file << " mmap error" << endl;
+        return false; 
+    }
+
+    // check the header against the parameters
+    HASHMAP_Header header;
+    memcpy(&header, mapping, sizeof(HASHMAP_Header));
+    if(memcmp(header.magic, expected_header.magic, sizeof(HASHMAP_MAGIC)) != 0 
+       || header.version != expected_header.version || header.curve_id != expected_header.curve_id 
+       || header.table_size != expected_header.table_size || header.mode != expected_header.mode 
+       || header.entry_num != expected_header.entry_num 
+       || memcmp(header.base_point, expected_header.base_point, POINT_LEN) != 0 
+       || header.slot_num == 0 || (header.slot_num & (header.slot_num - 1)) != 0 
+       || header.filter_bucket_num >= (uint64_t(1) << 32) 
+       || FILE_LEN != sizeof(HASHMAP_Header) + header.slot_num*sizeof(HASHMAP_Entry) + header.filter_bucket_num*sizeof(uint32_t))
+    {
+        cout << hashmap_file << " does not match the public parameters" << endl; 
+        munmap(mapping, FILE_LEN); 
+        return false; 
+    }
+    madvise(mapping, FILE_LEN, MADV_WILLNEED); // start paging in the table asynchronously
+
+    HASHMAP_free(map);
+    map.table = reinterpret_cast<HASHMAP_Entry *>(mapping + sizeof(HASHMAP_Header));
+    map.slot_num = header.slot_num;
+    map.mask = header.slot_num - 1;
+    map.entry_num = header.entry_num;
+    map.mapping = mapping;
+    map.mapping_len = FILE_LEN;
+    map.mode = header.mode;
+    CUCKOO_init(map, header.filter_bucket_num);
+
+    if(VERIFY_CHECKSUM == true && HASHMAP_checksum(header, map) != header.checksum)
+    {
+        cout << hashmap_file << " checksum error" << endl; 
+        HASHMAP_free(map); 
+        return false; 
+    }
+    
+    auto end_time = chrono::steady_clock::now(); // end to count the time
+    auto running_time = end_time - start_time;
+    cout << "hash map mapping takes time = " 
+    << chrono::duration <double, milli> (running_time).count() << " ms" << endl;
+    return true; 
+} 
+
+bool HASHMAP_deserialize(EC_POINT *&g, string hashmap_file, uint64_t TABLE_SIZE, 
+                         uint32_t mode = HASHMAP_XY_MODE, bool VERIFY_CHECKSUM = false)
+{
+    HASHMAP_Header expected_header;
+    HASHMAP_Header_new(expected_header, g, TABLE_SIZE, mode, HASHMAP_entry_num(TABLE_SIZE, mode), 0);
+    return HASHMAP_map(point2index_map, hashmap_file, expected_header, VERIFY_CHECKSUM);
+}
+
+/*
+    Placement of the mapped table. With 4 KB pages every probe of a table of hundreds of MB is a TLB miss as well,
+    and on a multi-socket host half of the probes cross the interconnect. HASHMAP_place copies the table
+    into anonymous memory backed by huge pages: hugetlbfs pages (1 GB for large tables, else 2 MB) if the host
+    reserved them, otherwise transparent huge pages on a 2 MB aligned region. HASHMAP_NUMA_REPLICA binds one copy
+    to each node and the threads probe the copy of their node, HASHMAP_NUMA_INTERLEAVE spreads a single copy
+    over all nodes. The copies are private to the process, unlike the shared page cache of the mapped file.
+*/
+#ifdef __linux__
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+/* the online NUMA nodes below HASHMAP_MAX_NODE (node 0 if the host does not tell) */
+void HASHMAP_numa_nodes(vector<int> &node)
+{
+    node.clear();
+    ifstream fin("/sys/devices/system/node/online");
+    string range;
+    // the list looks like "0-1,3"
+    while(fin && getline(fin, range, ',')){
+        int first, last;
+        char dash;
+        stringstream ss(range);
+        if(!(ss >> first)) continue;
+        last = (ss >> dash >> last) ? last : first;
+        for(auto n = first; n <= last && n < HASHMAP_MAX_NODE; n++) node.push_back(n);
+    }
+    if(node.empty()) node.push_back(0);
+}
+
+/* anonymous memory for len bytes (len is rounded up to the page size): pages describes the backing */
+unsigned char* HASHMAP_huge_alloc(size_t &len, bool HUGETLB, string &pages)
+{
+    const size_t HUGE_PAGE_SIZE = size_t(1) << 21;
+    if(HUGETLB == true){
+        const int page_shift[2] = {30, 21};
+        for(auto k = 0; k < 2; k++){
+            size_t page_size = size_t(1) << page_shift[k];
+            if(page_shift[k] == 30 && len < page_size/2) continue; // most of a 1 GB page would be wasted
+            size_t aligned_len = (len + page_size - 1) & ~(page_size - 1);
+            void *p = mmap(NULL, aligned_len, PROT_READ | PROT_WRITE, 
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (page_shift[k] << MAP_HUGE_SHIFT), -1, 0);
+            if(p != MAP_FAILED){
+                len = aligned_len;
+                pages = (page_shift[k] == 30) ? "1 GB hugetlbfs pages" : "2 MB hugetlbfs pages";
+                return reinterpret_cast<unsigned char *>(p);
+            }
+        }
+    }
+
+    // transparent huge pages: trim an over-sized mapping to a 2 MB aligned region
+    size_t aligned_len = (len + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    void *p = mmap(NULL, aligned_len + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(p == MAP_FAILED) return NULL;
+    unsigned char *region = reinterpret_cast<unsigned char *>(p);
+    size_t head = (HUGE_PAGE_SIZE - (reinterpret_cast<uintptr_t>(region) & (HUGE_PAGE_SIZE - 1))) & (HUGE_PAGE_SIZE - 1);
+    if(head > 0) munmap(region, head);
+    munmap(region + head + aligned_len, HUGE_PAGE_SIZE - head);
+    region += head;
+    pages = (madvise(region, aligned_len, MADV_HUGEPAGE) == 0) ? "transparent huge pages" : "4 KB pages";
+    len = aligned_len;
+    return region;
+}
+
+#endif
+
+/* 
+** move the mapped table to anonymous huge-page memory by placement (see above): return false 
+** if the placement is not available, the table then stays mapped
+*/
+bool HASHMAP_place(HASHMAP &map, int placement)
+{
+    if(placement == HASHMAP_MAPPED) return true;
+#ifndef __linux__
+    cout << "the placement of hash map is not supported on this platform, the table stays mapped" << endl;
+    return false;
+#else
+    if(map.mapping == NULL || map.replica_num > 0) return false; // only the mapped table is moved
+
+    vector<int> node;
+    HASHMAP_numa_nodes(node);
+    unsigned long all_nodes = 0;
+    for(auto k = 0; k < node.size(); k++) all_nodes |= 1UL << node[k];
+    // bound and interleaved memory stay away from hugetlbfs: a fault on a node without free pages kills the process
+    bool HUGETLB = (placement == HASHMAP_HUGEPAGE);
+    size_t copy_num = (placement == HASHMAP_NUMA_REPLICA) ? node.size() : 1;
+
+    size_t table_len = HASHMAP_len(map); // the filter is copied along
+    string pages;
+    vector<pair<HASHMAP_Entry *, size_t>> copy; // every copy with its mapped length (rounded up to its pages)
+    for(auto k = 0; k < copy_num; k++)
+    {
+        size_t len = table_len;
+        unsigned char *region = HASHMAP_huge_alloc(len, HUGETLB, pages);
+        if(region == NULL){
+            cout << "fail to allocate the copies of hash map, the table stays mapped" << endl;
+            for(auto i = 0; i < copy.size(); i++) munmap(copy[i].first, copy[i].second);
+            return false;
+        }
+        // the policy applies to the pages touched from now on, i.e. by the copy below
+        unsigned long nodemask = (placement == HASHMAP_NUMA_REPLICA) ? (1UL << node[k]) : all_nodes;
+        if(placement == HASHMAP_NUMA_REPLICA)
+            syscall(SYS_mbind, region, len, MPOL_BIND, &nodemask, 8*sizeof(nodemask), 0);
+        if(placement == HASHMAP_NUMA_INTERLEAVE && node.size() > 1)
+            syscall(SYS_mbind, region, len, MPOL_INTERLEAVE, &nodemask, 8*sizeof(nodemask), 0);
+        memcpy(region, map.table, table_len);
+        mprotect(region, len, PROT_READ);
+        copy.push_back(make_pair(reinterpret_cast<HASHMAP_Entry *>(region), len));
+    }
+
+    munmap(map.mapping, map.mapping_len);
+    map.mapping = NULL;
+    map.mapping_len = 0;
+    map.table = copy[0].first;
+    for(auto n = 0; n < HASHMAP_MAX_NODE; n++){
+        map.replica[n] = copy[0].first;
+        map.replica_len[n] = copy[0].second;
+    }
+    for(auto k = 1; k < copy_num; k++){
+        map.replica[node[k]] = copy[k].first;
+        map.replica_len[node[k]] = copy[k].second;
+    }
+    map.replica_num = copy_num;
+
+    cout << "hash map is placed on " << pages << ": " << copy_num << ((copy_num > 1) ? " copies" : " copy") 
+         << " for " << node.size() << " NUMA node(s)" << endl;
+    return true;
+#endif
+}
+
+/*
+** the giant steps of the search with the mapped table: the candidates are h - (lo + j*giantstep_stride)*g for j < loop_num,
+** a confirmed hit g^i = s*candidate (s = +-1) gives x = lo + j*giantstep_stride + s*i, which must lie in [lo, hi).
+** in x-only mode the stride is twice the number of baby steps and the loop is half as long
+*/
+struct SHANKS_LAYOUT
+{
+    int64_t lo;
+    uint64_t giantstep_stride; 
+    uint64_t loop_num; 
+    uint64_t range_size; // hi - lo
+};
+
+/* the giant step of the mapped table with TABLE_SIZE baby steps */
+inline uint64_t Shanks_stride(uint64_t TABLE_SIZE)
+{
+    return (point2index_map.mode == HASHMAP_X_MODE) ? 2*TABLE_SIZE : TABLE_SIZE;
+}
+
+/* the layout of a search over the sub-range [0, range_size) of the table range */
+SHANKS_LAYOUT Shanks_sublayout(SHANKS_LAYOUT layout, uint64_t range_size)
+{
+    layout.range_size = range_size; 
+    if(point2index_map.mode == HASHMAP_X_MODE){
+        // giant step j covers [j*stride - stride/2, j*stride + stride/2]
+        uint64_t half_stride = layout.giantstep_stride/2; 
+        layout.loop_num = (range_size > half_stride + 1) ? 
+                          (range_size - half_stride - 2)/layout.giantstep_stride + 2 : 1; 
+    }
+    else{
+        layout.loop_num = (range_size - 1)/layout.giantstep_stride + 1;
+    }
+    return layout; 
+}
+
+/* the layout of the search over [lo, hi): the giant steps just cover the interval, whatever its size */
+SHANKS_LAYOUT Shanks_layout(int64_t lo, int64_t hi, uint64_t TABLE_SIZE)
+{
+    if(hi <= lo || TABLE_SIZE == 0)
+    {
+        cout << "the DLOG interval [" << lo << ", " << hi << ") or the table size " << TABLE_SIZE << " is invalid" << endl;
+        exit(EXIT_FAILURE); 
+    }
+    SHANKS_LAYOUT layout; 
+    layout.lo = lo;
+    layout.giantstep_stride = Shanks_stride(TABLE_SIZE);
+    return Shanks_sublayout(layout, uint64_t(hi) - uint64_t(lo));
+}
+
+/* x = value in BIGNUM */
+inline void Shanks_result(BIGNUM *&x, int64_t value)
+{
+    BN_set_word(x, (value < 0) ? -uint64_t(value) : uint64_t(value));
+    BN_set_negative(x, value < 0);
+}
+
+/* target = h - lo*g: the search over [0, hi - lo) for target gives x - lo */
+void Shanks_shift(EC_POINT *target, EC_POINT *&g, EC_POINT *&h, int64_t lo, BN_CTX *ctx)
+{
+    BN_CTX_start(ctx); 
+    BIGNUM *BN_lo = BN_CTX_get(ctx);
+    Shanks_result(BN_lo, lo);
+    EC_POINT_mul(group, target, NULL, g, BN_lo, ctx);
+    EC_POINT_invert(group, target, ctx);
+    EC_POINT_add(group, target, target, h, ctx);
+    BN_CTX_end(ctx); 
+}
+
+/*
+** giant-step ladder: giantstep_ladder[j] = -j*giantstep_stride*g in affine form for all j < loop_num; 
+** it is optional (built once per table), with it every candidate h - j*giantstep_stride*g of the search 
+** is formed independently of the previous one
+*/
+vector<EC_POINT *> giantstep_ladder; 
+vector<P256_AFFINE> p256_ladder; // the same points for the native backend
+
+/*
+** g^i for i < giantstep_stride: together with the ladder it encodes g^x for x < loop_num*giantstep_stride
+** in a few additions, as g^x = g^i - giantstep_ladder[j] for x = i + j*giantstep_stride
+*/
+ECP_Precompute_Table babystep_table; 
+uint64_t encode_giantstep_size = 0; 
+
+const uint64_t LADDER_MAX_SIZE = 1 << 20; // do not build ladders larger than this 
+const size_t SEARCH_BATCH_SIZE = 64; // the maximum number of candidates normalised at once during search
+
+void GIANTSTEP_LADDER_free()
+{
+    for(auto i = 0; i < giantstep_ladder.size(); i++){
+        EC_POINT_free(giantstep_ladder[i]); 
+    }
+    giantstep_ladder.clear(); 
+    vector<P256_AFFINE>().swap(p256_ladder); 
+    ECP_Precompute_Table_free(babystep_table); 
+    encode_giantstep_size = 0; 
+}
+
+/* build the ladder for the search over [lo, hi) with the mapped table */
+void GIANTSTEP_LADDER_build(EC_POINT *&g, int64_t lo, int64_t hi, uint64_t TABLE_SIZE)
+{
+    GIANTSTEP_LADDER_free(); 
+
+    SHANKS_LAYOUT layout = Shanks_layout(lo, hi, TABLE_SIZE);
+
+    // the baby steps confirm the table hits of the search even without the ladder
+    size_t stride_len = 1; // the bit length of i < giantstep_stride
+    while(stride_len < 64 && (uint64_t(1) << stride_len) < layout.giantstep_stride) stride_len++;
+    ECP_Precompute_Table_new(babystep_table, DEFAULT_WINDOW_SIZE, stride_len); 
+    ECP_Precompute_Table_build(babystep_table, g); 
+    encode_giantstep_size = layout.giantstep_stride; 
+
+    uint64_t loop_num = layout.loop_num; 
+    if(loop_num > LADDER_MAX_SIZE) return; // the search falls back to serial giant steps
+
+    EC_POINT* ECP_giantstep = EC_POINT_new(group); 
+    BIGNUM* BN_giantstep_stride = BN_new(); 
+    BN_set_word(BN_giantstep_stride, layout.giantstep_stride);
+    EC_POINT_mul(group, ECP_giantstep, NULL, g, BN_giantstep_stride, bn_ctx); 
+    EC_POINT_invert(group, ECP_giantstep, bn_ctx);
+
+    giantstep_ladder.resize(loop_num); 
+    giantstep_ladder[0] = EC_POINT_new(group); 
+    EC_POINT_set_to_infinity(group, giantstep_ladder[0]); 
+    for(auto j = 1; j < loop_num; j++){
+        giantstep_ladder[j] = EC_POINT_new(group); 
+        EC_POINT_add(group, giantstep_ladder[j], giantstep_ladder[j-1], ECP_giantstep, bn_ctx); 
+    }
+    ECP_batch_make_affine(loop_num, giantstep_ladder.data(), bn_ctx); 
+    if(group_backend == GROUP_P256_NATIVE) P256_multiples(p256_ladder, ECP_giantstep, loop_num-1, bn_ctx); 
+
+    EC_POINT_free(ECP_giantstep); 
+    BN_free(BN_giantstep_stride); 
+}
+
+/* result = g^x for the base g of the ladder: return false if the ladder is not built or x is out of range */
+bool DLOG_encode(EC_POINT *result, uint64_t x, BN_CTX *ctx)
+{
+    if(encode_giantstep_size == 0) return false; 
+    uint64_t i = x % encode_giantstep_size; 
+    uint64_t j = x / encode_giantstep_size; 
+    if(j >= giantstep_ladder.size()) return false; 
+
+    ECP_Precompute_Table_mul(babystep_table, result, i, ctx); // result = g^i
+    if(j > 0){
+        EC_POINT_invert(group, result, ctx); 
+        EC_POINT_add(group, result, result, giantstep_ladder[j], ctx); 
+        EC_POINT_invert(group, result, ctx); // result = g^i + j*giantstep_stride*g
+    }
+    return true; 
+}
+
+/* scratch state of the search: it is owned by the caller, so that repeated searches do not allocate */
+struct SHANKS_CONTEXT
+{
+    EC_POINT *candidate[SEARCH_BATCH_SIZE]; 
+    EC_POINT *searchpoint; 
+    EC_POINT *shifted_target;      // h - lo*g for the search from lo
+    EC_POINT *negated_target;      // -h for the signed search
+    EC_POINT *negated_searchpoint; 
+    EC_POINT *babystep;            // g^i of a table hit
+    BIGNUM *BN_babystep;           // i, if g^i is not served by the baby-step table
+    BN_CTX *ctx; // borrowed, it must belong to the thread that runs the search
+
+    // native backend: the target of either side (with the ladder) or its searchpoint, and k*giantstep for the walk
+    P256_AFFINE p256_searchpoint[2]; 
+    vector<P256_AFFINE> p256_step; 
+    P256_BATCH p256; 
+};
+
+void SHANKS_CONTEXT_new(SHANKS_CONTEXT &sc, BN_CTX *ctx)
+{
+    for(auto k = 0; k < SEARCH_BATCH_SIZE; k++){
+        sc.candidate[k] = EC_POINT_new(group); 
+    }
+    sc.searchpoint = EC_POINT_new(group); 
+    sc.shifted_target = EC_POINT_new(group);
+    sc.negated_target = EC_POINT_new(group); 
+    sc.negated_searchpoint = EC_POINT_new(group); 
+    sc.babystep = EC_POINT_new(group); 
+    sc.BN_babystep = BN_new(); 
+    sc.ctx = ctx; 
+    P256_BATCH_new(sc.p256, SEARCH_BATCH_SIZE+2); 
+}
+
+void SHANKS_CONTEXT_free(SHANKS_CONTEXT &sc)
+{
+    for(auto k = 0; k < SEARCH_BATCH_SIZE; k++){
+        EC_POINT_free(sc.candidate[k]); 
+    }
+    EC_POINT_free(sc.searchpoint); 
+    EC_POINT_free(sc.shifted_target);
+    EC_POINT_free(sc.negated_target); 
+    EC_POINT_free(sc.negated_searchpoint); 
+    EC_POINT_free(sc.babystep); 
+    BN_free(sc.BN_babystep); 
+}
 
 /* 
-    Shanks algorithm for DLOG problem: given (g, h) find x \in [0, n = 2^RANGE_LEN) s.t. g^x = h 
-    g^{j*giantstep_size + i} = g^x; giantstep_num = n/giantstep_size
+** confirm the hit g^i for the candidate A of giant step j and recover x: return false for a false hit or x out of range. 
+** g^i comes from the baby-step table of the ladder if g is its base, otherwise from EC_POINT_mul
 */
+inline bool Shanks_solve(EC_POINT *&g, EC_POINT *&A, uint64_t i, uint64_t j, SHANKS_LAYOUT &layout, 
+                         int64_t &x, SHANKS_CONTEXT &sc)
+{
+    if(i < encode_giantstep_size && EC_POINT_cmp(group, g, babystep_table.base, sc.ctx) == 0){
+        ECP_Precompute_Table_mul(babystep_table, sc.babystep, i, sc.ctx); 
+    }
+    else{
+        BN_set_word(sc.BN_babystep, i);
+        EC_POINT_mul(group, sc.babystep, NULL, g, sc.BN_babystep, sc.ctx);
+    }
+    int sign = HASHMAP_verify(sc.babystep, A, sc.ctx); 
+    if(sign == 0) return false; 
+
+    uint64_t base = j*layout.giantstep_stride; 
+    if(sign == -1 && i > base) return false; // x < lo
+    uint64_t offset = (sign == 1) ? base + i : base - i;
+    if(offset >= layout.range_size) return false;
+    x = int64_t(uint64_t(layout.lo) + offset);
+    return true; 
+}
 
-unordered_map<string, unsigned long> point2index_map; // key-value hash table: key is EC POINT, value is its DLOG w.r.t. g
+/* compute the negated giant step -g^giantstep_stride for the mapped table with TABLE_SIZE baby steps */
+void Shanks_giantstep(EC_POINT *&ECP_giantstep, EC_POINT *&g, uint64_t TABLE_SIZE, BN_CTX *ctx)
+{
+    BN_CTX_start(ctx); 
+    BIGNUM* BN_giantstep_stride = BN_CTX_get(ctx); 
+    BN_set_word(BN_giantstep_stride, Shanks_stride(TABLE_SIZE));
+    EC_POINT_mul(group, ECP_giantstep, NULL, g, BN_giantstep_stride, ctx); // set giantstep = g^giantstep_stride
+    EC_POINT_invert(group, ECP_giantstep, ctx);
+    BN_CTX_end(ctx); 
+}
 
 /*
-    Note that OpenSSL does not provide substract operation for EC points, 
-    we have to implement substract operation by combining add operation and invert operation. 
-    This means substract operation is more expensive than add operation. 
-    When implementing Shanks algorithm, a repeated operation is "searchpoint = searchpoint - giantstep". 
-    To be more efficient, we set giantstep = - giantstep, than do the above update as "searchpoint = searchpoint + giantstep"   
+** check the candidates h - (lo + j*giantstep_stride)*g for j in [start, end); the candidates are normalised
+** in batches that double up to SEARCH_BATCH_SIZE, so that messages close to lo are still found early.
+** with the ladder the candidates are h + giantstep_ladder[j], otherwise they are walked from 
+** h + start*ECP_giantstep. the search stops early once another task raises the stop flag.
+** on the native backend only the target and a hit are converted, a candidate is searchpoint + p256_step[k] 
+** (or + p256_ladder[j]) and the walk moves on by p256_step[batch_size]
 */
-
-/* build the hash map */
-void HASHMAP_serialize(EC_POINT *&g, string hashmap_file, size_t RANGE_LEN, size_t TUNNING)
+bool Shanks_search(EC_POINT *&g, EC_POINT *&h, EC_POINT *&ECP_giantstep, SHANKS_LAYOUT &layout, 
+                   uint64_t start, uint64_t end, int64_t &x, atomic<bool> &stop, SHANKS_CONTEXT &sc)
 {
-    cout << "hash map does not exist, begin to build and serialize >>>" << endl; 
+    bool USE_LADDER = (giantstep_ladder.size() >= end); 
+    bool NATIVE = (group_backend == GROUP_P256_NATIVE) && (USE_LADDER == false || p256_ladder.size() >= end); 
 
-    auto start_time = chrono::steady_clock::now(); // start to count the time
-    uint64_t giantstep_size = pow(2, RANGE_LEN/2 + TUNNING); // giantstep size
-    EC_POINT *ECP_babystep = EC_POINT_new(group); 
-    EC_POINT_set_to_infinity(group, ECP_babystep); // set babystep = 0
+    BN_CTX *ctx = sc.ctx; 
+    EC_POINT **candidate = sc.candidate; 
+    EC_POINT *searchpoint = sc.searchpoint; 
+    uint64_t fingerprint[SEARCH_BATCH_SIZE]; 
 
-    unsigned char *buffer = new unsigned char[giantstep_size*POINT_LEN]();
-    if(buffer == NULL)
-    {
-        cout << "fail to create buffer" << endl; 
-        exit(EXIT_FAILURE); 
-    } 
-    // compute and save g^i into buffer 
-    for(auto i = 0; i < giantstep_size; i++)
-    {
-        EC_POINT_point2oct(group, ECP_babystep, POINT_CONVERSION_COMPRESSED, 
-                           buffer+(i*POINT_LEN), POINT_LEN, bn_ctx); 
-        EC_POINT_add(group, ECP_babystep, ECP_babystep, g, bn_ctx); // babystep += g
-    } 
-    // serialize buffer to hashmap_file
-    ofstream fout; 
-    fout.open(hashmap_file, ios::binary); 
-    if(!fout)
+    EC_POINT *target = h;
+    if(layout.lo != 0){
+        Shanks_shift(sc.shifted_target, g, h, layout.lo, ctx);
+        target = sc.shifted_target;
+    }
+
+    if(USE_LADDER == false){
+        BN_CTX_start(ctx); 
+        BIGNUM* BN_start = BN_CTX_get(ctx); 
+        BN_set_word(BN_start, start); 
+        EC_POINT_mul(group, searchpoint, NULL, ECP_giantstep, BN_start, ctx); 
+        EC_POINT_add(group, searchpoint, searchpoint, target, ctx); // searchpoint = target - start*giantstep_stride*g
+        BN_CTX_end(ctx); 
+    }
+
+    if(NATIVE == true){
+        P256_from_EC_POINT(sc.p256_searchpoint[0], (USE_LADDER == true) ? target : searchpoint, ctx); 
+        if(USE_LADDER == false) P256_multiples(sc.p256_step, ECP_giantstep, SEARCH_BATCH_SIZE, ctx); 
+    }
+
+    uint64_t i; 
+    bool finding = false; 
+    size_t batch_size = 1; 
+    for(uint64_t base = start; base < end && finding == false; base += batch_size)
     {
-        cout << hashmap_file << " open error" << endl;
-        exit(1); 
+        if(stop.load(memory_order_relaxed) == true) break; 
+
+        batch_size = (base == start) ? 1 : min(2*batch_size, SEARCH_BATCH_SIZE); 
+        batch_size = min<uint64_t>(batch_size, end - base); 
+
+        if(NATIVE == true){
+            P256_BATCH &batch = sc.p256; 
+            size_t num = batch_size + (USE_LADDER == false); // the last addition moves the walk on
+            for(auto k = 0; k < num; k++){
+                batch.lhs[k] = &sc.p256_searchpoint[0]; 
+                batch.rhs[k] = (USE_LADDER == true) ? &p256_ladder[base+k] : &sc.p256_step[k]; 
+            }
+            P256_BATCH_add(batch, num, fingerprint, batch_size); 
+            if(USE_LADDER == false) sc.p256_searchpoint[0] = batch.result[batch_size]; 
+        }
+        else{
+            for(auto k = 0; k < batch_size; k++){
+                if(USE_LADDER == true){
+                    EC_POINT_add(group, candidate[k], target, giantstep_ladder[base+k], ctx);
+                }
+                else{
+                    EC_POINT_copy(candidate[k], searchpoint); 
+                    EC_POINT_add(group, searchpoint, searchpoint, ECP_giantstep, ctx); // take a giant-step
+                }
+            }
+            ECP_batch_fingerprint(candidate, batch_size, fingerprint, ctx); 
+        }
+
+        // baby-step search in the hash map, a hit is confirmed by recomputing g^i
+        for(auto k = 0; k < batch_size; k++){
+            HASHMAP_prefetch_ahead(point2index_map, fingerprint, k, batch_size); 
+            uint64_t slot = HASHMAP_FIRST_SLOT; 
+            while (HASHMAP_find_next(point2index_map, fingerprint[k], slot, i) == true)
+            {
+                if (NATIVE == true) P256_to_EC_POINT(candidate[k], sc.p256.result[k], ctx); 
+                if (Shanks_solve(g, candidate[k], i, base+k, layout, x, sc))
+                {
+                    finding = true;
+                    break;
+                }
+            }
+            if (finding == true) break; 
+        }
     }
-    fout.write(reinterpret_cast<char *>(buffer), giantstep_size*POINT_LEN); 
-    fout.close(); 
-    delete[] buffer; 
-        
-    auto end_time = chrono::steady_clock::now(); // end to count the time
-    auto running_time = end_time - start_time;
-    cout << "hash map building and serializing takes time = " 
-        << chrono::duration <double, milli> (running_time).count() << " ms" << endl;
-    
-    EC_POINT_free(ECP_babystep); 
+
+    return finding; 
 }
 
-/* rebuild hash map from hashmap file */
-void HASHMAP_deserialize(string hashmap_file, size_t RANGE_LEN, size_t TUNNING)
-{   
-    cout << "hash map already exists, begin to load and rebuild >>>" << endl; 
+/*
+** signed search for lo < 0 < hi: check the candidates h - j*giantstep_stride*g while j < layout[0].loop_num and
+** -h - j*giantstep_stride*g while j < layout[1].loop_num, for j in [start, end). the negation of h is free,
+** so x of either sign is found after |x|/giantstep_stride giant steps. x < 0 is reported when -h hits.
+** layout[0] covers [0, hi) and layout[1] covers [0, -lo], the batches double up to SEARCH_BATCH_SIZE candidates
+*/
+bool Shanks_signed_search(EC_POINT *&g, EC_POINT *&h, EC_POINT *&ECP_giantstep, SHANKS_LAYOUT layout[2],
+                          uint64_t start, uint64_t end, int64_t &x, atomic<bool> &stop, SHANKS_CONTEXT &sc)
+{
+    bool USE_LADDER = (giantstep_ladder.size() >= end); 
+    bool NATIVE = (group_backend == GROUP_P256_NATIVE) && (USE_LADDER == false || p256_ladder.size() >= end); 
 
-    auto start_time = chrono::steady_clock::now(); // start to count the time
-    uint64_t giantstep_size = pow(2, RANGE_LEN/2 + TUNNING); 
+    BN_CTX *ctx = sc.ctx; 
+    EC_POINT **candidate = sc.candidate; 
+    uint64_t fingerprint[SEARCH_BATCH_SIZE]; 
+    uint64_t step[SEARCH_BATCH_SIZE]; // the giant step and the side of each candidate
+    int side[SEARCH_BATCH_SIZE];
 
-    unsigned char* buffer = new unsigned char[giantstep_size*POINT_LEN]();  
-    if(buffer == NULL)
-    {
-        cout << "fail to create buffer" << endl; 
-        exit(EXIT_FAILURE); 
-    }   
-    // load hashmap_file to buffer
-    ifstream fin; 
-    fin.open(hashmap_file, ios::binary); 
-    if(!fin)
+    EC_POINT_copy(sc.negated_target, h); 
+    EC_POINT_invert(group, sc.negated_target, ctx); 
+    EC_POINT *target[2] = {h, sc.negated_target}; 
+    EC_POINT *searchpoint[2] = {sc.searchpoint, sc.negated_searchpoint}; 
+
+    if(USE_LADDER == false){
+        BN_CTX_start(ctx); 
+        BIGNUM* BN_start = BN_CTX_get(ctx); 
+        BN_set_word(BN_start, start); 
+        EC_POINT_mul(group, searchpoint[0], NULL, ECP_giantstep, BN_start, ctx); 
+        EC_POINT_add(group, searchpoint[1], searchpoint[0], target[1], ctx); // -h - start*giantstep_stride*g
+        EC_POINT_add(group, searchpoint[0], searchpoint[0], target[0], ctx); // h - start*giantstep_stride*g
+        BN_CTX_end(ctx); 
+    }
+
+    if(NATIVE == true){
+        if(USE_LADDER == true){
+            P256_from_EC_POINT(sc.p256_searchpoint[0], target[0], ctx); 
+            P256_negate(sc.p256_searchpoint[1], sc.p256_searchpoint[0]); 
+        }
+        else{
+            P256_from_EC_POINT(sc.p256_searchpoint[0], searchpoint[0], ctx); 
+            P256_from_EC_POINT(sc.p256_searchpoint[1], searchpoint[1], ctx); 
+            P256_multiples(sc.p256_step, ECP_giantstep, SEARCH_BATCH_SIZE/2, ctx); 
+        }
+    }
+
+    uint64_t i; 
+    int64_t result; 
+    bool finding = false; 
+    size_t batch_size = 1; // the number of giant steps in the batch, each gives up to two candidates
+    for(uint64_t base = start; base < end && finding == false; base += batch_size)
     {
-        cout << hashmap_file << " read error" << endl;
-        exit(EXIT_FAILURE); 
+        if(stop.load(memory_order_relaxed) == true) break; 
+
+        batch_size = (base == start) ? 1 : min(2*batch_size, SEARCH_BATCH_SIZE/2); 
+        batch_size = min<uint64_t>(batch_size, end - base); 
+
+        size_t num = 0;
+        size_t count[2] = {0, 0}; // the candidates of either side in this batch
+        for(auto k = 0; k < batch_size; k++){
+            for(auto s = 0; s < 2; s++){
+                if(base + k >= layout[s].loop_num) continue; // this side is done
+                if(NATIVE == true){
+                    sc.p256.lhs[num] = &sc.p256_searchpoint[s]; 
+                    sc.p256.rhs[num] = (USE_LADDER == true) ? &p256_ladder[base+k] : &sc.p256_step[k]; 
+                }
+                else if(USE_LADDER == true){
+                    EC_POINT_add(group, candidate[num], target[s], giantstep_ladder[base+k], ctx);
+                }
+                else{
+                    EC_POINT_copy(candidate[num], searchpoint[s]);
+                    EC_POINT_add(group, searchpoint[s], searchpoint[s], ECP_giantstep, ctx); // take a giant-step
+                }
+                step[num] = base + k;
+                side[num] = s;
+                count[s]++; 
+                num++;
+            }
+        }
+        if(NATIVE == true){
+            // the walk of either side moves on by its number of candidates
+            size_t walk_num = 0; 
+            for(auto s = 0; s < 2 && USE_LADDER == false; s++){
+                if(count[s] == 0) continue; 
+                sc.p256.lhs[num+walk_num] = &sc.p256_searchpoint[s]; 
+                sc.p256.rhs[num+walk_num] = &sc.p256_step[count[s]]; 
+                walk_num++; 
+            }
+            P256_BATCH_add(sc.p256, num+walk_num, fingerprint, num); 
+            for(auto s = 0, w = 0; s < 2 && USE_LADDER == false; s++){
+                if(count[s] > 0) sc.p256_searchpoint[s] = sc.p256.result[num + w++]; 
+            }
+        }
+        else ECP_batch_fingerprint(candidate, num, fingerprint, ctx);
+
+        // baby-step search in the hash map, a hit is confirmed by recomputing g^i
+        for(auto k = 0; k < num; k++){
+            HASHMAP_prefetch_ahead(point2index_map, fingerprint, k, num); 
+            uint64_t slot = HASHMAP_FIRST_SLOT; 
+            while (HASHMAP_find_next(point2index_map, fingerprint[k], slot, i) == true)
+            {
+                if (NATIVE == true) P256_to_EC_POINT(candidate[k], sc.p256.result[k], ctx); 
+                if (Shanks_solve(g, candidate[k], i, step[k], layout[side[k]], result, sc))
+                {
+                    x = (side[k] == 0) ? result : -result;
+                    finding = true;
+                    break;
+                }
+            }
+            if (finding == true) break; 
+        }
+    }
+
+    return finding; 
+}
+
+/* the layouts of the signed search over [lo, hi) with lo < 0 < hi: h is searched in [0, hi) and -h in [0, -lo] */
+inline void Shanks_signed_layout(SHANKS_LAYOUT layout[2], int64_t lo, int64_t hi, uint64_t TABLE_SIZE)
+{
+    layout[0] = Shanks_layout(0, hi, TABLE_SIZE);
+    layout[1] = Shanks_sublayout(layout[0], uint64_t(0) - uint64_t(lo) + 1);
+}
+
+/*
+** look h = g^x up in the plaintext cache and in the small tier, neither needs the giant step: 
+** return false if neither knows h. x is the unique DLOG, so a hit out of [lo, hi) means there is no x in range
+*/
+inline bool Shanks_lookup(EC_POINT *&g, EC_POINT *&h, int64_t &x, BN_CTX *ctx)
+{
+    return PLAINTEXT_CACHE_find(g, h, x, ctx) == true || SMALL_HASHMAP_find(g, h, x, ctx) == true; 
+}
+
+/* the giant-step search of Shanks_DLOG, a solution is recorded in the plaintext cache */
+bool Shanks_walk(EC_POINT *&g, EC_POINT *&h, EC_POINT *&ECP_giantstep, 
+                 int64_t lo, int64_t hi, uint64_t TABLE_SIZE, int64_t &x, SHANKS_CONTEXT &sc)
+{
+    bool finding;
+    atomic<bool> stop(false); 
+    if(lo < 0 && hi > 0){
+        SHANKS_LAYOUT layout[2];
+        Shanks_signed_layout(layout, lo, hi, TABLE_SIZE);
+        uint64_t loop_num = max(layout[0].loop_num, layout[1].loop_num);
+        finding = Shanks_signed_search(g, h, ECP_giantstep, layout, 0, loop_num, x, stop, sc);
+    }
+    else{
+        SHANKS_LAYOUT layout = Shanks_layout(lo, hi, TABLE_SIZE);
+        finding = Shanks_search(g, h, ECP_giantstep, layout, 0, layout.loop_num, x, stop, sc);
     }
-    fin.seekg(0, fin.end);
-    size_t FILE_LEN = fin.tellg(); // get the size of hash table file
-    if (FILE_LEN != giantstep_size*POINT_LEN)
+    if(finding == true) PLAINTEXT_CACHE_insert(g, h, x, sc.ctx); 
+    return finding; 
+}
+
+/*
+** compute x in [lo, hi) s.t. g^x = h with the negated giant step and the scratch state supplied by the caller,
+** the search allocates no point or BIGNUM per call, a table hit included (OpenSSL may still allocate internally): 
+** finding = false indicates there is no such x in specified range.
+** if the interval contains 0 on both sides, the search runs in both directions from the identity
+*/
+bool Shanks_DLOG(BIGNUM *&x, EC_POINT *&g, EC_POINT *&h, EC_POINT *&ECP_giantstep, 
+                 int64_t lo, int64_t hi, uint64_t TABLE_SIZE, SHANKS_CONTEXT &sc)
+{
+    // check if the hash map is empty
+    if(HASHMAP_empty(point2index_map) == true)
     {
-        cout << "buffer size does not match hashmap size" << endl; 
-        exit(EXIT_FAILURE); 
+        cout << "the hashmap is empty" << endl;
+        exit (EXIT_FAILURE);
     }
-    fin.seekg(0);                  // reset the file pointer to the beginning of file
-    fin.read(reinterpret_cast<char*>(buffer), FILE_LEN); // read file from disk to RAM
-    fin.close(); 
 
-    // reconstruct hashmap from buffer 
-    string str; 
+    int64_t result; 
+    bool finding;
+    if(Shanks_lookup(g, h, result, sc.ctx) == true) finding = (result >= lo && result < hi); 
+    else finding = Shanks_walk(g, h, ECP_giantstep, lo, hi, TABLE_SIZE, result, sc); 
+    if(finding == true) Shanks_result(x, result);
+
+    return finding; 
+}
 
-    /* point_to_index_map[ECn_to_String(babystep)] = i */
-    for(auto i = 0; i < giantstep_size; i++)
+/* compute x in [lo, hi) s.t. g^x = h: finding = false indicates there is no such x in specified range */
+bool Shanks_DLOG(BIGNUM *&x, EC_POINT *&g, EC_POINT *&h, int64_t lo, int64_t hi, uint64_t TABLE_SIZE)
+{
+    // check if the hash map is empty
+    if(HASHMAP_empty(point2index_map) == true)
     {
-        str.assign(reinterpret_cast<char *>(buffer+(i*POINT_LEN)), POINT_LEN);  
-        point2index_map[str] = i; 
+        cout << "the hashmap is empty" << endl;
+        exit (EXIT_FAILURE);
     }
 
-    delete[] buffer; 
-    
-    auto end_time = chrono::steady_clock::now(); // end to count the time
-    auto running_time = end_time - start_time;
-    cout << "hash map loading and rebuilding takes time = " 
-    << chrono::duration <double, milli> (running_time).count() << " ms" << endl;
-} 
+    int64_t result; 
+    bool finding; 
+    // a hit in the cache or in the small tier saves computing the giant step as well
+    if(Shanks_lookup(g, h, result, bn_ctx) == true) finding = (result >= lo && result < hi); 
+    else{
+        /* compute the giantstep */
+        EC_POINT* ECP_giantstep = EC_POINT_new(group); 
+        Shanks_giantstep(ECP_giantstep, g, TABLE_SIZE, bn_ctx);
+
+        // giant-step and baby-step search
+        SHANKS_CONTEXT sc; 
+        SHANKS_CONTEXT_new(sc, bn_ctx); 
+        finding = Shanks_walk(g, h, ECP_giantstep, lo, hi, TABLE_SIZE, result, sc);
+        SHANKS_CONTEXT_free(sc); 
+
+        EC_POINT_free(ECP_giantstep); 
+    }
+    if(finding == true) Shanks_result(x, result); 
 
-/* compute x s.t. y g^x = h: finding = false indicates there is no such x in specified range */
-bool Shanks_DLOG(BIGNUM *&x, EC_POINT *&g, EC_POINT *&h, size_t RANGE_LEN, size_t TUNNING)
+    return finding; 
+}
+
+/* a sub-range [lo, hi) of the DLOG interval */
+struct DLOG_INTERVAL
 {
-    /* giantstep_size * loop_num = 2^RANGE_LEN */
-    uint64_t giantstep_size = pow(2, RANGE_LEN/2 + TUNNING); 
-    uint64_t loop_num  = pow(2, RANGE_LEN/2 - TUNNING); 
+    int64_t lo; 
+    int64_t hi; 
+};
 
-    /* compute the giantstep */
-    EC_POINT* ECP_giantstep = EC_POINT_new(group); 
-    BIGNUM* BN_giantstep_size = BN_new(); 
-    BN_set_word(BN_giantstep_size, giantstep_size);
-    EC_POINT_mul(group, ECP_giantstep, NULL, g, BN_giantstep_size, bn_ctx); // set giantstep = g^giantstep_size
-    EC_POINT_invert(group, ECP_giantstep, bn_ctx);
+/* the giant step whose candidate covers the offset x - lo */
+inline uint64_t Shanks_block(SHANKS_LAYOUT &layout, uint64_t offset)
+{
+    uint64_t j = (point2index_map.mode == HASHMAP_X_MODE) ? (offset + layout.giantstep_stride/2)/layout.giantstep_stride
+                                                          : offset/layout.giantstep_stride; 
+    return min(j, layout.loop_num - 1); 
+}
 
-    /* begin to search */
-    uint64_t i, j; // define two indices used to record babystep and giantstep
-    EC_POINT* searchpoint = EC_POINT_new(group); 
-    EC_POINT_copy(searchpoint, h);  // set the searchpoint to h
-  
-    string ecp_str; 
-    bool finding = false; // set the initial finding flag to be false
+/* check the giant steps in [start, end) that are not visited yet, and mark them visited */
+bool Shanks_progressive_run(EC_POINT *&g, EC_POINT *&h, EC_POINT *&ECP_giantstep, SHANKS_LAYOUT &layout, 
+                            vector<bool> &visited, uint64_t start, uint64_t end, int64_t &x, 
+                            atomic<bool> &stop, SHANKS_CONTEXT &sc)
+{
+    for(uint64_t j = start; j < end; )
+    {
+        if(visited[j] == true){
+            j++; 
+            continue; 
+        }
+        uint64_t run_end = j; 
+        while(run_end < end && visited[run_end] == false) visited[run_end++] = true; 
+        if(Shanks_search(g, h, ECP_giantstep, layout, j, run_end, x, stop, sc) == true) return true; 
+        j = run_end; 
+    }
+    return false; 
+}
+
+/*
+** progressive Shanks: compute x in [lo, hi) s.t. g^x = h, the giant steps covering prior[0], prior[1], ... 
+** (a caller-supplied order of sub-ranges, the most likely first, e.g. small values or recently seen ones) 
+** are checked first, then the search widens from the smallest |x| in blocks that double in size until 
+** it covers [lo, hi). a bitmap of the visited giant steps keeps every step to a single check, 
+** so the latency follows the distribution of x and the worst case costs the same as Shanks_DLOG
+*/
+bool Progressive_Shanks_DLOG(BIGNUM *&x, EC_POINT *&g, EC_POINT *&h, int64_t lo, int64_t hi, uint64_t TABLE_SIZE, 
+                             vector<DLOG_INTERVAL> &prior)
+{
+    SHANKS_LAYOUT layout = Shanks_layout(lo, hi, TABLE_SIZE); 
 
     // check if the hash map is empty
-    if(point2index_map.empty() == true)
+    if(HASHMAP_empty(point2index_map) == true)
     {
-        cout << "the hashmap is empty" << endl; 
+        cout << "the hashmap is empty" << endl;
         exit (EXIT_FAILURE);
     }
 
-    unsigned char *buffer = new unsigned char[loop_num*POINT_LEN](); 
-    if (buffer == NULL)
+    EC_POINT* ECP_giantstep = EC_POINT_new(group); 
+    Shanks_giantstep(ECP_giantstep, g, TABLE_SIZE, bn_ctx); 
+
+    // the runs search target = h - lo*g over [0, hi - lo), so that the target is shifted only once
+    EC_POINT *target = EC_POINT_new(group); 
+    if(lo != 0) Shanks_shift(target, g, h, lo, bn_ctx); 
+    else EC_POINT_copy(target, h); 
+    layout.lo = 0; 
+
+    SHANKS_CONTEXT sc; 
+    SHANKS_CONTEXT_new(sc, bn_ctx); 
+    vector<bool> visited(layout.loop_num, false); 
+    atomic<bool> stop(false); 
+    int64_t offset; 
+    bool finding = false; 
+
+    // the sub-ranges in the order of the prior
+    for(auto k = 0; k < prior.size() && finding == false; k++)
     {
-        cout << "fail to create buffer" << endl; 
-        exit(EXIT_FAILURE); 
-    } 
-    // giant-step and baby-step search
-    for(j = 0; j < loop_num; j++)
+        int64_t a = max(prior[k].lo, lo), b = min(prior[k].hi, hi); 
+        if(a >= b) continue; 
+        uint64_t start = Shanks_block(layout, uint64_t(a) - uint64_t(lo)); 
+        uint64_t end = Shanks_block(layout, uint64_t(b) - uint64_t(lo) - 1) + 1; 
+        finding = Shanks_progressive_run(g, target, ECP_giantstep, layout, visited, start, end, offset, stop, sc); 
+    }
+
+    // widen from the smallest |x| in [lo, hi) to both sides
+    int64_t center = (lo > 0) ? lo : ((hi <= 0) ? hi - 1 : 0); 
+    uint64_t left = Shanks_block(layout, uint64_t(center) - uint64_t(lo)), right = left; // [left, right) is covered
+    for(uint64_t len = 1; finding == false && (left > 0 || right < layout.loop_num); len *= 2)
     {
-        /* If key not found in map iterator to end is returned */ 
+        uint64_t end = min(right + len, layout.loop_num); 
+        finding = Shanks_progressive_run(g, target, ECP_giantstep, layout, visited, right, end, offset, stop, sc); 
+        right = end; 
+        if(finding == true) break; 
 
-        // convert the search point to binary form
-        EC_POINT_point2oct(group, searchpoint, POINT_CONVERSION_COMPRESSED, buffer+(j*POINT_LEN), POINT_LEN, bn_ctx);  
-        // map the binary expression to string
-        ecp_str.assign(reinterpret_cast<char*>(buffer+(j*POINT_LEN)), POINT_LEN); 
-        
-        // baby-step search in the hash map
-        if (point2index_map.find(ecp_str) == point2index_map.end())
-        {
-            //EC_POINT_sub(searchpoint, searchpoint, giantstep); // not found, take a giant-step 
-            EC_POINT_add(group, searchpoint, searchpoint, ECP_giantstep, bn_ctx); // not found, take a giant-step     
+        uint64_t start = (left > len) ? left - len : 0; 
+        finding = Shanks_progressive_run(g, target, ECP_giantstep, layout, visited, start, left, offset, stop, sc); 
+        left = start; 
+    }
+    if(finding == true) Shanks_result(x, int64_t(uint64_t(lo) + uint64_t(offset))); 
+
+    SHANKS_CONTEXT_free(sc); 
+    EC_POINT_free(target); 
+    EC_POINT_free(ECP_giantstep); 
+
+    return finding; 
+}
+
+/*
+** multi-target Shanks: compute x[t] in [lo, hi) s.t. g^x[t] = h[t] for all targets in one pass; every giant step
+** is taken for all unsolved targets together, the candidates are normalised BATCH_SIZE at a time 
+** and probed in bulk. finding[t] = 0 indicates there is no such x[t] in specified range (or no table is loaded).
+** the targets are copied before they are normalised, h is left untouched
+*/
+void Batch_Shanks_DLOG(vector<BIGNUM *> &x, EC_POINT *&g, vector<EC_POINT *> &h, 
+                       int64_t lo, int64_t hi, uint64_t TABLE_SIZE, vector<int> &finding)
+{
+    size_t target_num = h.size(); 
+    finding.assign(target_num, 0); 
+    if(target_num == 0 || HASHMAP_empty(point2index_map) == true) return; 
+
+    SHANKS_LAYOUT layout = Shanks_layout(lo, hi, TABLE_SIZE);
+    bool USE_LADDER = (giantstep_ladder.size() >= layout.loop_num); 
+    bool NATIVE = (group_backend == GROUP_P256_NATIVE) && (USE_LADDER == false || p256_ladder.size() >= layout.loop_num); 
+
+    /* compute the giantstep */
+    EC_POINT* ECP_giantstep = EC_POINT_new(group); 
+    Shanks_giantstep(ECP_giantstep, g, TABLE_SIZE, bn_ctx);
+
+    // the search starts from lo: the targets are copies of h[t] shifted to h[t] - lo*g
+    vector<EC_POINT *> target(target_num);
+    for(auto t = 0; t < target_num; t++){
+        target[t] = EC_POINT_new(group);
+        if(lo == 0) EC_POINT_copy(target[t], h[t]);
+        else Shanks_shift(target[t], g, h[t], lo, bn_ctx);
+    }
+    ECP_batch_make_affine(target_num, target.data(), bn_ctx); // affine targets make every candidate a cheaper add
+
+    // without the ladder each target walks its own searchpoint 
+    vector<EC_POINT *> searchpoint; 
+    if(USE_LADDER == false){
+        searchpoint.resize(target_num); 
+        for(auto t = 0; t < target_num; t++){
+            searchpoint[t] = EC_POINT_new(group); 
+            EC_POINT_copy(searchpoint[t], target[t]);
         }
-        else{
-            i = point2index_map[ecp_str]; 
-            finding = true; 
-            break;
+    }
+
+    /* 
+    ** native backend: p256_target[t] is the target (with the ladder) or the previous candidate, 
+    ** which starts one giant step before the target, so the candidate of every step is a single addition 
+    */
+    vector<P256_AFFINE> p256_target; 
+    P256_AFFINE p256_giantstep; 
+    P256_BATCH batch; 
+    if(NATIVE == true){
+        p256_target.resize(target_num); 
+        P256_from_EC_POINT(p256_giantstep, ECP_giantstep, bn_ctx); 
+        P256_AFFINE back; 
+        P256_negate(back, p256_giantstep); 
+        for(auto t = 0; t < target_num; t++){
+            P256_from_EC_POINT(p256_target[t], target[t], bn_ctx); 
         }
+        P256_BATCH_new(batch, target_num); 
+        if(USE_LADDER == false){
+            for(auto t = 0; t < target_num; t++){
+                batch.lhs[t] = &p256_target[t]; 
+                batch.rhs[t] = &back; 
+            }
+            P256_batch_add(batch.result.data(), batch.lhs.data(), batch.rhs.data(), target_num, batch.scratch.data()); 
+            p256_target = batch.result; 
+        }
+        P256_BATCH_new(batch, BATCH_SIZE); 
+    }
+
+    vector<size_t> active(target_num); // indices of the unsolved targets
+    for(auto t = 0; t < target_num; t++) active[t] = t; 
+
+    EC_POINT **candidate = new EC_POINT*[BATCH_SIZE]; 
+    uint64_t *fingerprint = new uint64_t[BATCH_SIZE]; 
+    for(auto k = 0; k < BATCH_SIZE; k++){
+        candidate[k] = EC_POINT_new(group); 
     }
 
-    if(finding == true){
-        BIGNUM* BN_i = BN_new(); BN_set_word(BN_i, i); 
-        BIGNUM* BN_j = BN_new(); BN_set_word(BN_j, j); 
+    uint64_t i; 
+    int64_t result; 
+    SHANKS_CONTEXT sc; // the scratch of Shanks_solve
+    SHANKS_CONTEXT_new(sc, bn_ctx); 
 
-        BN_mul(BN_j, BN_j, BN_giantstep_size, bn_ctx); 
-        BN_add(x, BN_i, BN_j); // x = i + j*giantstep_size; 
+    // giant-step and baby-step search
+    for(uint64_t j = 0; j < layout.loop_num && active.empty() == false; j++)
+    {
+        for(size_t base = 0; base < active.size(); base += BATCH_SIZE)
+        {
+            size_t num = min(BATCH_SIZE, active.size() - base); 
+            if(NATIVE == true){
+                for(auto k = 0; k < num; k++){
+                    size_t t = active[base+k]; 
+                    batch.lhs[k] = &p256_target[t]; 
+                    batch.rhs[k] = (USE_LADDER == true) ? &p256_ladder[j] : &p256_giantstep; 
+                }
+                P256_BATCH_add(batch, num, fingerprint, num); 
+                for(auto k = 0; k < num && USE_LADDER == false; k++){
+                    p256_target[active[base+k]] = batch.result[k]; 
+                }
+            }
+            else{
+                for(auto k = 0; k < num; k++){
+                    size_t t = active[base+k]; 
+                    if(USE_LADDER == true){
+                        EC_POINT_add(group, candidate[k], target[t], giantstep_ladder[j], bn_ctx);
+                    }
+                    else{
+                        EC_POINT_copy(candidate[k], searchpoint[t]); 
+                        EC_POINT_add(group, searchpoint[t], searchpoint[t], ECP_giantstep, bn_ctx); 
+                    }
+                }
+                ECP_batch_fingerprint(candidate, num, fingerprint, bn_ctx); 
+            }
+
+            // baby-step search in the hash map, a hit is confirmed by recomputing g^i
+            for(auto k = 0; k < num; k++){
+                size_t t = active[base+k]; 
+                HASHMAP_prefetch_ahead(point2index_map, fingerprint, k, num); 
+                uint64_t slot = HASHMAP_FIRST_SLOT; 
+                while (finding[t] == 0 && HASHMAP_find_next(point2index_map, fingerprint[k], slot, i) == true)
+                {
+                    if (NATIVE == true) P256_to_EC_POINT(candidate[k], batch.result[k], bn_ctx); 
+                    if (Shanks_solve(g, candidate[k], i, j, layout, result, sc))
+                    {
+                        Shanks_result(x[t], result);
+                        finding[t] = 1; 
+                    }
+                }
+            }
+        }
 
-        BN_free(BN_i); 
-        BN_free(BN_j);
+        // drop the solved targets
+        size_t remain = 0; 
+        for(auto k = 0; k < active.size(); k++){
+            if(finding[active[k]] == 0) active[remain++] = active[k]; 
+        }
+        active.resize(remain); 
+    }
+
+    SHANKS_CONTEXT_free(sc); 
+    for(auto k = 0; k < BATCH_SIZE; k++){
+        EC_POINT_free(candidate[k]); 
+    }
+    delete[] candidate; 
+    delete[] fingerprint; 
+    for(auto t = 0; t < searchpoint.size(); t++){
+        EC_POINT_free(searchpoint[t]); 
+    }
+    for(auto t = 0; t < target_num; t++){
+        EC_POINT_free(target[t]);
     }
-    else{
-        cout << "the DLOG is not found in the specified range" << endl; 
-    } 
 
-    delete[] buffer; 
     EC_POINT_free(ECP_giantstep); 
-    EC_POINT_free(searchpoint); 
-    BN_free(BN_giantstep_size); 
-    
-    return finding; 
 }
 
 /* parallel implementation: include parallel serialization and decryption */
 
 
-/* parallelizable serialize task */
-void ECP_vector_serialize(EC_POINT *&g, EC_POINT *&ECP_startpoint, uint64_t &startindex, 
-                          uint64_t &length, unsigned char* buffer)
-{    
-    for(auto i = 0; i < length; i++)
-    {
-        EC_POINT_point2oct(group, ECP_startpoint, POINT_CONVERSION_COMPRESSED, 
-                           buffer+((startindex+i)*POINT_LEN), POINT_LEN, NULL); 
-        EC_POINT_add(group, ECP_startpoint, ECP_startpoint, g, NULL); 
-    } 
-}
-
-
-/* build the hash map */
-void Parallel_HASHMAP_serialize(EC_POINT *&g, string hashmap_file, size_t RANGE_LEN, 
-                                size_t TUNNING, uint64_t IO_THREAD_NUM)
+/* build the hash map: g^i for i < TABLE_SIZE (i <= TABLE_SIZE in x-only mode), task i takes an even share of the entries */
+void Parallel_HASHMAP_serialize(EC_POINT *&g, string hashmap_file, uint64_t TABLE_SIZE,
+                                uint64_t IO_THREAD_NUM, uint32_t mode = HASHMAP_XY_MODE)
 {
     cout << "hash map does not exist, begin to build and serialize >>>" << endl; 
 
     auto start_time = chrono::steady_clock::now(); // start to count the time
-    uint64_t giantstep_size = pow(2, RANGE_LEN/2 + TUNNING); // giantstep size
+    uint64_t entry_num = HASHMAP_entry_num(TABLE_SIZE, mode);
 
     BIGNUM *BN_range = BN_new(); 
 
-    if(giantstep_size%IO_THREAD_NUM != 0)
-    {
-        cout << "thread assignment fails" << endl; 
-        exit(EXIT_FAILURE); 
-    }
-    uint64_t length = giantstep_size/IO_THREAD_NUM; 
-
     vector<EC_POINT *> ECP_startpoint(IO_THREAD_NUM); 
     vector<uint64_t> startindex(IO_THREAD_NUM); 
+    vector<uint64_t> length(IO_THREAD_NUM);
     for (auto i = 0; i < IO_THREAD_NUM; i++){
-        startindex[i] = i * length; 
+        startindex[i] = i*entry_num/IO_THREAD_NUM;
+        length[i] = (i+1)*entry_num/IO_THREAD_NUM - startindex[i];
         ECP_startpoint[i] = EC_POINT_new(group);
         BN_set_word(BN_range, startindex[i]);
         EC_POINT_mul(group, ECP_startpoint[i], NULL, g, BN_range, bn_ctx);
-    } 
+    }
 
-    unsigned char *buffer = new unsigned char[giantstep_size*POINT_LEN]();
-    if(buffer == NULL)
+    uint64_t *fingerprint = new uint64_t[entry_num]();
+    if(fingerprint == NULL)
     {
-        cout << "fail to create buffer" << endl; 
+        cout << "fail to create buffer" << endl;
         exit(EXIT_FAILURE); 
-    } 
+    }
 
-    vector<thread> initialize_task;
-    for(auto i = 0; i < IO_THREAD_NUM; i++){ 
-        initialize_task.push_back(std::thread(ECP_vector_serialize, 
-                                  std::ref(g), std::ref(ECP_startpoint[i]), 
-                                  std::ref(startindex[i]), std::ref(length), std::ref(buffer)));
+    vector<function<void()>> initialize_task;
+    for(auto i = 0; i < IO_THREAD_NUM; i++){
+        initialize_task.push_back(bind(ECP_vector_serialize,
+                                  std::ref(g), std::ref(ECP_startpoint[i]),
+                                  std::ref(startindex[i]), std::ref(length[i]), fingerprint));
     }
+    THREAD_POOL_run(initialize_task);
 
-    for(auto i = 0; i < IO_THREAD_NUM; i++){ 
-        initialize_task[i].join(); 
-    }    
+    // insert the fingerprints into the table, then serialize it to hashmap_file
+    HASHMAP map;
+    HASHMAP_new(map, entry_num, mode);
+    for(uint64_t i = 0; i < entry_num; i++) HASHMAP_insert(map, fingerprint[i], i);
+    delete[] fingerprint; 
+
+    HASHMAP_write(map, g, hashmap_file, TABLE_SIZE);
+    HASHMAP_free(map);
 
-    // serialize buffer to hashmap_file
-    ofstream fout; 
-    fout.open(hashmap_file, ios::binary); 
-    if(!fout)
-    {
-        cout << hashmap_file << " open error" << endl;
-        exit(1); 
-    }
-    fout.write(reinterpret_cast<char *>(buffer), giantstep_size*POINT_LEN); 
-    fout.close(); 
-    delete[] buffer; 
-        
     auto end_time = chrono::steady_clock::now(); // end to count the time
     auto running_time = end_time - start_time;
     cout << "hash map building and serializing takes time = " 
         << chrono::duration <double, milli> (running_time).count() << " ms" << endl;
-    
+
     BN_free(BN_range); 
     for (auto i = 0; i < IO_THREAD_NUM; i++){
         EC_POINT_free(ECP_startpoint[i]);  
-    } 
+    }
 }
 
-/* parallelizable search task */
-void search_index(EC_POINT *&ECP_searchpoint, EC_POINT *&ECP_giantstep, 
-                  uint64_t &sliced_loop_num, uint64_t &i, uint64_t &j, 
-                  int &finding, int &parallel_finding)
-{    
-    string ecp_str; 
-    unsigned char *buffer = new unsigned char[sliced_loop_num*POINT_LEN](); 
-    if (buffer == NULL)
-    {
-        cout << "fail to create buffer" << endl; 
-        delete[] buffer; 
-        exit(EXIT_FAILURE); 
-    } 
-    // giant-step and baby-step search
-    for(j = 0; j < sliced_loop_num; j++)
+/* parallelizable search task: giant steps [start, end), the task raises the stop flag for the others once it finds x */
+void search_index(EC_POINT *&g, EC_POINT *&h, EC_POINT *&ECP_giantstep, SHANKS_LAYOUT *layout, bool SIGNED,
+                  uint64_t start, uint64_t end, int64_t &x, int &finding, atomic<bool> &stop)
+{
+    SHANKS_CONTEXT sc; 
+    SHANKS_CONTEXT_new(sc, THREAD_POOL_context()->bn_ctx); 
+    if ((SIGNED ? Shanks_signed_search(g, h, ECP_giantstep, layout, start, end, x, stop, sc)
+                : Shanks_search(g, h, ECP_giantstep, layout[0], start, end, x, stop, sc)) == true)
     {
-        /* If key not found in map iterator to end is returned */ 
-        if (parallel_finding == 1) break; 
-        // map the point to string
-        EC_POINT_point2oct(group, ECP_searchpoint, POINT_CONVERSION_COMPRESSED, buffer+(j*POINT_LEN), POINT_LEN, NULL);  
-        ecp_str.assign(reinterpret_cast<char*>(buffer+(j*POINT_LEN)), POINT_LEN); 
-        
-        // baby-step search in the hash map
-        if (point2index_map.find(ecp_str) == point2index_map.end())
-        {
-            //EC_POINT_sub_without_bnctx(searchpoint, searchpoint, giantstep); // not found, take a giant-step forward   
-            EC_POINT_add(group, ECP_searchpoint, ECP_searchpoint, ECP_giantstep, NULL); // not found, take a giant-step forward   
-        }
-        else{
-            i = point2index_map[ecp_str]; 
-            finding = 1; 
-            parallel_finding = 1; 
-            break;
-        }
+        finding = 1;
+        stop = true;
     }
-    delete[] buffer; 
+    SHANKS_CONTEXT_free(sc); 
 }
 
+/*
+** parallel Shanks: compute x in [lo, hi) s.t. g^x = h, task i takes the giant steps
+** [i*loop_num/DEC_THREAD_NUM, (i+1)*loop_num/DEC_THREAD_NUM), so any loop_num and thread number go together
+*/
 bool Parallel_Shanks_DLOG(BIGNUM *&x, EC_POINT *&g, EC_POINT *&h, 
-                          size_t RANGE_LEN, size_t TUNNING, uint64_t DEC_THREAD_NUM)
+                          int64_t lo, int64_t hi, uint64_t TABLE_SIZE, uint64_t DEC_THREAD_NUM)
 {
-    uint64_t giantstep_size = pow(2, RANGE_LEN/2 + TUNNING); 
-    uint64_t loop_num  = pow(2, RANGE_LEN/2 - TUNNING); 
+    // a cached x or a small |x| needs no search
+    int64_t cached; 
+    if(Shanks_lookup(g, h, cached, bn_ctx) == true){
+        if(cached < lo || cached >= hi) return false; 
+        Shanks_result(x, cached); 
+        return true; 
+    }
 
-    /* compute the giantstep */
-    EC_POINT* ECP_giantstep = EC_POINT_new(group); 
-    BIGNUM* BN_giantstep_size = BN_new(); 
-    BN_set_word(BN_giantstep_size, giantstep_size);
-    EC_POINT_mul(group, ECP_giantstep, NULL, g, BN_giantstep_size, bn_ctx); // set giantstep = g^giantstep_size
-    EC_POINT_invert(group, ECP_giantstep, bn_ctx);
- 
-    uint64_t sliced_loop_num = loop_num/DEC_THREAD_NUM; 
-    if(loop_num%DEC_THREAD_NUM != 0)
-    {
-        cout << "thread assignment fails" << endl; 
-        exit(EXIT_FAILURE); 
+    // if the interval contains 0 on both sides, the search runs in both directions from the identity
+    bool SIGNED = (lo < 0 && hi > 0);
+    SHANKS_LAYOUT layout[2];
+    if(SIGNED == true){
+        Shanks_signed_layout(layout, lo, hi, TABLE_SIZE);
     }
-    BIGNUM* BN_sliced_loop_num = BN_new();
-    BN_set_word(BN_sliced_loop_num, sliced_loop_num);
+    else{
+        layout[0] = layout[1] = Shanks_layout(lo, hi, TABLE_SIZE);
+    }
+    uint64_t loop_num = max(layout[0].loop_num, layout[1].loop_num);
 
-    EC_POINT* ECP_smallscale = EC_POINT_new(group); 
-    EC_POINT_mul(group, ECP_smallscale, NULL, ECP_giantstep, BN_sliced_loop_num, bn_ctx);
+    /* compute the giantstep */
+    EC_POINT* ECP_giantstep = EC_POINT_new(group); 
+    Shanks_giantstep(ECP_giantstep, g, TABLE_SIZE, bn_ctx);
 
     /* begin to search */
-    vector<uint64_t> i_index(DEC_THREAD_NUM); 
-    vector<uint64_t> j_index(DEC_THREAD_NUM);
-
-    // initialize searchpoint vector
-    vector<EC_POINT*> ECP_searchpoint(DEC_THREAD_NUM);
-    for (auto i = 0; i < DEC_THREAD_NUM; i++){
-        ECP_searchpoint[i] = EC_POINT_new(group);         
-    }   
-     
-    EC_POINT_copy(ECP_searchpoint[0], h);
-    for (auto i = 1; i < DEC_THREAD_NUM; i++){
-        EC_POINT_add(group, ECP_searchpoint[i], ECP_searchpoint[i-1], ECP_smallscale, bn_ctx);         
-    }
-    
+    vector<int64_t> result(DEC_THREAD_NUM); 
     vector<int> finding(DEC_THREAD_NUM, 0); 
-    int parallel_finding = 0; 
+    atomic<bool> stop(false); 
 
     // check if the hash map is empty
-    if(point2index_map.empty() == true)
+    if(HASHMAP_empty(point2index_map) == true)
     {
-        cout << "the hashmap is empty" << endl; 
+        cout << "the hashmap is empty" << endl;
         exit (EXIT_FAILURE);
     }
 
-    vector<thread> searchtask;
+    vector<function<void()>> searchtask;
     for(auto i = 0; i < DEC_THREAD_NUM; i++){ 
-        searchtask.push_back(std::thread(search_index, std::ref(ECP_searchpoint[i]), 
-                             std::ref(ECP_giantstep), std::ref(sliced_loop_num), 
-                             std::ref(i_index[i]), std::ref(j_index[i]), 
-                             std::ref(finding[i]), std::ref(parallel_finding)));
+        searchtask.push_back(bind(search_index, std::ref(g), std::ref(h), std::ref(ECP_giantstep), layout, SIGNED,
+                             i*loop_num/DEC_THREAD_NUM, (i+1)*loop_num/DEC_THREAD_NUM, 
+                             std::ref(result[i]), std::ref(finding[i]), std::ref(stop)));
     }
+    THREAD_POOL_run(searchtask);
 
-    for(auto i = 0; i < DEC_THREAD_NUM; i++){ 
-        searchtask[i].join(); 
-    }    
-
-    BIGNUM* BN_i = BN_new();
-    BIGNUM* BN_j = BN_new();
-
+    bool success = false; 
     for(auto i = 0; i < DEC_THREAD_NUM; i++)
-    { 
+    {
         if(finding[i] == 1)
         {
-            BN_set_word(BN_i, i_index[i]); 
-            BN_set_word(BN_j, j_index[i]+i*sliced_loop_num);             
+            Shanks_result(x, result[i]);
+            PLAINTEXT_CACHE_insert(g, h, result[i], bn_ctx); 
+            success = true; 
+            break; 
         }
-    }  
-
-    BN_mul(BN_j, BN_j, BN_giantstep_size, bn_ctx); 
-    BN_add(x, BN_i, BN_j); // x = i + j*giantstep_size; 
-
-    BN_free(BN_i); 
-    BN_free(BN_j);
+    }
 
     EC_POINT_free(ECP_giantstep); 
-    BN_free(BN_giantstep_size); 
-    BN_free(BN_sliced_loop_num); 
-
-    EC_POINT_free(ECP_smallscale); 
 
-    for (auto i = 0; i < DEC_THREAD_NUM; i++){
-        EC_POINT_free(ECP_searchpoint[i]);         
-    } 
-
-    return true; 
+    return success; 
 }
 
+#endif
@@ -10,19 +10,28 @@ this hpp implements standard ElGamal PKE scheme
 #include "../common/routines.hpp"
 
 #include "calculate_dlog.hpp"
+#include "kangaroo_dlog.hpp"
+#include "fast_mul.hpp"
+#include "secp256k1.hpp"
 
 const string hashmap_file  = "g_point2index.table"; // name of hashmap file
+const string kangaroo_file = "g_kangaroo.table";    // name of kangaroo table file
 
 // define the structure of PP
 struct ElGamal_PP
 {
-    size_t MSG_LEN; // the length of message space, also the length of the DLOG interval  
+    size_t MSG_LEN; // the bit length of the size of message space  
     BIGNUM *BN_MSG_SIZE; // the size of message space
-    size_t TUNNING; //increase this parameter in [0, RANGE_LEN/2]: larger table leads to less running time
+    int64_t MSG_LO; 
+    int64_t MSG_HI; // the message space [MSG_LO, MSG_HI), also the DLOG interval 
+    uint64_t TABLE_SIZE; // the number of baby steps: larger table leads to less running time
+    size_t TUNNING; // the log of TABLE_SIZE, or TABLE_SIZE = 2^{MSG_LEN/2 + TUNNING} if given to Setup
     size_t IO_THREAD_NUM; // optimized number of threads for faster building hash map 
     size_t DEC_THREAD_NUM; // optimized number of threads for faster decryption: CPU dependent
+    size_t DLOG_METHOD; // SHANKS, SHANKS_X_ONLY or KANGAROO: for KANGAROO the table holds 2^TUNNING distinguished points
 
     EC_POINT *g; 
+    ECP_Precompute_Table g_table; // fixed-base table of g built by Setup: X = g^r and the g^m part of Y
 };
 
 // define the structure of keypair
@@ -40,11 +49,25 @@ struct ElGamal_CT
 };
 
 
+/*
+** per-key decryption state: it caches -sk and the negated giant step, and owns its BN_CTX and 
+** scratch points, so that decryption does not allocate; use one decryptor per thread
+*/
+struct ElGamal_Decryptor
+{
+    BIGNUM *minus_sk;           // -sk mod order
+    EC_POINT *ECP_giantstep;    // -g^giantstep_size
+    EC_POINT *M;                // M = g^m
+    BN_CTX *ctx; 
+    SHANKS_CONTEXT sc; 
+};
+
 /* allocate memory for PP */ 
 void ElGamal_PP_new(ElGamal_PP &pp)
 { 
     pp.g = EC_POINT_new(group); 
     pp.BN_MSG_SIZE = BN_new(); 
+    ECP_Precompute_Table_new(pp.g_table); 
 }
 
 /* free memory of PP */ 
@@ -52,6 +75,7 @@ void ElGamal_PP_free(ElGamal_PP &pp)
 { 
     EC_POINT_free(pp.g);
     BN_free(pp.BN_MSG_SIZE); 
+    ECP_Precompute_Table_free(pp.g_table); 
 }
 
 void ElGamal_KP_new(ElGamal_KP &keypair)
@@ -82,7 +106,8 @@ void ElGamal_CT_free(ElGamal_CT &CT)
 void ElGamal_PP_print(ElGamal_PP &pp)
 {
     cout << "the length of message space = " << pp.MSG_LEN << endl; 
-    cout << "the tunning parameter for fast decryption = " << pp.TUNNING << endl;
+    cout << "the message space = [" << pp.MSG_LO << ", " << pp.MSG_HI << ")" << endl; 
+    cout << "the table size for fast decryption = " << pp.TABLE_SIZE << endl;
     ECP_print(pp.g, "pp.g"); 
 } 
 
@@ -112,23 +137,38 @@ void ElGamal_CT_deserialize(ElGamal_CT &CT, ifstream &fin)
 } 
 
 
-/* Setup algorithm */ 
-void ElGamal_Setup(ElGamal_PP &pp, size_t MSG_LEN, size_t TUNNING, 
-                   size_t IO_THREAD_NUM, size_t DEC_THREAD_NUM)
+/* 
+** Setup algorithm for the message space [MSG_LO, MSG_HI) with a table of TABLE_SIZE baby steps 
+** (KANGAROO: 2^floor(log TABLE_SIZE) distinguished points); neither has to be a power of two, 
+** so a tight bound on the messages means proportionally fewer giant steps 
+*/ 
+void ElGamal_Interval_Setup(ElGamal_PP &pp, int64_t MSG_LO, int64_t MSG_HI, uint64_t TABLE_SIZE, 
+                            size_t IO_THREAD_NUM, size_t DEC_THREAD_NUM, size_t DLOG_METHOD = SHANKS)
 { 
-    pp.MSG_LEN = MSG_LEN; 
-    pp.TUNNING = TUNNING; 
+    if(MSG_HI <= MSG_LO || TABLE_SIZE == 0)
+    {
+        cout << "the message space [" << MSG_LO << ", " << MSG_HI << ") or the table size is invalid" << endl; 
+        exit(EXIT_FAILURE); 
+    }
+    pp.MSG_LO = MSG_LO; 
+    pp.MSG_HI = MSG_HI; 
+    pp.TABLE_SIZE = TABLE_SIZE; 
+    pp.MSG_LEN = 0; 
+    for(uint64_t size = uint64_t(MSG_HI) - uint64_t(MSG_LO) - 1; size != 0; size >>= 1) pp.MSG_LEN++; 
+    pp.TUNNING = 0; 
+    for(uint64_t size = TABLE_SIZE; size > 1; size >>= 1) pp.TUNNING++; 
     pp.IO_THREAD_NUM = IO_THREAD_NUM; 
     pp.DEC_THREAD_NUM = DEC_THREAD_NUM; 
-    /* set the message space to 2^{MSG_LEN} */
-    BN_set_word(pp.BN_MSG_SIZE, uint64_t(pow(2, pp.MSG_LEN))); 
+    pp.DLOG_METHOD = DLOG_METHOD; 
+    /* set the size of message space to MSG_HI - MSG_LO */
+    BN_set_word(pp.BN_MSG_SIZE, uint64_t(MSG_HI) - uint64_t(MSG_LO)); 
 
     #ifdef DEBUG
-    cout << "message space = [0, ";   
-    cout << BN_bn2hex(pp.BN_MSG_SIZE) << ')' << endl; 
+    cout << "message space = [" << MSG_LO << ", " << MSG_HI << ")" << endl; 
     #endif
   
     EC_POINT_copy(pp.g, generator); 
+    ECP_Precompute_Table_build(pp.g_table, pp.g); 
 
     #ifdef DEBUG
     cout << "generate the public parameters for ElGamal >>>" << endl; 
@@ -136,17 +176,59 @@ void ElGamal_Setup(ElGamal_PP &pp, size_t MSG_LEN, size_t TUNNING,
     #endif
 }
 
-/* initialize the hashmap to accelerate decryption */
-void ElGamal_Initialize(ElGamal_PP &pp)
+/* Setup algorithm for the message space [0, 2^MSG_LEN), MSG_LEN <= 62 */ 
+void ElGamal_Setup(ElGamal_PP &pp, size_t MSG_LEN, size_t TUNNING, 
+                   size_t IO_THREAD_NUM, size_t DEC_THREAD_NUM, size_t DLOG_METHOD = SHANKS)
+{ 
+    // for KANGAROO the table holds 2^TUNNING distinguished points
+    uint64_t TABLE_SIZE = (DLOG_METHOD == KANGAROO) ? uint64_t(1) << TUNNING : Shanks_table_size(MSG_LEN, TUNNING); 
+    ElGamal_Interval_Setup(pp, 0, int64_t(1) << MSG_LEN, TABLE_SIZE, IO_THREAD_NUM, DEC_THREAD_NUM, DLOG_METHOD); 
+    pp.TUNNING = TUNNING; 
+}
+
+/* initialize the hashmap to accelerate decryption, TABLE_PLACEMENT (see HASHMAP_place) moves the mapped table to huge pages */
+void ElGamal_Initialize(ElGamal_PP &pp, int TABLE_PLACEMENT = HASHMAP_MAPPED)
 {
     cout << "initialize ElGamal Homomorphic PKE >>>" << endl; 
-    /* generate or load the point2index.table */
-    if(!FILE_exist(hashmap_file))
+    /* load the kangaroo table, (re)generate it if it is missing or built for other parameters */
+    if(pp.DLOG_METHOD == KANGAROO)
+    {
+        if(!KANGAROO_deserialize(pp.g, kangaroo_file, pp.MSG_LEN, pp.TUNNING)){
+            KANGAROO_serialize(pp.g, kangaroo_file, pp.MSG_LEN, pp.TUNNING, pp.IO_THREAD_NUM);
+        }
+        return; 
+    }
+
+    /* map the point2index.table, (re)generate it if it is missing or built for other parameters */
+    uint32_t mode = (pp.DLOG_METHOD == SHANKS_X_ONLY) ? HASHMAP_X_MODE : HASHMAP_XY_MODE; 
+    if(!FILE_exist(hashmap_file) || !HASHMAP_deserialize(pp.g, hashmap_file, pp.TABLE_SIZE, mode))
     {
         // generate and serialize the point_2_index table
-        Parallel_HASHMAP_serialize(pp.g, hashmap_file, pp.MSG_LEN, pp.TUNNING, pp.IO_THREAD_NUM); 
+        Parallel_HASHMAP_serialize(pp.g, hashmap_file, pp.TABLE_SIZE, pp.IO_THREAD_NUM, mode);
+        if(!HASHMAP_deserialize(pp.g, hashmap_file, pp.TABLE_SIZE, mode))    // map the table from file
+        {
+            cout << "fail to load the hash map" << endl;
+            exit(EXIT_FAILURE);
+        }
     }
-    HASHMAP_deserialize(hashmap_file, pp.MSG_LEN, pp.TUNNING);            // load the table from file 
+
+    /* back the table with huge pages and/or NUMA-local copies if asked to */
+    HASHMAP_place(point2index_map, TABLE_PLACEMENT); 
+
+    /* precompute the affine giant-step ladder, so that the candidates of the search are independent */
+    GIANTSTEP_LADDER_build(pp.g, pp.MSG_LO, pp.MSG_HI, pp.TABLE_SIZE); 
+
+    /* the small tier answers small |m| before the main table is probed */
+    SMALL_HASHMAP_build(pp.g, SMALL_TABLE_SIZE); 
+}
+
+/* 
+** enable the cache of recently decrypted messages in front of Shanks decryption (see plaintext_cache.hpp): 
+** at most capacity entries evicted by policy (CACHE_LRU or CACHE_FIFO), PLAINTEXT_CACHE_warmup preloads the expected messages
+*/
+void ElGamal_Cache_new(ElGamal_PP &pp, size_t capacity, int policy = CACHE_LRU)
+{
+    PLAINTEXT_CACHE_new(pp.g, capacity, policy); 
 }
 
 /* KeyGen algorithm */ 
@@ -169,8 +251,11 @@ void ElGamal_Enc(ElGamal_PP &pp, EC_POINT *&pk, BIGNUM *&m, ElGamal_CT &CT)
     BN_random(r);
 
     // begin encryption
-    EC_POINT_mul(group, CT.X, r, NULL, NULL, bn_ctx); // X = g^r
-    EC_POINT_mul(group, CT.Y, m, pk, r, bn_ctx);  // Y = pk^r g^m
+    EC_POINT *M = THREAD_POOL_context()->scratch[1]; 
+    ECP_Precompute_Table_mul(pp.g_table, CT.X, r, bn_ctx); // X = g^r
+    ECP_mul(CT.Y, pk, r, bn_ctx); // Y = pk^r
+    ECP_Precompute_Table_mul(pp.g_table, M, m, bn_ctx); // M = g^m
+    EC_POINT_add(group, CT.Y, CT.Y, M, bn_ctx);  // Y = pk^r g^m
     
     BN_free(r); 
 
@@ -184,8 +269,11 @@ void ElGamal_Enc(ElGamal_PP &pp, EC_POINT *&pk, BIGNUM *&m, ElGamal_CT &CT)
 void ElGamal_Enc(ElGamal_PP &pp, EC_POINT *&pk, BIGNUM *&m, BIGNUM *&r, ElGamal_CT &CT)
 { 
     // begin encryption
-    EC_POINT_mul(group, CT.X, r, NULL, NULL, bn_ctx); // X = g^r
-    EC_POINT_mul(group, CT.Y, m, pk, r, bn_ctx);  // Y = pk^r g^m
+    EC_POINT *M = THREAD_POOL_context()->scratch[1]; 
+    ECP_Precompute_Table_mul(pp.g_table, CT.X, r, bn_ctx); // X = g^r
+    ECP_mul(CT.Y, pk, r, bn_ctx); // Y = pk^r
+    ECP_Precompute_Table_mul(pp.g_table, M, m, bn_ctx); // M = g^m
+    EC_POINT_add(group, CT.Y, CT.Y, M, bn_ctx);  // Y = pk^r g^m
 
     #ifdef DEBUG
         cout << "ElGamal encryption finishes >>>"<< endl;
@@ -199,12 +287,14 @@ void ElGamal_Dec(ElGamal_PP &pp, BIGNUM *&sk, ElGamal_CT &CT, BIGNUM *&m)
     //begin decryption  
 
     EC_POINT *M = EC_POINT_new(group); 
-    EC_POINT_mul(group, M, NULL, CT.X, sk, bn_ctx); // M = X^{sk^} = pk^r 
+    ECP_mul(M, CT.X, sk, bn_ctx); // M = X^{sk^} = pk^r 
     EC_POINT_invert(group, M, bn_ctx);          // M = -pk^r
     EC_POINT_add(group, M, CT.Y, M, bn_ctx);    // M = g^m
 
     //Brute_Search(m, pp.h, M); 
-    bool success = Shanks_DLOG(m, pp.g, M, pp.MSG_LEN, pp.TUNNING); // use Shanks's algorithm to decrypt
+    bool success; 
+    if(pp.DLOG_METHOD == KANGAROO) success = Kangaroo_DLOG(m, M, pp.MSG_LO, pp.MSG_HI, bn_ctx); 
+    else success = Shanks_DLOG(m, pp.g, M, pp.MSG_LO, pp.MSG_HI, pp.TABLE_SIZE); // use Shanks's algorithm to decrypt
   
     EC_POINT_free(M);
     if(success == false)
@@ -214,18 +304,115 @@ void ElGamal_Dec(ElGamal_PP &pp, BIGNUM *&sk, ElGamal_CT &CT, BIGNUM *&m)
     }  
 }
 
+/* Signed decryption algorithm: m in the centred interval of the size of message space, [-2^{MSG_LEN-1}, 2^{MSG_LEN-1}) by default */ 
+void ElGamal_Signed_Dec(ElGamal_PP &pp, BIGNUM *&sk, ElGamal_CT &CT, BIGNUM *&m)
+{ 
+    EC_POINT *M = EC_POINT_new(group); 
+    ECP_mul(M, CT.X, sk, bn_ctx); // M = X^{sk^} = pk^r 
+    EC_POINT_invert(group, M, bn_ctx);          // M = -pk^r
+    EC_POINT_add(group, M, CT.Y, M, bn_ctx);    // M = g^m
+
+    bool success; 
+    int64_t half = (uint64_t(pp.MSG_HI) - uint64_t(pp.MSG_LO))/2; // the centred interval [-half, MSG_HI - MSG_LO - half)
+    int64_t lo = -half, hi = int64_t(uint64_t(pp.MSG_HI) - uint64_t(pp.MSG_LO) - half); 
+    if(pp.DLOG_METHOD == KANGAROO) success = Kangaroo_DLOG(m, M, lo, hi, bn_ctx); 
+    else success = Shanks_DLOG(m, pp.g, M, lo, hi, pp.TABLE_SIZE); 
+  
+    EC_POINT_free(M);
+    if(success == false)
+    {
+        cout << "decyption fails in the specified range"; 
+        exit(EXIT_FAILURE); 
+    }  
+}
+
+/*
+** progressive decryption: the sub-ranges of prior (the most likely first) are searched first, then the search 
+** widens up to the message space. return false if m is not in the message space; the prior is ignored by KANGAROO
+*/
+bool ElGamal_Progressive_Dec(ElGamal_PP &pp, BIGNUM *&sk, ElGamal_CT &CT, vector<DLOG_INTERVAL> &prior, BIGNUM *&m)
+{
+    EC_POINT *M = EC_POINT_new(group); 
+    ECP_mul(M, CT.X, sk, bn_ctx); // M = X^{sk} = pk^r 
+    EC_POINT_invert(group, M, bn_ctx);          // M = -pk^r
+    EC_POINT_add(group, M, CT.Y, M, bn_ctx);    // M = g^m
+
+    bool success; 
+    if(pp.DLOG_METHOD == KANGAROO) success = Kangaroo_DLOG(m, M, pp.MSG_LO, pp.MSG_HI, bn_ctx); 
+    else success = Progressive_Shanks_DLOG(m, pp.g, M, pp.MSG_LO, pp.MSG_HI, pp.TABLE_SIZE, prior); 
+
+    EC_POINT_free(M);
+    return success; 
+}
+
+/*
+** batch decryption: m[i] = Dec(sk, CT[i]) for all i, the DLOG of all ciphertexts is solved in one Shanks pass;
+** m[i] should be allocated by the caller, success[i] = 0 indicates m[i] is not in the specified range
+*/
+void ElGamal_Batch_Dec(ElGamal_PP &pp, BIGNUM *&sk, vector<ElGamal_CT> &CT, 
+                       vector<BIGNUM *> &m, vector<int> &success)
+{
+    vector<EC_POINT *> M(CT.size()); 
+    for(auto i = 0; i < CT.size(); i++){
+        M[i] = EC_POINT_new(group); 
+        ECP_mul(M[i], CT[i].X, sk, bn_ctx); // M = X^{sk} = pk^r 
+        EC_POINT_invert(group, M[i], bn_ctx);             // M = -pk^r
+        EC_POINT_add(group, M[i], CT[i].Y, M[i], bn_ctx); // M = g^m
+    }
+
+    if(pp.DLOG_METHOD == KANGAROO) Batch_Kangaroo_DLOG(m, M, pp.MSG_LO, pp.MSG_HI, success); 
+    else Batch_Shanks_DLOG(m, pp.g, M, pp.MSG_LO, pp.MSG_HI, pp.TABLE_SIZE, success); 
+
+    for(auto i = 0; i < M.size(); i++){
+        EC_POINT_free(M[i]); 
+    }
+}
+
+void ElGamal_Decryptor_new(ElGamal_PP &pp, BIGNUM *&sk, ElGamal_Decryptor &decryptor)
+{
+    decryptor.ctx = BN_CTX_new(); 
+    decryptor.minus_sk = BN_new(); 
+    BN_sub(decryptor.minus_sk, order, sk); // -sk mod order
+
+    decryptor.ECP_giantstep = EC_POINT_new(group); 
+    Shanks_giantstep(decryptor.ECP_giantstep, pp.g, pp.TABLE_SIZE, decryptor.ctx); 
+
+    decryptor.M = EC_POINT_new(group); 
+    SHANKS_CONTEXT_new(decryptor.sc, decryptor.ctx); 
+}
+
+void ElGamal_Decryptor_free(ElGamal_Decryptor &decryptor)
+{
+    SHANKS_CONTEXT_free(decryptor.sc); 
+    EC_POINT_free(decryptor.M); 
+    EC_POINT_free(decryptor.ECP_giantstep); 
+    BN_free(decryptor.minus_sk); 
+    BN_CTX_free(decryptor.ctx); 
+}
+
+/* decryption with a decryptor: success = false indicates m is not in the specified range */
+bool ElGamal_Decryptor_Dec(ElGamal_PP &pp, ElGamal_Decryptor &decryptor, ElGamal_CT &CT, BIGNUM *&m)
+{
+    ECP_mul(decryptor.M, CT.X, decryptor.minus_sk, decryptor.ctx);      // M = X^{-sk} = pk^{-r}
+    EC_POINT_add(group, decryptor.M, decryptor.M, CT.Y, decryptor.ctx); // M = Y X^{-sk} = g^m
+
+    if(pp.DLOG_METHOD == KANGAROO) return Kangaroo_DLOG(m, decryptor.M, pp.MSG_LO, pp.MSG_HI, decryptor.ctx); 
+    return Shanks_DLOG(m, pp.g, decryptor.M, decryptor.ECP_giantstep, pp.MSG_LO, pp.MSG_HI, pp.TABLE_SIZE, 
+                       decryptor.sc); 
+}
+
 /* rerandomize ciphertext CT with given randomness r */ 
 void ElGamal_ReRand(ElGamal_PP &pp, EC_POINT *&pk, BIGNUM *&sk, ElGamal_CT &CT, ElGamal_CT &CT_new, BIGNUM *&r)
 { 
     // begin partial decryption  
     EC_POINT *M = EC_POINT_new(group); 
-    EC_POINT_mul(group, M, NULL, CT.X, sk, bn_ctx); // M = X^{sk} = pk^r 
+    ECP_mul(M, CT.X, sk, bn_ctx); // M = X^{sk} = pk^r 
     EC_POINT_invert(group, M, bn_ctx);          // M = -pk^r
     EC_POINT_add(group, M, CT.Y, M, bn_ctx);    // M = g^m
 
     // begin re-encryption with the given randomness 
-    EC_POINT_mul(group, CT_new.X, r, NULL, NULL, bn_ctx); // CT_new.X = g^r 
-    EC_POINT_mul(group, CT_new.Y, NULL, pk, r, bn_ctx); // CT_new.Y = pk^r 
+    ECP_Precompute_Table_mul(pp.g_table, CT_new.X, r, bn_ctx); // CT_new.X = g^r 
+    ECP_mul(CT_new.Y, pk, r, bn_ctx); // CT_new.Y = pk^r 
 
     EC_POINT_add(group, CT_new.Y, CT_new.Y, M, bn_ctx);    // M = g^m
 
@@ -255,8 +442,8 @@ void ElGamal_HomoSub(ElGamal_CT &CT_result, ElGamal_CT &CT1, ElGamal_CT &CT2)
 /* scalar operation */
 void ElGamal_ScalarMul(ElGamal_CT &CT_result, ElGamal_CT &CT, BIGNUM *&k)
 { 
-    EC_POINT_mul(group, CT_result.X, NULL, CT.X, k, bn_ctx);  
-    EC_POINT_mul(group, CT_result.Y, NULL, CT.Y, k, bn_ctx);  
+    ECP_mul(CT_result.X, CT.X, k, bn_ctx);  
+    ECP_mul(CT_result.Y, CT.Y, k, bn_ctx);  
 }
 
 
@@ -265,17 +452,20 @@ void ElGamal_ScalarMul(ElGamal_CT &CT_result, ElGamal_CT &CT, BIGNUM *&k)
 // parallel encryption
 inline void exp_operation(EC_POINT *&RESULT, EC_POINT *&A, BIGNUM *&r) 
 { 
-    EC_POINT_mul(group, RESULT, NULL, A, r, NULL); // RESULT = A^r
+    ECP_mul(RESULT, A, r, THREAD_POOL_context()->bn_ctx); // RESULT = A^r
 } 
 
-inline void builtin_exp_operation(EC_POINT *&RESULT, BIGNUM *&r) 
+inline void fixed_base_exp_operation(EC_POINT *&RESULT, ElGamal_PP &pp, BIGNUM *&r) 
 { 
-    EC_POINT_mul(group, RESULT, r, NULL, NULL, NULL);  // RESULT = g^r 
+    ECP_Precompute_Table_mul(pp.g_table, RESULT, r, THREAD_POOL_context()->bn_ctx);  // RESULT = g^r 
 } 
 
-inline void multiexp_operation(EC_POINT *&RESULT, EC_POINT *&h, BIGNUM *&r, BIGNUM *&m) 
+inline void multiexp_operation(EC_POINT *&RESULT, ElGamal_PP &pp, EC_POINT *&h, BIGNUM *&r, BIGNUM *&m) 
 { 
-    EC_POINT_mul(group, RESULT, m, h, r, bn_ctx);  // Y = h^r g^m
+    EC_POINT *M = THREAD_POOL_context()->scratch[1]; 
+    ECP_mul(RESULT, h, r, THREAD_POOL_context()->bn_ctx); // Y = h^r
+    ECP_Precompute_Table_mul(pp.g_table, M, m, THREAD_POOL_context()->bn_ctx); // M = g^m
+    EC_POINT_add(group, RESULT, RESULT, M, THREAD_POOL_context()->bn_ctx);  // Y = h^r g^m
 } 
 
 /* Parallel Encryption algorithm: compute CT = Enc(pk, m; r) */
@@ -285,12 +475,9 @@ void ElGamal_Parallel_Enc(ElGamal_PP &pp, EC_POINT *&pk, BIGNUM *&m, ElGamal_CT
     BIGNUM *r = BN_new(); 
     BN_random(r);
 
-    thread enc_thread1(builtin_exp_operation, std::ref(CT.X), std::ref(r));    
-    thread enc_thread2(multiexp_operation, std::ref(CT.Y), std::ref(pk), std::ref(r), std::ref(m));
-
-    // synchronize threads
-    enc_thread1.join();                // pauses until first finishes
-    enc_thread2.join();               // pauses until second finishes
+    vector<function<void()>> task = {bind(fixed_base_exp_operation, std::ref(CT.X), std::ref(pp), std::ref(r)), 
+                                     bind(multiexp_operation, std::ref(CT.Y), std::ref(pp), std::ref(pk), std::ref(r), std::ref(m))}; 
+    THREAD_POOL_run(task); 
 
     BN_free(r); 
 }
@@ -301,11 +488,36 @@ void ElGamal_Parallel_Dec(ElGamal_PP &pp, BIGNUM *&sk, ElGamal_CT &CT, BIGNUM *&
 { 
     /* begin to decrypt */  
     EC_POINT *M = EC_POINT_new(group); 
-    EC_POINT_mul(group, M, NULL, CT.X, sk, bn_ctx); // M = X^{sk} = pk^r 
+    ECP_mul(M, CT.X, sk, bn_ctx); // M = X^{sk} = pk^r 
     EC_POINT_invert(group, M, bn_ctx);          // M = -pk^r
     EC_POINT_add(group, M, CT.Y, M, bn_ctx);    // M = g^m
 
-    bool success = Parallel_Shanks_DLOG(m, pp.g, M, pp.MSG_LEN, pp.TUNNING, pp.DEC_THREAD_NUM); // use Shanks's algorithm to decrypt
+    bool success; 
+    if(pp.DLOG_METHOD == KANGAROO) success = Parallel_Kangaroo_DLOG(m, M, pp.MSG_LO, pp.MSG_HI, pp.DEC_THREAD_NUM); 
+    else success = Parallel_Shanks_DLOG(m, pp.g, M, pp.MSG_LO, pp.MSG_HI, pp.TABLE_SIZE, pp.DEC_THREAD_NUM); // use Shanks's algorithm to decrypt
+  
+    EC_POINT_free(M);
+
+    if(success == false)
+    {
+        cout << "decyption fails: cannot find the message in the specified range"; 
+        exit(EXIT_FAILURE); 
+    }  
+}
+
+/* Signed decryption algorithm: m in the centred interval of the size of message space */
+void ElGamal_Parallel_Signed_Dec(ElGamal_PP &pp, BIGNUM *&sk, ElGamal_CT &CT, BIGNUM *&m)
+{ 
+    EC_POINT *M = EC_POINT_new(group); 
+    ECP_mul(M, CT.X, sk, bn_ctx); // M = X^{sk} = pk^r 
+    EC_POINT_invert(group, M, bn_ctx);          // M = -pk^r
+    EC_POINT_add(group, M, CT.Y, M, bn_ctx);    // M = g^m
+
+    bool success; 
+    int64_t half = (uint64_t(pp.MSG_HI) - uint64_t(pp.MSG_LO))/2; // the centred interval [-half, MSG_HI - MSG_LO - half)
+    int64_t lo = -half, hi = int64_t(uint64_t(pp.MSG_HI) - uint64_t(pp.MSG_LO) - half); 
+    if(pp.DLOG_METHOD == KANGAROO) success = Parallel_Kangaroo_DLOG(m, M, lo, hi, pp.DEC_THREAD_NUM); 
+    else success = Parallel_Shanks_DLOG(m, pp.g, M, lo, hi, pp.TABLE_SIZE, pp.DEC_THREAD_NUM); 
   
     EC_POINT_free(M);
 
@@ -322,16 +534,14 @@ void ElGamal_Parallel_ReRand(ElGamal_PP &pp, EC_POINT *&pk, BIGNUM *&sk, ElGamal
     /* partial decryption: only recover M = h^m */  
 
     EC_POINT *M = EC_POINT_new(group); 
-    EC_POINT_mul(group, M, NULL, CT.X, sk, bn_ctx); // M = X^{sk} = pk^r 
+    ECP_mul(M, CT.X, sk, bn_ctx); // M = X^{sk} = pk^r 
     EC_POINT_invert(group, M, bn_ctx);          // M = -pk^r
     EC_POINT_add(group, M, CT.Y, M, bn_ctx);    // M = g^m
 
     /* re-encryption with the given randomness */
-    thread rerand_thread1(exp_operation, std::ref(CT.Y), std::ref(pk), std::ref(r));
-    thread rerand_thread2(builtin_exp_operation, std::ref(CT.X), std::ref(r));
-
-    rerand_thread1.join(); 
-    rerand_thread2.join(); 
+    vector<function<void()>> task = {bind(exp_operation, std::ref(CT.Y), std::ref(pk), std::ref(r)), 
+                                     bind(fixed_base_exp_operation, std::ref(CT.X), std::ref(pp), std::ref(r))}; 
+    THREAD_POOL_run(task); 
 
     EC_POINT_add(group, CT_new.Y, CT_new.Y, M, bn_ctx);    // Y = pk^r g^m
 
@@ -341,42 +551,38 @@ void ElGamal_Parallel_ReRand(ElGamal_PP &pp, EC_POINT *&pk, BIGNUM *&sk, ElGamal
 /* parallel homomorphic add */
 inline void add_operation(EC_POINT *&RESULT, EC_POINT *&X, EC_POINT *&Y) 
 { 
-    EC_POINT_add(group, RESULT, X, Y, NULL);  
+    EC_POINT_add(group, RESULT, X, Y, THREAD_POOL_context()->bn_ctx);  
 } 
 
 void ElGamal_Parallel_HomoAdd(ElGamal_CT &CT_result, ElGamal_CT &CT1, ElGamal_CT &CT2)
 { 
-    thread add_thread1(add_operation, std::ref(CT_result.X), std::ref(CT1.X), std::ref(CT2.X));
-    thread add_thread2(add_operation, std::ref(CT_result.Y), std::ref(CT1.Y), std::ref(CT2.Y));
-
-    add_thread1.join(); 
-    add_thread2.join(); 
+    vector<function<void()>> task = {bind(add_operation, std::ref(CT_result.X), std::ref(CT1.X), std::ref(CT2.X)), 
+                                     bind(add_operation, std::ref(CT_result.Y), std::ref(CT1.Y), std::ref(CT2.Y))}; 
+    THREAD_POOL_run(task); 
 }
 
 /* parallel homomorphic sub */
 inline void sub_operation(EC_POINT *&RESULT, EC_POINT *&X, EC_POINT *&Y) 
 { 
-    EC_POINT_sub_without_bnctx(RESULT, X, Y);  
+    WORKER_CONTEXT *context = THREAD_POOL_context(); // the scratch point spares an allocation per call
+    EC_POINT_copy(context->scratch[0], Y); 
+    EC_POINT_invert(group, context->scratch[0], context->bn_ctx); 
+    EC_POINT_add(group, RESULT, X, context->scratch[0], context->bn_ctx); // RESULT = X - Y
 }
 
 void ElGamal_Parallel_HomoSub(ElGamal_CT &CT_result, ElGamal_CT &CT1, ElGamal_CT &CT2)
 { 
-    thread sub_thread1(sub_operation, std::ref(CT_result.X), std::ref(CT1.X), std::ref(CT2.X));
-    thread sub_thread2(sub_operation, std::ref(CT_result.Y), std::ref(CT1.Y), std::ref(CT2.Y));
-
-    sub_thread1.join(); 
-    sub_thread2.join(); 
+    vector<function<void()>> task = {bind(sub_operation, std::ref(CT_result.X), std::ref(CT1.X), std::ref(CT2.X)), 
+                                     bind(sub_operation, std::ref(CT_result.Y), std::ref(CT1.Y), std::ref(CT2.Y))}; 
+    THREAD_POOL_run(task); 
 }
 
 /* parallel scalar operation */
 void ElGamal_Parallel_ScalarMul(ElGamal_CT &CT_result, ElGamal_CT &CT, BIGNUM *&k)
 { 
-    thread scalar_thread1(exp_operation, std::ref(CT_result.X), std::ref(CT.X), std::ref(k));
-    thread scalar_thread2(exp_operation, std::ref(CT_result.Y), std::ref(CT.Y), std::ref(k));
-    
-    // synchronize threads
-    scalar_thread1.join(); 
-    scalar_thread2.join(); 
+    vector<function<void()>> task = {bind(exp_operation, std::ref(CT_result.X), std::ref(CT.X), std::ref(k)), 
+                                     bind(exp_operation, std::ref(CT_result.Y), std::ref(CT.Y), std::ref(k))}; 
+    THREAD_POOL_run(task); 
 }
 
 
@@ -1,558 +1,323 @@
-#include <string.h>
-#include <openssl/err.h>
-
-#include "internal/cryptlib.h"
-// #include "internal/bn_int.h"
-#include "ec_lcl.h"
-#include "internal/refcount.h"
-
-
-// /*
-//  * This file implements the wNAF-based interleaving multi-exponentiation method
-//  * Formerly at:
-//  *   http://www.informatik.tu-darmstadt.de/TI/Mitarbeiter/moeller.html#multiexp
-//  * You might now find it here:
-//  *   http://link.springer.com/chapter/10.1007%2F3-540-45537-X_13
-//  *   http://www.bmoeller.de/pdf/TI-01-08.multiexp.pdf
-//  * For multiplication with precomputation, we use wNAF splitting, formerly at:
-//  *   http://www.informatik.tu-darmstadt.de/TI/Mitarbeiter/moeller.html#fastexp
-//  */
-
-// /* structure for precomputed multiples of the generator */
-// struct ec_pre_comp_st {
-//     const EC_GROUP *group;      /* parent EC_GROUP object */
-//     size_t blocksize;           /* block size for wNAF splitting */
-//     size_t numblocks;           /* max. number of blocks for which we have
-//                                  * precomputation */
-//     size_t w;                   /* window size */
-//     EC_POINT **points;          /* array with pre-calculated multiples of
-//                                  * generator: 'num' pointers to EC_POINT
-//                                  * objects followed by a NULL */
-//     size_t num;                 /* numblocks * 2^(w-1) */
-//     CRYPTO_REF_COUNT references;
-//     CRYPTO_RWLOCK *lock;
-// };
-
-// static EC_PRE_COMP *ec_pre_comp_new(const EC_GROUP *group)
-// {
-//     EC_PRE_COMP *ret = NULL;
-
-//     if (!group)
-//         return NULL;
-
-//     ret = OPENSSL_zalloc(sizeof(*ret));
-//     if (ret == NULL) {
-//         ECerr(EC_F_EC_PRE_COMP_NEW, ERR_R_MALLOC_FAILURE);
-//         return ret;
-//     }
-
-//     ret->group = group;
-//     ret->blocksize = 8;         /* default */
-//     ret->w = 4;                 /* default */
-//     ret->references = 1;
-
-//     ret->lock = CRYPTO_THREAD_lock_new();
-//     if (ret->lock == NULL) {
-//         ECerr(EC_F_EC_PRE_COMP_NEW, ERR_R_MALLOC_FAILURE);
-//         OPENSSL_free(ret);
-//         return NULL;
-//     }
-//     return ret;
-// }
-
-// EC_PRE_COMP *EC_ec_pre_comp_dup(EC_PRE_COMP *pre)
-// {
-//     int i;
-//     if (pre != NULL)
-//         CRYPTO_UP_REF(&pre->references, &i, pre->lock);
-//     return pre;
-// }
-
-// void EC_ec_pre_comp_free(EC_PRE_COMP *pre)
-// {
-//     int i;
-
-//     if (pre == NULL)
-//         return;
-
-//     CRYPTO_DOWN_REF(&pre->references, &i, pre->lock);
-//     REF_PRINT_COUNT("EC_ec", pre);
-//     if (i > 0)
-//         return;
-//     REF_ASSERT_ISNT(i < 0);
-
-//     if (pre->points != NULL) {
-//         EC_POINT **pts;
-
-//         for (pts = pre->points; *pts != NULL; pts++)
-//             EC_POINT_free(*pts);
-//         OPENSSL_free(pre->points);
-//     }
-//     CRYPTO_THREAD_lock_free(pre->lock);
-//     OPENSSL_free(pre);
-// }
-
-// #define EC_POINT_BN_set_flags(P, flags) do { \
-//     BN_set_flags((P)->X, (flags)); \
-//     BN_set_flags((P)->Y, (flags)); \
-//     BN_set_flags((P)->Z, (flags)); \
-// } while(0)
-
-
-
-// #undef EC_POINT_BN_set_flags
-
-// /*
-//  * TODO: table should be optimised for the wNAF-based implementation,
-//  * sometimes smaller windows will give better performance (thus the
-//  * boundaries should be increased)
-//  */
-// #define EC_window_bits_for_scalar_size(b) \
-//                 ((size_t) \
-//                  ((b) >= 2000 ? 6 : \
-//                   (b) >=  800 ? 5 : \
-//                   (b) >=  300 ? 4 : \
-//                   (b) >=   70 ? 3 : \
-//                   (b) >=   20 ? 2 : \
-//                   1))
-
-/*-
- * Compute \sum scalars[i]*points[i], also including scalar*generator in the addition if scalar != NULL
- */
-int ec_wNAF_fast_mul(const EC_GROUP *group, EC_POINT *result, EC_POINT *fix_point, const BIGNUM *scalar, 
-        EC_PRE_COMP *pre_comp, BN_CTX *ctx)
+/****************************************************************************
+this hpp implements fixed-base scalar multiplication with a precomputed table
+*****************************************************************************
+* @author     This file is part of PGC, developed by Yu Chen
+* @paper      https://eprint.iacr.org/2019/319
+* @copyright  MIT license (see LICENSE file)
+*****************************************************************************/
+
+/*
+    fixed-base windowed method with signed digits: the scalar is recoded into window_num digits
+    d_i in [-2^{w-1}, 2^{w-1}] and base^k = sum_i d_i * 2^{w*i} * base, where every term is read
+    from the table, so a multiplication costs window_num additions and no doubling.
+    the table row i keeps d * 2^{w*i} * base for d in [1, 2^{w-1}] in affine form, it only relies
+    on the public API of OpenSSL and works for any base point (a recipient pk, pp.h, ...).
+    a table may cover only SCALAR_LEN < BIT_LEN bits, e.g. to encode short messages with a few rows.
+    on the native backends (GROUP_P256_NATIVE, GROUP_SECP256K1_GLV) the table keeps a native copy of its points,
+    and the digits are accumulated by native mixed additions into a Jacobian point.
+    ECP_Precompute_Table_mul2 evaluates base1^k1 base2^k2 (e.g. Y = g^r h^m) in one accumulation over two tables
+*/
+
+#ifndef __FAST_MUL__
+#define __FAST_MUL__
+
+#include "../common/global.hpp"
+#include "secp256k1.hpp"
+
+const size_t DEFAULT_WINDOW_SIZE = 8; // 33 rows of 128 points (roughly 1 MB in memory)
+
+struct ECP_Precompute_Table
 {
-    EC_POINT *tmp = NULL;
-
-    size_t pre_points_per_block = 0;
-    size_t i, j;
-    int k;
-    int result_is_inverted = 0;
-    int result_is_at_infinity = 1;
-    size_t *wsize = NULL;       /* individual window sizes */
-    signed char **wNAF = NULL;  /* individual wNAFs */
-    size_t *wNAF_len = NULL;
-    size_t max_len = 0;
-
-    EC_POINT **val = NULL;      /* precomputation */
-    EC_POINT **v;
-    EC_POINT ***val_sub = NULL; /* pointers to sub-arrays of 'val' or 'pre_comp->points' */
-    int num_scalar = 0;         /* flag: will be set to 1 if 'scalar' must be
-                                 * treated like other scalars, i.e.
-                                 * precomputation is not available */
-    int success = 0;
-
-    size_t num = 0; 
-
-    /* for wNAF splitting */
-    size_t blocksize = pre_comp->blocksize;
-
-    /*
-    * determine maximum number of blocks that wNAF splitting may
-    * yield (NB: maximum wNAF length is bit length plus one)
-    */
-    size_t numblocks = (BN_num_bits(scalar) / blocksize) + 1;
-
-    /*
-    * we cannot use more blocks than we have precomputation for
-    */
-    if (numblocks > pre_comp->numblocks) numblocks = pre_comp->numblocks;
-
-    pre_points_per_block = (size_t)1 << (pre_comp->w - 1);
-
-    /* check that pre_comp looks sane */
-    if (pre_comp->num != (pre_comp->numblocks * pre_points_per_block)) {
-        ECerr(EC_F_EC_WNAF_MUL, ERR_R_INTERNAL_ERROR);
-        goto err;
+    EC_POINT *base;
+    size_t scalar_len;      // the table serves scalars < 2^scalar_len, larger ones fall back to EC_POINT_mul
+    size_t window_size;     // w
+    size_t window_num;      // the number of signed digits: ceil(scalar_len/w) + 1 for the final carry
+    size_t row_size;        // 2^{w-1}
+    vector<EC_POINT *> point; // point[i*row_size + d-1] = d * 2^{w*i} * base
+    vector<P256_AFFINE> p256_point;           // point in native form if built for GROUP_P256_NATIVE, empty otherwise
+    vector<SECP256K1_AFFINE> secp256k1_point; // point in native form if built for GROUP_SECP256K1_GLV, empty otherwise
+    bool is_generator;      // base is the generator of the group
+};
+
+void ECP_Precompute_Table_new(ECP_Precompute_Table &table, size_t window_size = DEFAULT_WINDOW_SIZE, 
+                              size_t SCALAR_LEN = BIT_LEN)
+{
+    table.base = EC_POINT_new(group);
+    table.scalar_len = SCALAR_LEN;
+    table.window_size = window_size;
+    table.window_num = (SCALAR_LEN + window_size - 1)/window_size + 1;
+    table.row_size = (size_t)1 << (window_size - 1);
+    table.is_generator = false;
+    table.point.resize(table.window_num * table.row_size);
+    for(auto i = 0; i < table.point.size(); i++){
+        table.point[i] = EC_POINT_new(group);
     }
+}
 
-
-    size_t totalnum = numblocks;
-
-    wsize = OPENSSL_malloc(totalnum * sizeof(wsize[0]));
-    wNAF_len = OPENSSL_malloc(totalnum * sizeof(wNAF_len[0]));
-    /* include space for pivot */
-    wNAF = OPENSSL_malloc((totalnum + 1) * sizeof(wNAF[0]));
-    val_sub = OPENSSL_malloc(totalnum * sizeof(val_sub[0]));
-
-    /* Ensure wNAF is initialised in case we end up going to err */
-    if (wNAF != NULL)
-        wNAF[0] = NULL;         /* preliminary pivot */
-
-    if (wsize == NULL || wNAF_len == NULL || wNAF == NULL || val_sub == NULL) {
-        ECerr(EC_F_EC_WNAF_MUL, ERR_R_MALLOC_FAILURE);
-        goto err;
+void ECP_Precompute_Table_free(ECP_Precompute_Table &table)
+{
+    for(auto i = 0; i < table.point.size(); i++){
+        EC_POINT_free(table.point[i]);
     }
+    table.point.clear();
+    table.p256_point.clear();
+    table.secp256k1_point.clear();
+    EC_POINT_free(table.base);
+    table.base = NULL;
+}
 
-    /*
-     * num_val will be the total number of temporarily precomputed points
-     */
-    size_t num_val = 0;
-
-
-
-    signed char *tmp_wNAF = NULL;
-    size_t tmp_len = 0;
-
-    /*
-    * use the window size for which we have precomputation
-    */
-    wsize[num] = pre_comp->w;
-    tmp_wNAF = bn_compute_wNAF(scalar, wsize[num], &tmp_len);
-    if (!tmp_wNAF) goto err;
-
-    if (tmp_len <= max_len) {
-        /*
-        * One of the other wNAFs is at least as long as the wNAF
-        * belonging to the generator, so wNAF splitting will not buy us anything.
-        */
-
-        numblocks = 1;
-        totalnum = num + 1; /* don't use wNAF splitting */
-        wNAF[num] = tmp_wNAF;
-        wNAF[num + 1] = NULL;
-        wNAF_len[num] = tmp_len;
-        /*
-        * pre_comp->points starts with the points that we need here:
-        */
-        val_sub[num] = pre_comp->points;
-    } 
-    else {
-        /*
-        * don't include tmp_wNAF directly into wNAF array - use wNAF
-        * splitting and include the blocks
-        */
-
-        signed char *pp;
-        EC_POINT **tmp_points;
+/* the native copy of the points for the backend of the group (none for GROUP_OPENSSL) */
+void ECP_Precompute_Table_native(ECP_Precompute_Table &table)
+{
+    table.is_generator = (EC_POINT_cmp(group, table.base, generator, bn_ctx) == 0);
+    table.p256_point.clear();
+    table.secp256k1_point.clear();
+    if(group_backend == GROUP_P256_NATIVE){
+        table.p256_point.resize(table.point.size());
+        for(auto i = 0; i < table.point.size(); i++) P256_from_EC_POINT(table.p256_point[i], table.point[i], bn_ctx);
+    }
+    if(group_backend == GROUP_SECP256K1_GLV){
+        table.secp256k1_point.resize(table.point.size());
+        for(auto i = 0; i < table.point.size(); i++) SECP256K1_from_EC_POINT(table.secp256k1_point[i], table.point[i], bn_ctx);
+    }
+}
 
-        if (tmp_len < numblocks * blocksize) {
-            /*
-            * possibly we can do with fewer blocks than estimated
-            */
-            numblocks = (tmp_len + blocksize - 1) / blocksize;
-            if (numblocks > pre_comp->numblocks) {
-                ECerr(EC_F_EC_WNAF_MUL, ERR_R_INTERNAL_ERROR);
-                OPENSSL_free(tmp_wNAF);
-                goto err;
-            }
-            totalnum = num + numblocks;
+/* fill the table for base */
+void ECP_Precompute_Table_build(ECP_Precompute_Table &table, const EC_POINT *base)
+{
+    EC_POINT_copy(table.base, base);
+    EC_POINT *row_base = EC_POINT_new(group);
+    EC_POINT_copy(row_base, base);
+
+    for(auto i = 0; i < table.window_num; i++)
+    {
+        EC_POINT **row = table.point.data() + i*table.row_size;
+        EC_POINT_copy(row[0], row_base);
+        for(auto d = 1; d < table.row_size; d++){
+            EC_POINT_add(group, row[d], row[d-1], row_base, bn_ctx); // row[d] = (d+1) * row_base
         }
+        EC_POINT_dbl(group, row_base, row[table.row_size-1], bn_ctx); // row_base = 2^w * row_base
+    }
+    ECP_batch_make_affine(table.point.size(), table.point.data(), bn_ctx);
+    ECP_Precompute_Table_native(table);
 
-        /* split wNAF in 'numblocks' parts */
-        pp = tmp_wNAF;
-        tmp_points = pre_comp->points;
-
-        for (i = num; i < totalnum; i++) {
-            if (i < totalnum - 1) {
-                wNAF_len[i] = blocksize;
-                if (tmp_len < blocksize) {
-                    ECerr(EC_F_EC_WNAF_MUL, ERR_R_INTERNAL_ERROR);
-                    OPENSSL_free(tmp_wNAF);
-                    goto err;
-                }
-                tmp_len -= blocksize;
-                } else
-                /*
-                * last block gets whatever is left (this could be
-                * more or less than 'blocksize'!)
-                */
-                wNAF_len[i] = tmp_len;
-
-                wNAF[i + 1] = NULL;
-                wNAF[i] = OPENSSL_malloc(wNAF_len[i]);
-                if (wNAF[i] == NULL) {
-                    ECerr(EC_F_EC_WNAF_MUL, ERR_R_MALLOC_FAILURE);
-                    OPENSSL_free(tmp_wNAF);
-                    goto err;
-                }
-                memcpy(wNAF[i], pp, wNAF_len[i]);
-                if (wNAF_len[i] > max_len) max_len = wNAF_len[i];
+    EC_POINT_free(row_base);
+}
 
-                if (*tmp_points == NULL) {
-                    ECerr(EC_F_EC_WNAF_MUL, ERR_R_INTERNAL_ERROR);
-                    OPENSSL_free(tmp_wNAF);
-                    goto err;
-                }
-                val_sub[i] = tmp_points;
-                tmp_points += pre_points_per_block;
-                pp += blocksize;
-            }
-            OPENSSL_free(tmp_wNAF);
-            }
+/* recode the little-endian bytes of a scalar < 2^scalar_len into signed digits of window_size bits */
+void ECP_Precompute_Table_recode(ECP_Precompute_Table &table, const unsigned char *buffer, vector<int> &digit)
+{
+    int carry = 0;
+    int half = table.row_size;
+    for(auto i = 0; i < table.window_num; i++)
+    {
+        int d = carry;
+        for(auto b = 0; b < table.window_size; b++)
+        {
+            size_t bit = i*table.window_size + b;
+            if(bit < table.scalar_len) d += ((buffer[bit/8] >> (bit%8)) & 1) << b;
         }
+        carry = (d > half) ? 1 : 0;
+        digit[i] = d - (carry << table.window_size); // d in [-2^{w-1}, 2^{w-1}]
+    }
+}
 
-
-    /*
-     * All points we precompute now go into a single array 'val'.
-     * 'val_sub[i]' is a pointer to the subarray for the i-th point, or to a
-     * subarray of 'pre_comp->points' if we already have precomputation.
-     */
-    val = OPENSSL_malloc((num_val + 1) * sizeof(val[0]));
-    if (val == NULL) {
-        ECerr(EC_F_EC_WNAF_MUL, ERR_R_MALLOC_FAILURE);
-        goto err;
+/* 
+** result = sum_t sum_i digit[t][i] * 2^{w*i} * table[t]->base for t < table_num, zero digits cost nothing; 
+** the tables share one accumulator, which is native if every table has a native copy for the current backend
+*/
+void ECP_Precompute_Table_accumulate(ECP_Precompute_Table **table, vector<int> *digit, size_t table_num, 
+                                     EC_POINT *result, BN_CTX *ctx)
+{
+    bool P256_NATIVE = (group_backend == GROUP_P256_NATIVE); 
+    bool SECP256K1_NATIVE = (group_backend == GROUP_SECP256K1_GLV); 
+    for(auto t = 0; t < table_num; t++){
+        P256_NATIVE = P256_NATIVE && !table[t]->p256_point.empty(); 
+        SECP256K1_NATIVE = SECP256K1_NATIVE && !table[t]->secp256k1_point.empty(); 
     }
-    val[num_val] = NULL;        /* pivot element */
 
-    /* allocate points for precomputation */
-    v = val;
-    for (i = 0; i < num + num_scalar; i++) {
-        val_sub[i] = v;
-        for (j = 0; j < ((size_t)1 << (wsize[i] - 1)); j++) {
-            *v = EC_POINT_new(group);
-            if (*v == NULL)
-                goto err;
-            v++;
+    if(P256_NATIVE){
+        P256_JACOBIAN acc; 
+        acc.X = acc.Y = P256_R; 
+        acc.Z.v[0] = acc.Z.v[1] = acc.Z.v[2] = acc.Z.v[3] = 0; 
+        P256_AFFINE B; 
+        for(auto t = 0; t < table_num; t++){
+            for(auto i = 0; i < table[t]->window_num; i++){
+                int d = digit[t][i]; 
+                if(d == 0) continue; 
+                B = table[t]->p256_point[i*table[t]->row_size + abs(d)-1]; 
+                if(d < 0) P256_negate(B, B); 
+                P256_add_mixed(acc, acc, B); 
+            }
         }
+        P256_jacobian_to_EC_POINT(result, acc, ctx); 
+        return; 
     }
-    if (!(v == val + num_val)) {
-        ECerr(EC_F_EC_WNAF_MUL, ERR_R_INTERNAL_ERROR);
-        goto err;
-    }
-
-    if ((tmp = EC_POINT_new(group)) == NULL)
-        goto err;
-
-    if (!EC_POINTs_make_affine(group, num_val, val, ctx))
-        goto err;
-
-    result_is_at_infinity = 1;
 
-    for (k = max_len - 1; k >= 0; k--) {
-        if (!result_is_at_infinity) {
-            if (!EC_POINT_dbl(group, result, result, ctx))
-                goto err;
+    if(SECP256K1_NATIVE){
+        SECP256K1_JACOBIAN acc; 
+        SECP256K1_set_infinity(acc); 
+        SECP256K1_AFFINE B; 
+        for(auto t = 0; t < table_num; t++){
+            for(auto i = 0; i < table[t]->window_num; i++){
+                int d = digit[t][i]; 
+                if(d == 0) continue; 
+                B = table[t]->secp256k1_point[i*table[t]->row_size + abs(d)-1]; 
+                if(d < 0) SECP256K1_negate(B, B); 
+                SECP256K1_add_mixed(acc, acc, B); 
+            }
         }
+        SECP256K1_to_EC_POINT(result, acc, ctx); 
+        return; 
+    }
 
-        for (i = 0; i < totalnum; i++) {
-            if (wNAF_len[i] > (size_t)k) {
-                int digit = wNAF[i][k];
-                int is_neg;
-
-                if (digit) {
-                    is_neg = digit < 0;
-
-                    if (is_neg)
-                        digit = -digit;
-
-                    if (is_neg != resukt_is_inverted) {
-                        if (!result_is_at_infinity) {
-                            if (!EC_POINT_invert(group, result, ctx))
-                                goto err;
-                        }
-                        result_is_inverted = !result_is_inverted;
-                    }
-
-                    /* digit > 0 */
-
-                    if (result_is_at_infinity) {
-                        if (!EC_POINT_copy(result, val_sub[i][digit >> 1]))
-                            goto err;
-                        result_is_at_infinity = 0;
-                    } else {
-                        if (!EC_POINT_add
-                            (group, result, result, val_sub[i][digit >> 1], ctx))
-                            goto err;
-                    }
-                }
+    EC_POINT *temp = THREAD_POOL_context()->scratch[0];
+    EC_POINT_set_to_infinity(group, result);
+    for(auto t = 0; t < table_num; t++)
+    {
+        for(auto i = 0; i < table[t]->window_num; i++)
+        {
+            int d = digit[t][i]; 
+            if(d > 0){
+                EC_POINT_add(group, result, result, table[t]->point[i*table[t]->row_size + d-1], ctx);
+            }
+            if(d < 0){
+                EC_POINT_copy(temp, table[t]->point[i*table[t]->row_size - d-1]);
+                EC_POINT_invert(group, temp, ctx);
+                EC_POINT_add(group, result, result, temp, ctx);
             }
         }
     }
+}
 
-    if (result_is_at_infinity) {
-        if (!EC_POINT_set_to_infinity(group, result))
-            goto err;
-    } else {
-        if (result_is_inverted)
-            if (!EC_POINT_invert(group, result, ctx))
-                goto err;
-    }
+void ECP_Precompute_Table_accumulate(ECP_Precompute_Table &table, EC_POINT *result, vector<int> &digit, BN_CTX *ctx)
+{
+    ECP_Precompute_Table *table_list[1] = {&table}; 
+    ECP_Precompute_Table_accumulate(table_list, &digit, 1, result, ctx); 
+}
 
-    success = 1;
+/* the digits of scalar mod order: return false if it does not fit the table */
+bool ECP_Precompute_Table_recode(ECP_Precompute_Table &table, const BIGNUM *scalar, vector<int> &digit, BN_CTX *ctx)
+{
+    unsigned char buffer[BN_LEN];
+    BN_CTX_start(ctx);
+    BIGNUM *k = BN_CTX_get(ctx);
+    BN_nnmod(k, scalar, order, ctx);
+    bool FIT = (BN_num_bits(k) <= table.scalar_len);
+    if(FIT == true) BN_bn2lebinpad(k, buffer, BN_LEN);
+    BN_CTX_end(ctx);
+    if(FIT == false) return false;
 
- err:
-    EC_POINT_free(tmp);
-    OPENSSL_free(wsize);
-    OPENSSL_free(wNAF_len);
-    if (wNAF != NULL) {
-        signed char **w;
+    digit.resize(table.window_num);
+    ECP_Precompute_Table_recode(table, buffer, digit);
+    return true; 
+}
 
-        for (w = wNAF; *w != NULL; w++)
-            OPENSSL_free(*w);
+/* the precomputed generator table of nistz256 in OpenSSL is faster than a lookup with a single table */
+inline bool ECP_Precompute_Table_openssl(ECP_Precompute_Table &table)
+{
+    return table.is_generator == true && group_backend == GROUP_P256_NATIVE; 
+}
 
-        OPENSSL_free(wNAF);
+/* result = base^scalar, the caller must use a BN_CTX that belongs to the current thread */
+void ECP_Precompute_Table_mul(ECP_Precompute_Table &table, EC_POINT *result, const BIGNUM *scalar, BN_CTX *ctx)
+{
+    if(ECP_Precompute_Table_openssl(table) == true){
+        EC_POINT_mul(group, result, scalar, NULL, NULL, ctx);
+        return; 
     }
-    if (val != NULL) {
-        for (v = val; *v != NULL; v++)
-            EC_POINT_clear_free(*v);
-
-        OPENSSL_free(val);
+    vector<int> digit;
+    if(ECP_Precompute_Table_recode(table, scalar, digit, ctx) == false){
+        EC_POINT_mul(group, result, NULL, table.base, scalar, ctx);
+        return; 
     }
-    OPENSSL_free(val_sub);
-    return ret;
+    ECP_Precompute_Table_accumulate(table, result, digit, ctx);
 }
 
-/*-
- * ec_wNAF_precompute_mult()
- * creates an EC_PRE_COMP object with preprecomputed multiples of the generator
- * for use with wNAF splitting as implemented in ec_wNAF_mul().
- *
- * 'pre_comp->points' is an array of multiples of the generator of the following form:
- * points[0] =     generator;
- * points[1] = 3 * generator;
- * ...
- * points[2^(w-1)-1] =     (2^(w-1)-1) * generator;
- * points[2^(w-1)]   =     2^blocksize * generator;
- * points[2^(w-1)+1] = 3 * 2^blocksize * generator;
- * ...
- * points[2^(w-1)*(numblocks-1)-1] = (2^(w-1)) *  2^(blocksize*(numblocks-2)) * generator
- * points[2^(w-1)*(numblocks-1)]   =              2^(blocksize*(numblocks-1)) * generator
- * ...
- * points[2^(w-1)*numblocks-1]     = (2^(w-1)) *  2^(blocksize*(numblocks-1)) * generator
- * points[2^(w-1)*numblocks]       = NULL
- */
-int ec_wNAF_precompute_fast_mult(EC_GROUP *group, EC_POINT *fix_point, EC_PRE_COMP *pre_comp, BN_CTX *ctx)
+/* 
+** result = base1^k1 base2^k2 with the digits of both scalars in one accumulation, 
+** if a scalar does not fit its table both fall back to EC_POINT_mul
+*/
+void ECP_Precompute_Table_mul2(ECP_Precompute_Table &table1, ECP_Precompute_Table &table2, EC_POINT *result, 
+                               const BIGNUM *k1, const BIGNUM *k2, BN_CTX *ctx)
 {
-    EC_POINT *tmp_point = NULL, *base = NULL, **var;
-    const BIGNUM *order;
-    size_t i, bits, w, pre_points_per_block, blocksize, numblocks, num;
-    EC_POINT **points = NULL;
-
-    int success = 0;
-#ifndef FIPS_MODE
-    BN_CTX *new_ctx = NULL;
-#endif
-
-
-#ifndef FIPS_MODE
-    if (ctx == NULL)
-        ctx = new_ctx = BN_CTX_new();
-#endif
-    if (ctx == NULL)
-        goto err;
-
-    BN_CTX_start(ctx);
-
-    order = EC_GROUP_get0_order(group);
-    if (order == NULL)
-        goto err;
-    if (BN_is_zero(order)) {
-        ECerr(EC_F_EC_WNAF_PRECOMPUTE_MULT, EC_R_UNKNOWN_ORDER);
-        goto err;
-    }
-
-    bits = BN_num_bits(order);
-    /*
-     * The following parameters mean we precompute (approximately) one point per bit. 
-     * TBD: The combination 8, 4 is perfect for 160 bits; for other bit lengths, 
-     * other parameter combinations might provide better efficiency.
-     */
-    blocksize = 8;
-    w = 4;
-    if (EC_window_bits_for_scalar_size(bits) > w) {
-        /* let's not make the window too small ... */
-        w = EC_window_bits_for_scalar_size(bits);
+    vector<int> digit[2];
+    if(ECP_Precompute_Table_recode(table1, k1, digit[0], ctx) == false 
+       || ECP_Precompute_Table_recode(table2, k2, digit[1], ctx) == false){
+        EC_POINT *temp = EC_POINT_new(group); 
+        EC_POINT_mul(group, result, NULL, table1.base, k1, ctx); 
+        EC_POINT_mul(group, temp, NULL, table2.base, k2, ctx); 
+        EC_POINT_add(group, result, result, temp, ctx); 
+        EC_POINT_free(temp); 
+        return; 
     }
+    ECP_Precompute_Table *table_list[2] = {&table1, &table2}; 
+    ECP_Precompute_Table_accumulate(table_list, digit, 2, result, ctx); 
+}
 
-    numblocks = (bits + blocksize - 1) / blocksize; /* max. number of blocks
-                                                     * to use for wNAF
-                                                     * splitting */
-
-    pre_points_per_block = (size_t)1 << (w - 1);
-    num = pre_points_per_block * numblocks; /* number of points to compute
-                                             * and store */
-
-    points = OPENSSL_malloc(sizeof(*points) * (num + 1));
-    if (points == NULL) {
-        ECerr(EC_F_EC_WNAF_PRECOMPUTE_MULT, ERR_R_MALLOC_FAILURE);
-        goto err;
+/* result = base^scalar for a word-sized scalar, one that does not fit the table falls back to EC_POINT_mul */
+void ECP_Precompute_Table_mul(ECP_Precompute_Table &table, EC_POINT *result, uint64_t scalar, BN_CTX *ctx)
+{
+    if(table.scalar_len < 64 && (scalar >> table.scalar_len) != 0){
+        BN_CTX_start(ctx);
+        BIGNUM *k = BN_CTX_get(ctx);
+        BN_set_word(k, scalar);
+        EC_POINT_mul(group, result, NULL, table.base, k, ctx);
+        BN_CTX_end(ctx);
+        return;
     }
+    unsigned char buffer[BN_LEN] = {0};
+    for(auto i = 0; i < sizeof(uint64_t); i++) buffer[i] = (scalar >> (8*i)) & 0xFF;
 
-    var = points;
-    var[num] = NULL;            /* pivot */
-    for (i = 0; i < num; i++) {
-        if ((var[i] = EC_POINT_new(group)) == NULL) {
-            ECerr(EC_F_EC_WNAF_PRECOMPUTE_MULT, ERR_R_MALLOC_FAILURE);
-            goto err;
-        }
-    }
+    thread_local vector<int> digit; // reused: the confirmations of a search call this per table hit
+    digit.resize(table.window_num);
+    ECP_Precompute_Table_recode(table, buffer, digit);
+    ECP_Precompute_Table_accumulate(table, result, digit, ctx);
+}
 
-    if ((tmp_point = EC_POINT_new(group)) == NULL
-        || (base = EC_POINT_new(group)) == NULL) {
-        ECerr(EC_F_EC_WNAF_PRECOMPUTE_MULT, ERR_R_MALLOC_FAILURE);
-        goto err;
+/* the table is stored as its window size and scalar length, then the base and the points in uncompressed form */
+void ECP_Precompute_Table_serialize(ECP_Precompute_Table &table, ofstream &fout)
+{
+    const size_t UNCOMPRESSED_POINT_LEN = 2*BN_LEN + 1;
+    unsigned char buffer[UNCOMPRESSED_POINT_LEN];
+
+    uint64_t window_size = table.window_size;
+    uint64_t scalar_len = table.scalar_len;
+    fout.write(reinterpret_cast<char *>(&window_size), sizeof(window_size));
+    fout.write(reinterpret_cast<char *>(&scalar_len), sizeof(scalar_len));
+    EC_POINT_point2oct(group, table.base, POINT_CONVERSION_UNCOMPRESSED, buffer, UNCOMPRESSED_POINT_LEN, bn_ctx);
+    fout.write(reinterpret_cast<char *>(buffer), UNCOMPRESSED_POINT_LEN);
+    for(auto i = 0; i < table.point.size(); i++)
+    {
+        EC_POINT_point2oct(group, table.point[i], POINT_CONVERSION_UNCOMPRESSED, buffer, UNCOMPRESSED_POINT_LEN, bn_ctx);
+        fout.write(reinterpret_cast<char *>(buffer), UNCOMPRESSED_POINT_LEN);
     }
+}
 
-    if (!EC_POINT_copy(base, fix_point))
-        goto err;
-
-    /* do the precomputation */
-    for (i = 0; i < numblocks; i++) {
-        size_t j;
-
-        if (!EC_POINT_dbl(group, tmp_point, base, ctx))
-            goto err;
-
-        if (!EC_POINT_copy(*var++, base))
-            goto err;
-
-        for (j = 1; j < pre_points_per_block; j++, var++) {
-            /*
-             * calculate odd multiples of the current base point
-             */
-            if (!EC_POINT_add(group, *var, tmp_point, *(var - 1), ctx))
-                goto err;
-        }
-
-        if (i < numblocks - 1) {
-            /*
-             * get the next base (multiply current one by 2^blocksize)
-             */
-            size_t k;
-
-            if (blocksize <= 2) {
-                ECerr(EC_F_EC_WNAF_PRECOMPUTE_MULT, ERR_R_INTERNAL_ERROR);
-                goto err;
-            }
-
-            if (!EC_POINT_dbl(group, base, tmp_point, ctx))
-                goto err;
-            for (k = 2; k < blocksize; k++) {
-                if (!EC_POINT_dbl(group, base, base, ctx))
-                    goto err;
-            }
+/* the table is allocated here: return false if the stream is truncated or holds an invalid point */
+bool ECP_Precompute_Table_deserialize(ECP_Precompute_Table &table, ifstream &fin)
+{
+    const size_t UNCOMPRESSED_POINT_LEN = 2*BN_LEN + 1;
+    unsigned char buffer[UNCOMPRESSED_POINT_LEN];
+
+    uint64_t window_size = 0, scalar_len = 0;
+    fin.read(reinterpret_cast<char *>(&window_size), sizeof(window_size));
+    fin.read(reinterpret_cast<char *>(&scalar_len), sizeof(scalar_len));
+    if(!fin || window_size < 2 || window_size > 16 || scalar_len == 0 || scalar_len > BIT_LEN) return false;
+
+    ECP_Precompute_Table_new(table, window_size, scalar_len);
+    for(auto i = 0; i <= table.point.size(); i++)
+    {
+        EC_POINT *A = (i == 0) ? table.base : table.point[i-1];
+        fin.read(reinterpret_cast<char *>(buffer), UNCOMPRESSED_POINT_LEN);
+        if(!fin || EC_POINT_oct2point(group, A, buffer, UNCOMPRESSED_POINT_LEN, bn_ctx) != 1)
+        {
+            ECP_Precompute_Table_free(table);
+            return false;
         }
     }
-
-    if (!EC_POINTs_make_affine(group, num, points, ctx))
-        goto err;
-
-    pre_comp->group = group;
-    pre_comp->blocksize = blocksize;
-    pre_comp->numblocks = numblocks;
-    pre_comp->w = w;
-    pre_comp->points = points;
-    points = NULL;
-    pre_comp->num = num;
-    //SETPRECOMP(group, ec, pre_comp);
-    success = 1;
-
- err:
-    BN_CTX_end(ctx);
-#ifndef FIPS_MODE
-    BN_CTX_free(new_ctx);
-#endif
-    EC_ec_pre_comp_free(pre_comp);
-    if (points) {
-        EC_POINT **p;
-
-        for (p = points; *p != NULL; p++)
-            EC_POINT_free(*p);
-        OPENSSL_free(points);
-    }
-    EC_POINT_free(tmp_point);
-    EC_POINT_free(base);
-    return success;
+    ECP_Precompute_Table_native(table);
+    return true;
 }
 
+#endif
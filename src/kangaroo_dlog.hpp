@@ -0,0 +1,703 @@
+/****************************************************************************
+this hpp implements Pollard's kangaroo DLOG algorithm with precomputation
+*****************************************************************************
+* @author     This file is part of PGC, developed by Yu Chen
+* @paper      https://eprint.iacr.org/2019/319
+* @copyright  MIT license (see LICENSE file)
+*****************************************************************************/
+
+/*
+    kangaroo (lambda) algorithm for DLOG problem: given (g, h) find x \in [0, W = 2^RANGE_LEN) s.t. g^x = h,
+    with the distinguished-point precomputation of Bernstein and Lange (https://eprint.iacr.org/2012/458).
+
+    a walk jumps from P to P + g^{jump_size[k]}, where k is read from the fingerprint of P, so two walks
+    that meet once coincide afterwards. P is distinguished if the low DP_LEN bits of its fingerprint are 0.
+    precomputation: tame walks start at g^a for random a in [-W/4, W + W/4) and stop at their first distinguished
+    point D, the table keeps the fingerprint of D and its DLOG (walks move forward by about W/4 on average,
+    the starts on either side of [0, W) let the tame points cover it evenly up to its top, where the wild walks end).
+    search: a wild walk starts at h g^r and stops at its first distinguished point D = h g^{r+d},
+    if D is in the table with DLOG e then x = e - r - d, which is confirmed by recomputing g^x;
+    otherwise another wild walk starts from a fresh random r in [-W/8, 0], below h.
+    the walks are random: after KANGAROO_MAX_WALK_NUM wild walks a target is solved by a deterministic
+    sweep (Kangaroo_sweep) of at most 2^KANGAROO_SWEEP_LEN baby and giant steps each, so x is always found
+    for RANGE_LEN <= 2*KANGAROO_SWEEP_LEN = 40; a larger range is left to the walks, which rarely miss.
+
+    with T = 2^TABLE_LEN entries, DP_LEN = (RANGE_LEN - TABLE_LEN)/2 and a mean jump of sqrt(W*T)/4,
+    a search costs about 2*sqrt(W/T) additions in O(T) memory, while the table costs about sqrt(W*T)
+    additions once; it is saved to a file (prefixed by a header like the hashmap file) and loaded afterwards.
+    exponents are kept modulo 2^64: this is exact for x < 2^64, hence RANGE_LEN <= 64.
+    the walks are normalised KANGAROO_HERD_SIZE at a time, as in the Shanks search.
+*/
+
+#ifndef __KANGAROO_DLOG__
+#define __KANGAROO_DLOG__
+
+#include "calculate_dlog.hpp"
+#include <algorithm>
+#include <openssl/rand.h>
+
+const size_t KANGAROO_JUMP_LEN = 6; // 2^6 jumps, the index of a jump is the top 6 bits of the fingerprint
+const size_t KANGAROO_JUMP_NUM = 1 << KANGAROO_JUMP_LEN;
+const size_t KANGAROO_HERD_SIZE = 16; // the number of walks that take their steps together
+const size_t KANGAROO_MAX_WALK_NUM = 64; // the number of wild walks per target before giving up
+const size_t KANGAROO_MAX_WALK_LEN = 16; // a walk without distinguished point after 16*2^DP_LEN steps is restarted
+const size_t KANGAROO_SWEEP_LEN = 20; // the sweep of the fallback holds at most 2^20 baby steps (32 MB) and takes as many giant steps
+
+struct KANGAROO_Entry
+{
+    uint64_t key;   // fingerprint of the distinguished point
+    uint64_t value; // its DLOG w.r.t. g modulo 2^64
+};
+
+struct KANGAROO_TABLE
+{
+    size_t RANGE_LEN;
+    size_t TABLE_LEN;
+    size_t DP_LEN;
+    uint64_t range_mask;  // 2^RANGE_LEN - 1
+    uint64_t dp_mask;     // 2^DP_LEN - 1
+    uint64_t jump_size[KANGAROO_JUMP_NUM];
+    EC_POINT *jump[KANGAROO_JUMP_NUM];      // jump[k] = g^{jump_size[k]} in affine form
+    ECP_Precompute_Table base_table;        // fixed-base table of g for the starting points of the walks
+    vector<KANGAROO_Entry> entry;           // sorted by key
+    HASHMAP sweep_map;                      // baby steps g^i of the fallback, built on its first use
+    uint64_t sweep_size;                    // the number of baby steps in sweep_map, 0 before it is built
+    mutex sweep_mtx;                        // guards the build of sweep_map
+};
+
+KANGAROO_TABLE kangaroo_table; // the distinguished points of the tame walks w.r.t. g
+
+/* a mixing function of 64-bit words (splitmix64), it derives the jump sizes deterministically */
+inline uint64_t KANGAROO_mix(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/* a random exponent: the bits of mask are uniform, the others are 0 */
+inline uint64_t KANGAROO_random(uint64_t mask)
+{
+    uint64_t r;
+    RAND_bytes(reinterpret_cast<unsigned char *>(&r), sizeof(r));
+    return r & mask;
+}
+
+void KANGAROO_TABLE_free(KANGAROO_TABLE &table)
+{
+    if(table.base_table.base == NULL) return;
+    for(auto k = 0; k < KANGAROO_JUMP_NUM; k++){
+        EC_POINT_free(table.jump[k]);
+    }
+    ECP_Precompute_Table_free(table.base_table);
+    table.entry.clear();
+    if(table.sweep_size > 0) HASHMAP_free(table.sweep_map);
+    table.sweep_size = 0;
+}
+
+/* set the parameters and the jumps of an empty table for base g */
+void KANGAROO_TABLE_new(KANGAROO_TABLE &table, EC_POINT *&g, size_t RANGE_LEN, size_t TABLE_LEN)
+{
+    if(RANGE_LEN > 64 || TABLE_LEN >= RANGE_LEN)
+    {
+        cout << "kangaroo requires TABLE_LEN < RANGE_LEN <= 64" << endl;
+        exit(EXIT_FAILURE);
+    }
+    KANGAROO_TABLE_free(table);
+
+    table.RANGE_LEN = RANGE_LEN;
+    table.TABLE_LEN = TABLE_LEN;
+    table.DP_LEN = (RANGE_LEN - TABLE_LEN)/2;
+    table.range_mask = (RANGE_LEN == 64) ? ~0ULL : (1ULL << RANGE_LEN) - 1;
+    table.dp_mask = (1ULL << table.DP_LEN) - 1;
+
+    // jump sizes are uniform in [1, 2*mean_jump], mean_jump = sqrt(W*T)/4
+    double mean_jump = max(pow(2, (RANGE_LEN + TABLE_LEN)/2.0 - 2), 1.0);
+    uint64_t max_jump = uint64_t(2*mean_jump);
+    BIGNUM *BN_jump_size = BN_new();
+    for(auto k = 0; k < KANGAROO_JUMP_NUM; k++)
+    {
+        table.jump_size[k] = 1 + KANGAROO_mix(k) % max_jump;
+        table.jump[k] = EC_POINT_new(group);
+        BN_set_word(BN_jump_size, table.jump_size[k]);
+        EC_POINT_mul(group, table.jump[k], NULL, g, BN_jump_size, bn_ctx);
+    }
+    ECP_batch_make_affine(KANGAROO_JUMP_NUM, table.jump, bn_ctx);
+    BN_free(BN_jump_size);
+
+    // the tame walks start up to W + W/4, one bit beyond the range
+    ECP_Precompute_Table_new(table.base_table, DEFAULT_WINDOW_SIZE, min<size_t>(RANGE_LEN + 1, 64));
+    ECP_Precompute_Table_build(table.base_table, g);
+    table.sweep_size = 0;
+}
+
+/* point = g^a (g^{-a} if NEGATIVE) for a <= 2^RANGE_LEN - 1, the exponent is returned modulo 2^64 */
+inline uint64_t KANGAROO_power(KANGAROO_TABLE &table, EC_POINT *point, uint64_t a, bool NEGATIVE, BN_CTX *ctx)
+{
+    ECP_Precompute_Table_mul(table.base_table, point, a, ctx);
+    if(NEGATIVE == false) return a;
+    EC_POINT_invert(group, point, ctx);
+    return 0 - a;
+}
+
+/* point = g^a for a random a in [-W/4, W + W/4) (a in [-W/4, W) for W = 2^64, whose exponents wrap) */
+inline uint64_t KANGAROO_tame_start(KANGAROO_TABLE &table, EC_POINT *point, BN_CTX *ctx)
+{
+    bool NEGATIVE = (KANGAROO_random(~0ULL) % 6 == 0);
+    if(NEGATIVE == true) return KANGAROO_power(table, point, 1 + KANGAROO_random(table.range_mask >> 2), true, ctx);
+    if(table.RANGE_LEN == 64) return KANGAROO_power(table, point, KANGAROO_random(table.range_mask), false, ctx);
+    uint64_t top = table.range_mask + 1 + (table.range_mask >> 2) + 1; // W + W/4
+    return KANGAROO_power(table, point, KANGAROO_random(~0ULL) % top, false, ctx);
+}
+
+inline bool KANGAROO_distinguished(KANGAROO_TABLE &table, uint64_t fingerprint)
+{
+    return ((fingerprint >> 1) & table.dp_mask) == 0;
+}
+
+inline size_t KANGAROO_jump_index(uint64_t fingerprint)
+{
+    return fingerprint >> (64 - KANGAROO_JUMP_LEN);
+}
+
+inline bool KANGAROO_find(KANGAROO_TABLE &table, uint64_t key, uint64_t &value)
+{
+    auto it = lower_bound(table.entry.begin(), table.entry.end(), key,
+                          [](const KANGAROO_Entry &e, uint64_t k){ return e.key < k; });
+    if(it == table.entry.end() || it->key != key) return false;
+    value = it->value;
+    return true;
+}
+
+/*
+** tame walks: append the distinguished points to entry until it holds entry_num points or stop is set;
+** entry is shared by the tasks and guarded by mtx
+*/
+void KANGAROO_tame_walk(KANGAROO_TABLE &table, vector<KANGAROO_Entry> &entry, size_t entry_num,
+                        mutex &mtx, atomic<bool> &stop)
+{
+    BN_CTX *ctx = THREAD_POOL_context()->bn_ctx;
+    uint64_t max_walk_len = KANGAROO_MAX_WALK_LEN << table.DP_LEN;
+
+    EC_POINT *point[KANGAROO_HERD_SIZE];
+    uint64_t exponent[KANGAROO_HERD_SIZE]; // point = g^exponent
+    uint64_t step[KANGAROO_HERD_SIZE];
+    uint64_t fingerprint[KANGAROO_HERD_SIZE];
+    for(auto k = 0; k < KANGAROO_HERD_SIZE; k++){
+        point[k] = EC_POINT_new(group);
+        exponent[k] = KANGAROO_tame_start(table, point[k], ctx);
+        step[k] = 0;
+    }
+
+    while(stop == false)
+    {
+        ECP_batch_fingerprint(point, KANGAROO_HERD_SIZE, fingerprint, ctx);
+        for(auto k = 0; k < KANGAROO_HERD_SIZE; k++)
+        {
+            bool RESTART = (step[k] >= max_walk_len);
+            if(KANGAROO_distinguished(table, fingerprint[k]) == true)
+            {
+                lock_guard<mutex> lock(mtx);
+                if(entry.size() < entry_num) entry.push_back({fingerprint[k], exponent[k]});
+                if(entry.size() >= entry_num) stop = true;
+                RESTART = true;
+            }
+            if(RESTART == true)
+            {
+                exponent[k] = KANGAROO_tame_start(table, point[k], ctx);
+                step[k] = 0;
+                continue;
+            }
+            size_t index = KANGAROO_jump_index(fingerprint[k]);
+            EC_POINT_add(group, point[k], point[k], table.jump[index], ctx);
+            exponent[k] += table.jump_size[index];
+            step[k]++;
+        }
+    }
+
+    for(auto k = 0; k < KANGAROO_HERD_SIZE; k++){
+        EC_POINT_free(point[k]);
+    }
+}
+
+/* run the tame walks of the table with THREAD_NUM tasks until it holds 2^TABLE_LEN distinct points */
+void KANGAROO_TABLE_generate(KANGAROO_TABLE &table, size_t THREAD_NUM)
+{
+    uint64_t entry_num = 1ULL << table.TABLE_LEN;
+    table.entry.clear();
+    mutex mtx;
+    while(table.entry.size() < entry_num)
+    {
+        atomic<bool> stop(false);
+        vector<KANGAROO_Entry> entry;
+        vector<function<void()>> task;
+        for(auto i = 0; i < THREAD_NUM; i++){
+            task.push_back(bind(KANGAROO_tame_walk, std::ref(table), std::ref(entry),
+                                entry_num - table.entry.size(), std::ref(mtx), std::ref(stop)));
+        }
+        THREAD_POOL_run(task);
+
+        // tame walks that merge end at the same point: keep one of them
+        table.entry.insert(table.entry.end(), entry.begin(), entry.end());
+        sort(table.entry.begin(), table.entry.end(),
+             [](const KANGAROO_Entry &a, const KANGAROO_Entry &b){ return a.key < b.key; });
+        table.entry.erase(unique(table.entry.begin(), table.entry.end(),
+                                 [](const KANGAROO_Entry &a, const KANGAROO_Entry &b){ return a.key == b.key; }),
+                          table.entry.end());
+    }
+}
+
+/*
+    layout of the kangaroo table file (native byte order):
+    [KANGAROO_Header: 128 bytes][entry_num KANGAROO_Entry sorted by key]
+*/
+const char KANGAROO_MAGIC[8] = {'P', 'G', 'C', 'K', 'A', 'N', 'G', '\0'};
+const uint32_t KANGAROO_VERSION = 2; // 2: the tame walks start up to W + W/4
+
+struct KANGAROO_Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t curve_id;  // NID of the elliptic curve
+    uint32_t RANGE_LEN;
+    uint32_t TABLE_LEN;
+    uint64_t entry_num;
+    uint64_t checksum;  // checksum of the header (with checksum = 0) followed by the entries
+    unsigned char base_point[POINT_LEN]; // compressed g
+    unsigned char reserved[128 - 40 - POINT_LEN];
+};
+
+static_assert(sizeof(KANGAROO_Header) == 128, "the header of kangaroo table file must be 128 bytes");
+
+void KANGAROO_Header_new(KANGAROO_Header &header, EC_POINT *&g, size_t RANGE_LEN, size_t TABLE_LEN, uint64_t entry_num)
+{
+    memset(&header, 0, sizeof(KANGAROO_Header));
+    memcpy(header.magic, KANGAROO_MAGIC, sizeof(KANGAROO_MAGIC));
+    header.version = KANGAROO_VERSION;
+    header.curve_id = EC_GROUP_get_curve_name(group);
+    header.RANGE_LEN = RANGE_LEN;
+    header.TABLE_LEN = TABLE_LEN;
+    header.entry_num = entry_num;
+    EC_POINT_point2oct(group, g, POINT_CONVERSION_COMPRESSED, header.base_point, POINT_LEN, bn_ctx);
+}
+
+inline uint64_t KANGAROO_checksum(KANGAROO_Header header, vector<KANGAROO_Entry> &entry)
+{
+    header.checksum = 0;
+    uint64_t checksum = HASHMAP_checksum(0xcbf29ce484222325ULL, reinterpret_cast<unsigned char *>(&header),
+                                         sizeof(KANGAROO_Header));
+    return HASHMAP_checksum(checksum, reinterpret_cast<unsigned char *>(entry.data()),
+                            entry.size()*sizeof(KANGAROO_Entry));
+}
+
+/* generate the table for (g, RANGE_LEN, TABLE_LEN) and save it to kangaroo_file */
+void KANGAROO_serialize(EC_POINT *&g, string kangaroo_file, size_t RANGE_LEN, size_t TABLE_LEN, size_t THREAD_NUM)
+{
+    cout << "generate and serialize the kangaroo table >>>" << endl;
+    auto start_time = chrono::steady_clock::now(); // start to count the time
+
+    KANGAROO_TABLE_new(kangaroo_table, g, RANGE_LEN, TABLE_LEN);
+    KANGAROO_TABLE_generate(kangaroo_table, THREAD_NUM);
+
+    KANGAROO_Header header;
+    KANGAROO_Header_new(header, g, RANGE_LEN, TABLE_LEN, kangaroo_table.entry.size());
+    header.checksum = KANGAROO_checksum(header, kangaroo_table.entry);
+
+    // write to a temporary file first, so a process loading the old file is not affected
+    string temp_file = kangaroo_file + ".tmp";
+    ofstream fout(temp_file, ios::binary);
+    if(!fout)
+    {
+        cout << temp_file << " open error" << endl;
+        exit(EXIT_FAILURE);
+    }
+    fout.write(reinterpret_cast<char *>(&header), sizeof(KANGAROO_Header));
+    fout.write(reinterpret_cast<char *>(kangaroo_table.entry.data()),
+               kangaroo_table.entry.size()*sizeof(KANGAROO_Entry));
+    fout.close();
+    if(!fout || rename(temp_file.c_str(), kangaroo_file.c_str()) != 0)
+    {
+        cout << kangaroo_file << " write error" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    auto end_time = chrono::steady_clock::now(); // end to count the time
+    auto running_time = end_time - start_time;
+    cout << "kangaroo table generation takes time = "
+    << chrono::duration <double, milli> (running_time).count() << " ms" << endl;
+}
+
+/* load kangaroo_file: return false if it is missing, corrupted or does not match g, RANGE_LEN and TABLE_LEN */
+bool KANGAROO_deserialize(EC_POINT *&g, string kangaroo_file, size_t RANGE_LEN, size_t TABLE_LEN)
+{
+    ifstream fin(kangaroo_file, ios::binary);
+    if(!fin) return false;
+
+    cout << "kangaroo table already exists, begin to load it >>>" << endl;
+    auto start_time = chrono::steady_clock::now(); // start to count the time
+
+    KANGAROO_Header header, expected_header;
+    fin.read(reinterpret_cast<char *>(&header), sizeof(KANGAROO_Header));
+    KANGAROO_Header_new(expected_header, g, RANGE_LEN, TABLE_LEN, header.entry_num);
+    if(!fin || memcmp(header.magic, expected_header.magic, sizeof(KANGAROO_MAGIC)) != 0
+       || header.version != expected_header.version || header.curve_id != expected_header.curve_id
+       || header.RANGE_LEN != RANGE_LEN || header.TABLE_LEN != TABLE_LEN
+       || header.entry_num != (1ULL << TABLE_LEN)
+       || memcmp(header.base_point, expected_header.base_point, POINT_LEN) != 0)
+    {
+        cout << kangaroo_file << " does not match the public parameters" << endl;
+        return false;
+    }
+
+    KANGAROO_TABLE_new(kangaroo_table, g, RANGE_LEN, TABLE_LEN);
+    kangaroo_table.entry.resize(header.entry_num);
+    fin.read(reinterpret_cast<char *>(kangaroo_table.entry.data()), header.entry_num*sizeof(KANGAROO_Entry));
+    if(!fin || KANGAROO_checksum(header, kangaroo_table.entry) != header.checksum)
+    {
+        cout << kangaroo_file << " checksum error" << endl;
+        KANGAROO_TABLE_free(kangaroo_table);
+        return false;
+    }
+
+    auto end_time = chrono::steady_clock::now(); // end to count the time
+    auto running_time = end_time - start_time;
+    cout << "kangaroo table loading takes time = "
+    << chrono::duration <double, milli> (running_time).count() << " ms" << endl;
+    return true;
+}
+
+/*
+** wild walks for the targets h[t]: the herd is shared by the unsolved targets in turn, each target gets at most
+** MAX_WALK_NUM walks. with FROM_TARGET the first walk of a target starts at h[t] itself, the others start at
+** h[t] g^{-r} for random r in [0, W/8].
+** x[t] and finding[t] are written for the solved targets; the search ends early once stop is set
+*/
+void Kangaroo_search(KANGAROO_TABLE &table, vector<EC_POINT *> &h, vector<uint64_t> &x, vector<int> &finding,
+                     size_t HERD_SIZE, size_t MAX_WALK_NUM, bool FROM_TARGET, atomic<bool> &stop, BN_CTX *ctx)
+{
+    size_t target_num = h.size();
+    uint64_t max_walk_len = KANGAROO_MAX_WALK_LEN << table.DP_LEN;
+    const size_t IDLE = SIZE_MAX;
+
+    vector<size_t> walk_num(target_num, 0);
+    size_t next_target = 0; // round robin over the targets
+
+    vector<EC_POINT *> point(HERD_SIZE);
+    vector<size_t> target(HERD_SIZE, IDLE);
+    vector<uint64_t> offset(HERD_SIZE);   // point = h[target] g^offset, offset is modulo 2^64
+    vector<uint64_t> step(HERD_SIZE);
+    vector<uint64_t> fingerprint(HERD_SIZE);
+    for(auto k = 0; k < HERD_SIZE; k++){
+        point[k] = EC_POINT_new(group);
+    }
+    EC_POINT *verifier = EC_POINT_new(group);
+
+    // start a new walk in slot k, the slot becomes idle if no target needs one
+    auto start_walk = [&](size_t k)
+    {
+        target[k] = IDLE;
+        for(auto n = 0; n < target_num; n++)
+        {
+            size_t t = (next_target + n) % target_num;
+            if(finding[t] == 1 || walk_num[t] >= MAX_WALK_NUM) continue;
+            uint64_t r = (FROM_TARGET == true && walk_num[t] == 0) ? 0 : KANGAROO_random(table.range_mask >> 3);
+            offset[k] = KANGAROO_power(table, point[k], r, true, ctx);
+            EC_POINT_add(group, point[k], point[k], h[t], ctx);
+            step[k] = 0;
+            target[k] = t;
+            walk_num[t]++;
+            next_target = (t + 1) % target_num;
+            return;
+        }
+    };
+
+    for(auto k = 0; k < HERD_SIZE; k++) start_walk(k);
+
+    while(stop == false)
+    {
+        // gather the walking slots at the front
+        size_t herd_num = 0;
+        for(auto k = 0; k < HERD_SIZE; k++)
+        {
+            if(target[k] != IDLE && finding[target[k]] == 1) start_walk(k); // its target is solved by another walk
+            if(target[k] == IDLE) continue;
+            swap(point[herd_num], point[k]); swap(target[herd_num], target[k]);
+            swap(offset[herd_num], offset[k]); swap(step[herd_num], step[k]);
+            herd_num++;
+        }
+        if(herd_num == 0) break;
+
+        ECP_batch_fingerprint(point.data(), herd_num, fingerprint.data(), ctx);
+        for(auto k = 0; k < herd_num; k++)
+        {
+            size_t t = target[k];
+            if(finding[t] == 1) continue; // solved in this round
+            bool RESTART = (step[k] >= max_walk_len || fingerprint[k] == 0);
+            uint64_t value;
+            if(RESTART == false && KANGAROO_distinguished(table, fingerprint[k]) == true)
+            {
+                // x = e - offset, where e is the DLOG of the distinguished point
+                if(KANGAROO_find(table, fingerprint[k], value) == true)
+                {
+                    uint64_t candidate = value - offset[k];
+                    if((candidate & ~table.range_mask) == 0)
+                    {
+                        ECP_Precompute_Table_mul(table.base_table, verifier, candidate, ctx);
+                        if(EC_POINT_cmp(group, verifier, h[t], ctx) == 0)
+                        {
+                            x[t] = candidate;
+                            finding[t] = 1;
+                        }
+                    }
+                }
+                RESTART = true;
+            }
+            if(RESTART == true)
+            {
+                start_walk(k);
+                continue;
+            }
+            size_t index = KANGAROO_jump_index(fingerprint[k]);
+            EC_POINT_add(group, point[k], point[k], table.jump[index], ctx);
+            offset[k] += table.jump_size[index];
+            step[k]++;
+        }
+    }
+
+    for(auto k = 0; k < HERD_SIZE; k++){
+        EC_POINT_free(point[k]);
+    }
+    EC_POINT_free(verifier);
+}
+
+/* 
+** the baby steps g^i of the sweep for i < 2^min(ceil(RANGE_LEN/2), KANGAROO_SWEEP_LEN), 
+** built once by the first target that needs them 
+*/
+void KANGAROO_sweep_build(KANGAROO_TABLE &table, BN_CTX *ctx)
+{
+    lock_guard<mutex> lock(table.sweep_mtx);
+    if(table.sweep_size > 0) return;
+
+    uint64_t sweep_size = 1ULL << min<size_t>((table.RANGE_LEN + 1)/2, KANGAROO_SWEEP_LEN);
+    HASHMAP_new(table.sweep_map, sweep_size);
+    EC_POINT *A[SEARCH_BATCH_SIZE];
+    uint64_t fingerprint[SEARCH_BATCH_SIZE];
+    for(auto k = 0; k < SEARCH_BATCH_SIZE; k++) A[k] = EC_POINT_new(group);
+    EC_POINT *walk = EC_POINT_new(group);
+    EC_POINT_set_to_infinity(group, walk);
+    for(uint64_t base = 0; base < sweep_size; base += SEARCH_BATCH_SIZE)
+    {
+        size_t num = min<uint64_t>(SEARCH_BATCH_SIZE, sweep_size - base);
+        for(auto k = 0; k < num; k++){
+            EC_POINT_copy(A[k], walk);
+            EC_POINT_add(group, walk, walk, table.base_table.base, ctx);
+        }
+        ECP_batch_fingerprint(A, num, fingerprint, ctx);
+        for(auto k = 0; k < num; k++) HASHMAP_insert(table.sweep_map, fingerprint[k], uint32_t(base + k));
+    }
+    for(auto k = 0; k < SEARCH_BATCH_SIZE; k++) EC_POINT_free(A[k]);
+    EC_POINT_free(walk);
+    table.sweep_size = sweep_size;
+}
+
+/*
+** the deterministic fallback of the walks: find x in [0, RANGE) with g^x = h by giant steps h - j*S*g over 
+** the S baby steps of the sweep, which costs up to RANGE/S additions (S = 2^20 for RANGE_LEN >= 40); 
+** the walks miss a target rarely, so the sweep is the last resort rather than the decoder.
+** its time is bounded: a range of more than 2^KANGAROO_SWEEP_LEN giant steps is not swept and false is returned
+*/
+bool Kangaroo_sweep(KANGAROO_TABLE &table, EC_POINT *h, uint64_t RANGE, uint64_t &x, BN_CTX *ctx)
+{
+    uint64_t sweep_size = 1ULL << min<size_t>((table.RANGE_LEN + 1)/2, KANGAROO_SWEEP_LEN);
+    if((RANGE - 1)/sweep_size >= (1ULL << KANGAROO_SWEEP_LEN)) return false;
+    KANGAROO_sweep_build(table, ctx);
+
+    BN_CTX_start(ctx);
+    BIGNUM *BN_giantstep = BN_CTX_get(ctx);
+    EC_POINT *giantstep = EC_POINT_new(group);
+    BN_set_word(BN_giantstep, table.sweep_size);
+    EC_POINT_mul(group, giantstep, NULL, table.base_table.base, BN_giantstep, ctx);
+    EC_POINT_invert(group, giantstep, ctx); // -S*g
+    BN_CTX_end(ctx);
+
+    EC_POINT *candidate[SEARCH_BATCH_SIZE];
+    uint64_t fingerprint[SEARCH_BATCH_SIZE];
+    for(auto k = 0; k < SEARCH_BATCH_SIZE; k++) candidate[k] = EC_POINT_new(group);
+    EC_POINT *searchpoint = EC_POINT_dup(h, group);
+    EC_POINT *verifier = EC_POINT_new(group);
+
+    bool finding = false;
+    uint64_t loop_num = (RANGE - 1)/table.sweep_size + 1;
+    for(uint64_t j = 0; j < loop_num && finding == false; j += SEARCH_BATCH_SIZE)
+    {
+        size_t num = min<uint64_t>(SEARCH_BATCH_SIZE, loop_num - j);
+        for(auto k = 0; k < num; k++){
+            EC_POINT_copy(candidate[k], searchpoint);
+            EC_POINT_add(group, searchpoint, searchpoint, giantstep, ctx);
+        }
+        ECP_batch_fingerprint(candidate, num, fingerprint, ctx);
+        for(auto k = 0; k < num && finding == false; k++)
+        {
+            uint64_t i, slot = HASHMAP_FIRST_SLOT;
+            while(finding == false && HASHMAP_find_next(table.sweep_map, fingerprint[k], slot, i) == true)
+            {
+                uint64_t candidate_x = (j + k)*table.sweep_size + i;
+                if(candidate_x >= RANGE) continue;
+                ECP_Precompute_Table_mul(table.base_table, verifier, candidate_x, ctx);
+                if(EC_POINT_cmp(group, verifier, h, ctx) != 0) continue;
+                x = candidate_x;
+                finding = true;
+            }
+        }
+    }
+
+    for(auto k = 0; k < SEARCH_BATCH_SIZE; k++) EC_POINT_free(candidate[k]);
+    EC_POINT_free(searchpoint);
+    EC_POINT_free(verifier);
+    EC_POINT_free(giantstep);
+    return finding;
+}
+
+inline void KANGAROO_check(KANGAROO_TABLE &table)
+{
+    if(table.entry.empty() == true)
+    {
+        cout << "the kangaroo table is empty" << endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* 
+** the walks search [0, 2^RANGE_LEN): x in [lo, hi) is found as x - lo for target = h*g^{-lo}, 
+** which requires hi - lo <= 2^RANGE_LEN. the walks are random, so unlike the Shanks search 
+** a small |x| is not found any sooner when the interval contains 0
+*/
+void Kangaroo_shift(EC_POINT *target, EC_POINT *&h, int64_t lo, int64_t hi, BN_CTX *ctx)
+{
+    if(hi <= lo || uint64_t(hi) - uint64_t(lo) - 1 > kangaroo_table.range_mask)
+    {
+        cout << "the DLOG interval [" << lo << ", " << hi << ") does not fit the kangaroo table" << endl;
+        exit(EXIT_FAILURE);
+    }
+    if(lo == 0){
+        EC_POINT_copy(target, h);
+        return;
+    }
+    BN_CTX_start(ctx);
+    BIGNUM *BN_lo = BN_CTX_get(ctx);
+    BN_set_word(BN_lo, (lo < 0) ? -uint64_t(lo) : uint64_t(lo));
+    ECP_Precompute_Table_mul(kangaroo_table.base_table, target, BN_lo, ctx); // target = g^|lo|
+    if(lo > 0) EC_POINT_invert(group, target, ctx);
+    EC_POINT_add(group, target, target, h, ctx);
+    BN_CTX_end(ctx);
+}
+
+/* x = lo + result, unless result is out of [0, hi - lo) */
+inline bool Kangaroo_result(BIGNUM *&x, uint64_t result, int64_t lo, int64_t hi)
+{
+    if(result >= uint64_t(hi) - uint64_t(lo)) return false;
+    int64_t value = int64_t(uint64_t(lo) + result);
+    BN_set_word(x, (value < 0) ? -uint64_t(value) : uint64_t(value));
+    BN_set_negative(x, value < 0);
+    return true;
+}
+
+/* compute x in [lo, hi) s.t. g^x = h with the kangaroo table of g, return false if x is not found */
+bool Kangaroo_DLOG(BIGNUM *&x, EC_POINT *&h, int64_t lo, int64_t hi, BN_CTX *ctx)
+{
+    KANGAROO_check(kangaroo_table);
+
+    vector<EC_POINT *> target = {EC_POINT_new(group)};
+    Kangaroo_shift(target[0], h, lo, hi, ctx);
+    vector<uint64_t> result(1);
+    vector<int> finding(1, 0);
+    atomic<bool> stop(false);
+    Kangaroo_search(kangaroo_table, target, result, finding, KANGAROO_HERD_SIZE, KANGAROO_MAX_WALK_NUM, true, stop, ctx);
+    if(finding[0] == 0 && Kangaroo_sweep(kangaroo_table, target[0], uint64_t(hi) - uint64_t(lo), result[0], ctx) == true){
+        finding[0] = 1;
+    }
+    EC_POINT_free(target[0]);
+
+    return finding[0] == 1 && Kangaroo_result(x, result[0], lo, hi);
+}
+
+/* multi-target version: the walks of all targets are normalised together. finding[t] = 0 indicates x[t] is not found */
+void Batch_Kangaroo_DLOG(vector<BIGNUM *> &x, vector<EC_POINT *> &h, int64_t lo, int64_t hi, vector<int> &finding)
+{
+    KANGAROO_check(kangaroo_table);
+
+    size_t target_num = h.size();
+    finding.assign(target_num, 0);
+    if(target_num == 0) return;
+
+    vector<EC_POINT *> target(target_num);
+    for(auto t = 0; t < target_num; t++){
+        target[t] = EC_POINT_new(group);
+        Kangaroo_shift(target[t], h[t], lo, hi, bn_ctx);
+    }
+
+    vector<uint64_t> result(target_num);
+    atomic<bool> stop(false);
+    size_t HERD_SIZE = min<size_t>(max<size_t>(target_num, KANGAROO_HERD_SIZE), BATCH_SIZE);
+    Kangaroo_search(kangaroo_table, target, result, finding, HERD_SIZE, KANGAROO_MAX_WALK_NUM, true, stop, bn_ctx);
+
+    for(auto t = 0; t < target_num; t++){
+        if(finding[t] == 0 && Kangaroo_sweep(kangaroo_table, target[t], uint64_t(hi) - uint64_t(lo), result[t], bn_ctx) == true){
+            finding[t] = 1;
+        }
+        if(finding[t] == 1 && Kangaroo_result(x[t], result[t], lo, hi) == false) finding[t] = 0;
+        EC_POINT_free(target[t]);
+    }
+}
+
+/* parallelizable search task: it raises the stop flag for the others once it finds x */
+void kangaroo_search_task(EC_POINT *&h, uint64_t &x, int &finding, size_t MAX_WALK_NUM, bool FROM_TARGET,
+                          atomic<bool> &stop)
+{
+    vector<EC_POINT *> target = {h};
+    vector<uint64_t> result(1);
+    vector<int> local_finding(1, 0);
+    Kangaroo_search(kangaroo_table, target, result, local_finding, KANGAROO_HERD_SIZE, MAX_WALK_NUM, FROM_TARGET,
+                    stop, THREAD_POOL_context()->bn_ctx);
+    if(local_finding[0] == 1)
+    {
+        x = result[0];
+        finding = 1;
+        stop = true;
+    }
+}
+
+/* every task runs its own herd of wild walks (only the first one starts at h): the walk budget is split among the tasks */
+bool Parallel_Kangaroo_DLOG(BIGNUM *&x, EC_POINT *&h, int64_t lo, int64_t hi, size_t DEC_THREAD_NUM)
+{
+    KANGAROO_check(kangaroo_table);
+
+    EC_POINT *target = EC_POINT_new(group);
+    Kangaroo_shift(target, h, lo, hi, bn_ctx);
+    vector<uint64_t> result(DEC_THREAD_NUM);
+    vector<int> finding(DEC_THREAD_NUM, 0);
+    atomic<bool> stop(false);
+    size_t MAX_WALK_NUM = max<size_t>(KANGAROO_MAX_WALK_NUM/DEC_THREAD_NUM, 1);
+
+    vector<function<void()>> searchtask;
+    for(auto i = 0; i < DEC_THREAD_NUM; i++){
+        searchtask.push_back(bind(kangaroo_search_task, std::ref(target), std::ref(result[i]),
+                                  std::ref(finding[i]), MAX_WALK_NUM, i == 0, std::ref(stop)));
+    }
+    THREAD_POOL_run(searchtask);
+
+    for(auto i = 0; i < DEC_THREAD_NUM; i++)
+    {
+        if(finding[i] == 1){
+            EC_POINT_free(target);
+            return Kangaroo_result(x, result[i], lo, hi);
+        }
+    }
+    uint64_t sweep_result;
+    bool FOUND = Kangaroo_sweep(kangaroo_table, target, uint64_t(hi) - uint64_t(lo), sweep_result, bn_ctx);
+    EC_POINT_free(target);
+    return FOUND == true && Kangaroo_result(x, sweep_result, lo, hi);
+}
+
+#endif
@@ -0,0 +1,482 @@
+/****************************************************************************
+this hpp implements a native P-256 backend for the bulk point operations
+*****************************************************************************
+* @author     This file is part of PGC, developed by Yu Chen
+* @paper      https://eprint.iacr.org/2019/319
+* @copyright  MIT license (see LICENSE file)
+*****************************************************************************/
+
+/*
+    The table build and the Shanks search are long streams of point additions. Through OpenSSL every one
+    of them works on heap-allocated EC_POINT/BIGNUM objects behind a method table and a BN_CTX.
+    This backend serves those loops on NIST P-256 with fixed-width values on the stack:
+    field elements are 4x64-bit limbs in Montgomery form (a*2^256 mod p), points are affine (x, y)
+    or Jacobian (X, Y, Z) with x = X/Z^2, y = Y/Z^3, and the walks use mixed Jacobian-affine additions.
+    A batch of points is normalised with a single inversion (Montgomery's trick).
+
+    The backend is selected by group_backend (see global.hpp): global_initialize picks GROUP_P256_NATIVE
+    for P-256, setting it to GROUP_OPENSSL afterwards turns it off. Points cross the boundary to OpenSSL only at the ends
+    of a loop (a target, a confirmed hit), so the public API keeps using EC_POINT.
+*/
+
+#ifndef __P256__
+#define __P256__
+
+#include "../common/global.hpp"
+#ifdef __x86_64__
+#include <x86intrin.h>
+#endif
+
+typedef unsigned __int128 uint128_t;
+
+struct P256_FE
+{
+    uint64_t v[4]; // little-endian limbs
+};
+
+struct P256_AFFINE
+{
+    P256_FE x, y;
+    bool infinity;
+};
+
+struct P256_JACOBIAN
+{
+    P256_FE X, Y, Z; // Z = 0 stands for the point at infinity
+};
+
+const P256_FE P256_P  = {{0xFFFFFFFFFFFFFFFFULL, 0x00000000FFFFFFFFULL, 0x0000000000000000ULL, 0xFFFFFFFF00000001ULL}};
+const P256_FE P256_RR = {{0x0000000000000003ULL, 0xFFFFFFFBFFFFFFFFULL, 0xFFFFFFFFFFFFFFFEULL, 0x00000004FFFFFFFDULL}}; // 2^512 mod p
+const P256_FE P256_ONE = {{1, 0, 0, 0}};
+const P256_FE P256_R  = {{0x0000000000000001ULL, 0xFFFFFFFF00000000ULL, 0xFFFFFFFFFFFFFFFFULL, 0x00000000FFFFFFFEULL}}; // 1 in Montgomery form
+
+inline bool P256_fe_is_zero(const P256_FE &a)
+{
+    return (a.v[0] | a.v[1] | a.v[2] | a.v[3]) == 0;
+}
+
+inline bool P256_fe_equal(const P256_FE &a, const P256_FE &b)
+{
+    return ((a.v[0] ^ b.v[0]) | (a.v[1] ^ b.v[1]) | (a.v[2] ^ b.v[2]) | (a.v[3] ^ b.v[3])) == 0;
+}
+
+/* a + b + carry and a - b - borrow with the carry/borrow out (on x86-64 it stays in the flag) */
+inline uint64_t P256_adc(uint64_t a, uint64_t b, unsigned char &carry)
+{
+#ifdef __x86_64__
+    unsigned long long r;
+    carry = _addcarry_u64(carry, a, b, &r);
+    return r;
+#else
+    uint128_t s = (uint128_t)a + b + carry;
+    carry = (unsigned char)(s >> 64);
+    return (uint64_t)s;
+#endif
+}
+
+inline uint64_t P256_sbb(uint64_t a, uint64_t b, unsigned char &borrow)
+{
+#ifdef __x86_64__
+    unsigned long long r;
+    borrow = _subborrow_u64(borrow, a, b, &r);
+    return r;
+#else
+    uint128_t d = (uint128_t)a - b - borrow;
+    borrow = (unsigned char)(d >> 64) & 1;
+    return (uint64_t)d;
+#endif
+}
+
+/* r = t - p if t >= p (t < 2p is given by the 4 limbs and the carry) */
+inline void P256_fe_reduce(P256_FE &r, const uint64_t t[4], uint64_t carry)
+{
+    uint64_t s[4];
+    unsigned char borrow = 0;
+    for(auto j = 0; j < 4; j++) s[j] = P256_sbb(t[j], P256_P.v[j], borrow);
+    // keep t if it was below p, i.e. the subtraction borrowed more than the carry gives
+    bool KEEP = (borrow > carry);
+    for(auto j = 0; j < 4; j++) r.v[j] = KEEP ? t[j] : s[j];
+}
+
+inline void P256_fe_add(P256_FE &r, const P256_FE &a, const P256_FE &b)
+{
+    uint64_t t[4];
+    unsigned char carry = 0;
+    for(auto j = 0; j < 4; j++) t[j] = P256_adc(a.v[j], b.v[j], carry);
+    P256_fe_reduce(r, t, carry);
+}
+
+inline void P256_fe_sub(P256_FE &r, const P256_FE &a, const P256_FE &b)
+{
+    uint64_t t[4];
+    unsigned char borrow = 0;
+    for(auto j = 0; j < 4; j++) t[j] = P256_sbb(a.v[j], b.v[j], borrow);
+    // add p back on a borrow
+    uint64_t mask = 0 - uint64_t(borrow);
+    unsigned char carry = 0;
+    for(auto j = 0; j < 4; j++) r.v[j] = P256_adc(t[j], P256_P.v[j] & mask, carry);
+}
+
+/*
+** Montgomery multiplication r = a*b/2^256 mod p: the 512-bit product is reduced limb by limb.
+** -p^{-1} = 1 mod 2^64, so m = t[i] clears limb i, and t[i] + m*p[0] = m*2^64 since p[0] = 2^64-1, p[2] = 0
+*/
+inline void P256_fe_mul(P256_FE &r, const P256_FE &a, const P256_FE &b)
+{
+    uint64_t t[8];
+    uint128_t s;
+    uint64_t carry = 0;
+    for(auto j = 0; j < 4; j++){
+        s = (uint128_t)a.v[j]*b.v[0] + carry;
+        t[j] = (uint64_t)s;
+        carry = (uint64_t)(s >> 64);
+    }
+    t[4] = carry;
+    for(auto i = 1; i < 4; i++){
+        carry = 0;
+        for(auto j = 0; j < 4; j++){
+            s = (uint128_t)a.v[j]*b.v[i] + t[i+j] + carry;
+            t[i+j] = (uint64_t)s;
+            carry = (uint64_t)(s >> 64);
+        }
+        t[i+4] = carry;
+    }
+
+    uint64_t top = 0;
+    for(auto i = 0; i < 4; i++){
+        uint64_t m = t[i];
+        s = (uint128_t)m*P256_P.v[1] + t[i+1] + m;
+        t[i+1] = (uint64_t)s;
+        s = (uint128_t)t[i+2] + (uint64_t)(s >> 64);
+        t[i+2] = (uint64_t)s;
+        s = (uint128_t)m*P256_P.v[3] + t[i+3] + (uint64_t)(s >> 64);
+        t[i+3] = (uint64_t)s;
+        s = (uint128_t)t[i+4] + (uint64_t)(s >> 64) + top;
+        t[i+4] = (uint64_t)s;
+        top = (uint64_t)(s >> 64);
+    }
+    P256_fe_reduce(r, t+4, top);
+}
+
+inline void P256_fe_sqr(P256_FE &r, const P256_FE &a)
+{
+    P256_fe_mul(r, a, a);
+}
+
+/* r = a^{-1} = a^{p-2} (a != 0) */
+void P256_fe_inv(P256_FE &r, const P256_FE &a)
+{
+    const P256_FE e = {{0xFFFFFFFFFFFFFFFDULL, 0x00000000FFFFFFFFULL, 0x0000000000000000ULL, 0xFFFFFFFF00000001ULL}};
+    P256_FE result = P256_R;
+    for(int i = 255; i >= 0; i--){
+        P256_fe_sqr(result, result);
+        if((e.v[i/64] >> (i%64)) & 1) P256_fe_mul(result, result, a);
+    }
+    r = result;
+}
+
+/* big-endian 32 bytes <-> Montgomery form */
+inline void P256_fe_from_bytes(P256_FE &r, const unsigned char *buffer)
+{
+    P256_FE a;
+    for(auto j = 0; j < 4; j++){
+        a.v[j] = 0;
+        for(auto k = 0; k < 8; k++) a.v[j] = (a.v[j] << 8) | buffer[(3-j)*8 + k];
+    }
+    P256_fe_mul(r, a, P256_RR);
+}
+
+inline void P256_fe_to_bytes(unsigned char *buffer, const P256_FE &a)
+{
+    P256_FE r;
+    P256_fe_mul(r, a, P256_ONE);
+    for(auto j = 0; j < 4; j++){
+        for(auto k = 0; k < 8; k++) buffer[(3-j)*8 + k] = (unsigned char)(r.v[j] >> (56 - 8*k));
+    }
+}
+
+/* the canonical value (out of Montgomery form) */
+inline void P256_fe_canonical(P256_FE &r, const P256_FE &a)
+{
+    P256_fe_mul(r, a, P256_ONE);
+}
+
+inline void P256_jacobian_from_affine(P256_JACOBIAN &R, const P256_AFFINE &A)
+{
+    if(A.infinity){
+        R.X = R.Y = P256_R;
+        R.Z.v[0] = R.Z.v[1] = R.Z.v[2] = R.Z.v[3] = 0;
+        return;
+    }
+    R.X = A.x;
+    R.Y = A.y;
+    R.Z = P256_R;
+}
+
+/* R = 2A (dbl-2001-b, a = -3) */
+void P256_double(P256_JACOBIAN &R, const P256_JACOBIAN &A)
+{
+    if(P256_fe_is_zero(A.Z) || P256_fe_is_zero(A.Y)){
+        R.X = R.Y = P256_R;
+        R.Z.v[0] = R.Z.v[1] = R.Z.v[2] = R.Z.v[3] = 0;
+        return;
+    }
+    P256_FE delta, gamma, beta, alpha, t1, t2;
+    P256_fe_sqr(delta, A.Z);
+    P256_fe_sqr(gamma, A.Y);
+    P256_fe_mul(beta, A.X, gamma);
+    P256_fe_sub(t1, A.X, delta);
+    P256_fe_add(t2, A.X, delta);
+    P256_fe_mul(alpha, t1, t2);
+    P256_fe_add(t1, alpha, alpha);
+    P256_fe_add(alpha, t1, alpha);          // alpha = 3(X - delta)(X + delta)
+    P256_fe_add(t1, A.Y, A.Z);
+    P256_fe_sqr(t1, t1);
+    P256_fe_sub(t1, t1, gamma);
+    P256_fe_sub(R.Z, t1, delta);            // Z3 = (Y + Z)^2 - gamma - delta
+    P256_fe_add(beta, beta, beta);
+    P256_fe_add(beta, beta, beta);          // beta = 4 X gamma
+    P256_fe_sqr(t1, alpha);
+    P256_fe_sub(t1, t1, beta);
+    P256_fe_sub(R.X, t1, beta);             // X3 = alpha^2 - 8 beta
+    P256_fe_sub(t1, beta, R.X);
+    P256_fe_mul(t1, alpha, t1);
+    P256_fe_sqr(t2, gamma);
+    P256_fe_add(t2, t2, t2);
+    P256_fe_add(t2, t2, t2);
+    P256_fe_add(t2, t2, t2);                // 8 gamma^2
+    P256_fe_sub(R.Y, t1, t2);               // Y3 = alpha (4 beta - X3) - 8 gamma^2
+}
+
+/* R = A + B with B affine (madd-2007-bl): R may alias A */
+void P256_add_mixed(P256_JACOBIAN &R, const P256_JACOBIAN &A, const P256_AFFINE &B)
+{
+    if(B.infinity){
+        R = A;
+        return;
+    }
+    if(P256_fe_is_zero(A.Z)){
+        P256_jacobian_from_affine(R, B);
+        return;
+    }
+    P256_FE Z1Z1, U2, S2, H, HH, I, J, r, V, t;
+    P256_fe_sqr(Z1Z1, A.Z);
+    P256_fe_mul(U2, B.x, Z1Z1);
+    P256_fe_mul(S2, B.y, A.Z);
+    P256_fe_mul(S2, S2, Z1Z1);
+    P256_fe_sub(H, U2, A.X);
+    P256_fe_sub(r, S2, A.Y);
+    if(P256_fe_is_zero(H)){
+        // A = B: double, A = -B: infinity
+        if(P256_fe_is_zero(r)){
+            P256_JACOBIAN D;
+            P256_jacobian_from_affine(D, B);
+            P256_double(R, D);
+        }
+        else{
+            R.X = R.Y = P256_R;
+            R.Z.v[0] = R.Z.v[1] = R.Z.v[2] = R.Z.v[3] = 0;
+        }
+        return;
+    }
+    P256_fe_sqr(HH, H);
+    P256_fe_add(I, HH, HH);
+    P256_fe_add(I, I, I);                   // I = 4 HH
+    P256_fe_mul(J, H, I);
+    P256_fe_add(r, r, r);                   // r = 2 (S2 - Y1)
+    P256_fe_mul(V, A.X, I);
+
+    P256_FE Y1J;
+    P256_fe_mul(Y1J, A.Y, J);
+    P256_fe_add(t, A.Z, H);
+    P256_fe_sqr(t, t);
+    P256_fe_sub(t, t, Z1Z1);
+    P256_fe_sub(R.Z, t, HH);                // Z3 = (Z1 + H)^2 - Z1Z1 - HH
+
+    P256_fe_sqr(t, r);
+    P256_fe_sub(t, t, J);
+    P256_fe_sub(t, t, V);
+    P256_fe_sub(R.X, t, V);                 // X3 = r^2 - J - 2V
+    P256_fe_sub(t, V, R.X);
+    P256_fe_mul(t, r, t);
+    P256_fe_add(Y1J, Y1J, Y1J);
+    P256_fe_sub(R.Y, t, Y1J);               // Y3 = r (V - X3) - 2 Y1 J
+}
+
+/*
+** batch inversion (Montgomery's trick): r[k] = a[k]^{-1} for the non-zero a[k] with one field inversion,
+** r[k] is left untouched where a[k] = 0. scratch holds num elements
+*/
+void P256_fe_batch_inv(P256_FE *r, const P256_FE *a, size_t num, P256_FE *scratch)
+{
+    P256_FE acc = P256_R;
+    for(auto k = 0; k < num; k++){
+        scratch[k] = acc;
+        if(!P256_fe_is_zero(a[k])) P256_fe_mul(acc, acc, a[k]);
+    }
+    P256_fe_inv(acc, acc);
+    for(int k = int(num) - 1; k >= 0; k--){
+        if(P256_fe_is_zero(a[k])) continue;
+        P256_FE inv;
+        P256_fe_mul(inv, acc, scratch[k]);
+        P256_fe_mul(acc, acc, a[k]);
+        r[k] = inv;
+    }
+}
+
+/* R[k] = J[k] in affine form for k < num, scratch holds 3*num elements */
+void P256_batch_normalize(P256_AFFINE *R, const P256_JACOBIAN *J, size_t num, P256_FE *scratch)
+{
+    P256_FE *z = scratch, *zinv = scratch + num;
+    for(auto k = 0; k < num; k++) z[k] = J[k].Z;
+    P256_fe_batch_inv(zinv, z, num, scratch + 2*num);
+
+    for(auto k = 0; k < num; k++){
+        R[k].infinity = P256_fe_is_zero(z[k]);
+        if(R[k].infinity) continue;
+        P256_FE zinv2;
+        P256_fe_sqr(zinv2, zinv[k]);
+        P256_fe_mul(R[k].x, J[k].X, zinv2);
+        P256_fe_mul(zinv2, zinv2, zinv[k]);
+        P256_fe_mul(R[k].y, J[k].Y, zinv2);
+    }
+}
+
+/* R = 2A for an affine point, with an inversion of its own */
+void P256_double_affine(P256_AFFINE &R, const P256_AFFINE &A)
+{
+    P256_JACOBIAN D;
+    P256_jacobian_from_affine(D, A);
+    P256_double(D, D);
+    P256_FE scratch[3];
+    P256_batch_normalize(&R, &D, 1, scratch);
+}
+
+/* R[k] = A[k] + B[k] for affine points with one shared inversion, scratch holds 3*num elements */
+void P256_batch_add_affine(P256_AFFINE *R, const P256_AFFINE **A, const P256_AFFINE **B, size_t num, P256_FE *scratch)
+{
+    P256_FE *dx = scratch, *dxinv = scratch + num;
+    for(auto k = 0; k < num; k++){
+        if(A[k]->infinity || B[k]->infinity) dx[k] = P256_FE{{0, 0, 0, 0}}; // skipped by the inversion
+        else P256_fe_sub(dx[k], B[k]->x, A[k]->x);
+    }
+    P256_fe_batch_inv(dxinv, dx, num, scratch + 2*num);
+
+    for(auto k = 0; k < num; k++){
+        if(A[k]->infinity){ R[k] = *B[k]; continue; }
+        if(B[k]->infinity){ R[k] = *A[k]; continue; }
+        if(P256_fe_is_zero(dx[k])){
+            // A = B is doubled on its own (rare), A = -B gives the point at infinity
+            if(P256_fe_equal(A[k]->y, B[k]->y)) P256_double_affine(R[k], *A[k]);
+            else R[k].infinity = true;
+            continue;
+        }
+        P256_FE lambda, t;
+        P256_fe_sub(t, B[k]->y, A[k]->y);
+        P256_fe_mul(lambda, t, dxinv[k]);
+        P256_fe_sqr(t, lambda);
+        P256_fe_sub(t, t, A[k]->x);
+        P256_fe_sub(t, t, B[k]->x);                 // x3 = lambda^2 - x1 - x2
+        P256_FE u;
+        P256_fe_sub(u, A[k]->x, t);
+        P256_fe_mul(u, lambda, u);
+        P256_fe_sub(R[k].y, u, A[k]->y);            // y3 = lambda (x1 - x3) - y1
+        R[k].x = t;
+        R[k].infinity = false;
+    }
+}
+
+/* the affine coordinates of P (false if P is the point at infinity) */
+bool P256_from_EC_POINT(P256_AFFINE &A, const EC_POINT *P, BN_CTX *ctx)
+{
+    A.infinity = EC_POINT_is_at_infinity(group, P);
+    if(A.infinity) return false;
+    BN_CTX_start(ctx);
+    BIGNUM *x = BN_CTX_get(ctx);
+    BIGNUM *y = BN_CTX_get(ctx);
+    EC_POINT_get_affine_coordinates(group, P, x, y, ctx);
+    unsigned char buffer[32];
+    BN_bn2binpad(x, buffer, 32);
+    P256_fe_from_bytes(A.x, buffer);
+    BN_bn2binpad(y, buffer, 32);
+    P256_fe_from_bytes(A.y, buffer);
+    BN_CTX_end(ctx);
+    return true;
+}
+
+void P256_to_EC_POINT(EC_POINT *P, const P256_AFFINE &A, BN_CTX *ctx)
+{
+    if(A.infinity){
+        EC_POINT_set_to_infinity(group, P);
+        return;
+    }
+    BN_CTX_start(ctx);
+    BIGNUM *x = BN_CTX_get(ctx);
+    BIGNUM *y = BN_CTX_get(ctx);
+    unsigned char buffer[32];
+    P256_fe_to_bytes(buffer, A.x);
+    BN_bin2bn(buffer, 32, x);
+    P256_fe_to_bytes(buffer, A.y);
+    BN_bin2bn(buffer, 32, y);
+    EC_POINT_set_affine_coordinates(group, P, x, y, ctx);
+    BN_CTX_end(ctx);
+}
+
+/* hand the Jacobian coordinates to OpenSSL as they are, it normalises P only if it needs the affine form later */
+void P256_jacobian_to_EC_POINT(EC_POINT *P, const P256_JACOBIAN &A, BN_CTX *ctx)
+{
+    if(P256_fe_is_zero(A.Z)){
+        EC_POINT_set_to_infinity(group, P);
+        return;
+    }
+    BN_CTX_start(ctx);
+    BIGNUM *x = BN_CTX_get(ctx);
+    BIGNUM *y = BN_CTX_get(ctx);
+    BIGNUM *z = BN_CTX_get(ctx);
+    unsigned char buffer[32];
+    P256_fe_to_bytes(buffer, A.X);
+    BN_bin2bn(buffer, 32, x);
+    P256_fe_to_bytes(buffer, A.Y);
+    BN_bin2bn(buffer, 32, y);
+    P256_fe_to_bytes(buffer, A.Z);
+    BN_bin2bn(buffer, 32, z);
+    ECP_set_Jprojective_coordinates(P, x, y, z, ctx);
+    BN_CTX_end(ctx);
+}
+
+/*
+** A[k] = P + k*Q for k <= num with mixed additions along the walk and one batch normalisation,
+** the walk continues from A[num] = P + num*Q, which is written back to P.
+** A and J hold num+1 points, scratch holds 3*(num+1) elements
+*/
+void P256_walk(P256_AFFINE *A, P256_AFFINE &P, const P256_AFFINE &Q, size_t num,
+               P256_JACOBIAN *J, P256_FE *scratch)
+{
+    P256_jacobian_from_affine(J[0], P);
+    for(auto k = 1; k <= num; k++){
+        P256_add_mixed(J[k], J[k-1], Q);
+    }
+    P256_batch_normalize(A, J, num+1, scratch);
+    P = A[num];
+}
+
+/* multiple[k] = k*A for k <= num */
+void P256_multiples(vector<P256_AFFINE> &multiple, const EC_POINT *A, size_t num, BN_CTX *ctx)
+{
+    P256_AFFINE start, step;
+    start.infinity = true;
+    P256_from_EC_POINT(step, A, ctx);
+    multiple.resize(num+1);
+    vector<P256_JACOBIAN> J(num+1);
+    vector<P256_FE> scratch(3*(num+1));
+    P256_walk(multiple.data(), start, step, num, J.data(), scratch.data());
+}
+
+/* R = -A */
+inline void P256_negate(P256_AFFINE &R, const P256_AFFINE &A)
+{
+    R = A;
+    if(A.infinity == false) P256_fe_sub(R.y, P256_FE{{0, 0, 0, 0}}, A.y);
+}
+
+#endif
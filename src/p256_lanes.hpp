@@ -0,0 +1,406 @@
+/****************************************************************************
+this hpp implements multi-lane (AVX2/AVX-512 IFMA) kernels of the native P-256 backend
+*****************************************************************************
+* @author     This file is part of PGC, developed by Yu Chen
+* @paper      https://eprint.iacr.org/2019/319
+* @copyright  MIT license (see LICENSE file)
+*****************************************************************************/
+
+/*
+    The batched affine additions behind the table build and the Shanks search are independent of each other,
+    so they run side by side in the lanes of a vector register: 8 lanes of 5x52-bit limbs with the
+    AVX-512 IFMA multiply-add (vpmadd52luq/vpmadd52huq), or 4 lanes of 10x26-bit limbs with AVX2 (vpmuludq).
+    A lane block holds limb j of lane l at [j*lane_num + l]. The Montgomery reduction runs over the same
+    2^256 as the scalar path (the last step is shorter: 4x52+48 and 9x26+22 bits), and every result is
+    reduced below p, so the lanes give exactly the scalar values.
+
+    The batch inversion keeps one running product per lane, the lane products are inverted together
+    by the scalar code. The kernels are compiled with target attributes and picked at run time
+    (p256_isa), so the program still runs on CPUs without these extensions.
+*/
+
+#ifndef __P256_LANES__
+#define __P256_LANES__
+
+#include "p256.hpp"
+#include <cstring>
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+// the instruction set of the batched additions
+enum P256_ISA {P256_SCALAR = 0, P256_AVX2 = 1, P256_IFMA = 2};
+
+const size_t P256_LANE_BLOCK = 40; // the words of a lane block: 8 lanes x 5 limbs or 4 lanes x 10 limbs
+
+struct P256_LANES
+{
+    size_t lane_num;
+    size_t limb_num;
+    size_t limb_bits;
+    void (*mul)(uint64_t *r, const uint64_t *a, const uint64_t *b);
+    void (*add)(uint64_t *r, const uint64_t *a, const uint64_t *b);
+    void (*sub)(uint64_t *r, const uint64_t *a, const uint64_t *b);
+};
+
+#ifdef __x86_64__
+
+/* p in 5x52-bit and 10x26-bit limbs */
+const uint64_t P256_P52[5] = {0xFFFFFFFFFFFFFULL, 0x00FFFFFFFFFFFULL, 0x0000000000000ULL, 0x0001000000000ULL, 0x0FFFFFFFF0000ULL};
+const uint64_t P256_P26[10] = {0x3FFFFFF, 0x3FFFFFF, 0x3FFFFFF, 0x003FFFF, 0x0000000,
+                               0x0000000, 0x0000000, 0x0000400, 0x3FF0000, 0x03FFFFF};
+
+/*
+** AVX-512 IFMA: 8 lanes of 5x52-bit limbs
+*/
+
+#define P256_IFMA_TARGET __attribute__((target("avx512f,avx512ifma")))
+
+/* r = R - p if R >= p, R < 2p in normalised limbs */
+P256_IFMA_TARGET inline void P256_ifma_canonical(__m512i R[5])
+{
+    const __m512i M52 = _mm512_set1_epi64(0xFFFFFFFFFFFFFULL);
+    __m512i D[5], borrow = _mm512_setzero_si512();
+    for(auto j = 0; j < 5; j++){
+        D[j] = _mm512_add_epi64(_mm512_sub_epi64(R[j], _mm512_set1_epi64(P256_P52[j])), borrow);
+        borrow = _mm512_srai_epi64(D[j], 52);
+        D[j] = _mm512_and_si512(D[j], M52);
+    }
+    __mmask8 KEEP = _mm512_cmplt_epi64_mask(borrow, _mm512_setzero_si512()); // R < p
+    for(auto j = 0; j < 5; j++) R[j] = _mm512_mask_blend_epi64(KEEP, D[j], R[j]);
+}
+
+P256_IFMA_TARGET void P256_ifma_mul(uint64_t *r, const uint64_t *a, const uint64_t *b)
+{
+    const __m512i M52 = _mm512_set1_epi64(0xFFFFFFFFFFFFFULL);
+    const __m512i M48 = _mm512_set1_epi64(0xFFFFFFFFFFFFULL);
+    __m512i A[5], P[5], t[11];
+    for(auto j = 0; j < 5; j++){
+        A[j] = _mm512_loadu_si512(a + 8*j);
+        P[j] = _mm512_set1_epi64(P256_P52[j]);
+    }
+    for(auto k = 0; k < 11; k++) t[k] = _mm512_setzero_si512();
+
+    // the 520-bit product, the limbs keep their carries until the reduction
+    for(auto i = 0; i < 5; i++){
+        __m512i B = _mm512_loadu_si512(b + 8*i);
+        for(auto j = 0; j < 5; j++){
+            t[i+j]   = _mm512_madd52lo_epu64(t[i+j], A[j], B);
+            t[i+j+1] = _mm512_madd52hi_epu64(t[i+j+1], A[j], B);
+        }
+    }
+    // -p^{-1} = 1 mod 2^52: m = t[s] mod 2^52 clears limb s, four times 52 bits and once 48 bits
+    for(auto s = 0; s < 5; s++){
+        __m512i m = _mm512_and_si512(t[s], (s < 4) ? M52 : M48);
+        for(auto j = 0; j < 5; j++){
+            t[s+j]   = _mm512_madd52lo_epu64(t[s+j], m, P[j]);
+            t[s+j+1] = _mm512_madd52hi_epu64(t[s+j+1], m, P[j]);
+        }
+        if(s < 4) t[s+1] = _mm512_add_epi64(t[s+1], _mm512_srli_epi64(t[s], 52));
+    }
+    for(auto k = 4; k < 10; k++){
+        t[k+1] = _mm512_add_epi64(t[k+1], _mm512_srli_epi64(t[k], 52));
+        t[k] = _mm512_and_si512(t[k], M52);
+    }
+    // the result is t >> 256 = t >> (4*52 + 48)
+    __m512i R[5];
+    for(auto j = 0; j < 5; j++){
+        R[j] = _mm512_or_si512(_mm512_srli_epi64(t[4+j], 48), _mm512_and_si512(_mm512_slli_epi64(t[5+j], 4), M52));
+    }
+    P256_ifma_canonical(R);
+    for(auto j = 0; j < 5; j++) _mm512_storeu_si512(r + 8*j, R[j]);
+}
+
+P256_IFMA_TARGET void P256_ifma_add(uint64_t *r, const uint64_t *a, const uint64_t *b)
+{
+    const __m512i M52 = _mm512_set1_epi64(0xFFFFFFFFFFFFFULL);
+    __m512i R[5], carry = _mm512_setzero_si512();
+    for(auto j = 0; j < 5; j++){
+        R[j] = _mm512_add_epi64(_mm512_add_epi64(_mm512_loadu_si512(a + 8*j), _mm512_loadu_si512(b + 8*j)), carry);
+        carry = _mm512_srli_epi64(R[j], 52);
+        R[j] = _mm512_and_si512(R[j], M52);
+    }
+    P256_ifma_canonical(R);
+    for(auto j = 0; j < 5; j++) _mm512_storeu_si512(r + 8*j, R[j]);
+}
+
+P256_IFMA_TARGET void P256_ifma_sub(uint64_t *r, const uint64_t *a, const uint64_t *b)
+{
+    const __m512i M52 = _mm512_set1_epi64(0xFFFFFFFFFFFFFULL);
+    __m512i D[5], E[5], borrow = _mm512_setzero_si512(), carry = _mm512_setzero_si512();
+    for(auto j = 0; j < 5; j++){
+        D[j] = _mm512_add_epi64(_mm512_sub_epi64(_mm512_loadu_si512(a + 8*j), _mm512_loadu_si512(b + 8*j)), borrow);
+        borrow = _mm512_srai_epi64(D[j], 52);
+        D[j] = _mm512_and_si512(D[j], M52);
+    }
+    // on a borrow D = a - b + 2^260, adding p and dropping 2^260 gives a - b + p
+    for(auto j = 0; j < 5; j++){
+        E[j] = _mm512_add_epi64(_mm512_add_epi64(D[j], _mm512_set1_epi64(P256_P52[j])), carry);
+        carry = _mm512_srli_epi64(E[j], 52);
+        E[j] = _mm512_and_si512(E[j], M52);
+    }
+    __mmask8 NEGATIVE = _mm512_cmplt_epi64_mask(borrow, _mm512_setzero_si512());
+    for(auto j = 0; j < 5; j++) _mm512_storeu_si512(r + 8*j, _mm512_mask_blend_epi64(NEGATIVE, D[j], E[j]));
+}
+
+/*
+** AVX2: 4 lanes of 10x26-bit limbs, 64-bit arithmetic shifts are emulated
+*/
+
+#define P256_AVX2_TARGET __attribute__((target("avx2")))
+
+P256_AVX2_TARGET inline __m256i P256_avx2_srai(__m256i x, int n)
+{
+    const __m256i SIGN = _mm256_set1_epi64x(0x8000000000000000LL);
+    return _mm256_sub_epi64(_mm256_srli_epi64(_mm256_xor_si256(x, SIGN), n), _mm256_srli_epi64(SIGN, n));
+}
+
+P256_AVX2_TARGET inline void P256_avx2_canonical(__m256i R[10])
+{
+    const __m256i M26 = _mm256_set1_epi64x(0x3FFFFFF);
+    __m256i D[10], borrow = _mm256_setzero_si256();
+    for(auto j = 0; j < 10; j++){
+        D[j] = _mm256_add_epi64(_mm256_sub_epi64(R[j], _mm256_set1_epi64x(P256_P26[j])), borrow);
+        borrow = P256_avx2_srai(D[j], 26);
+        D[j] = _mm256_and_si256(D[j], M26);
+    }
+    __m256i KEEP = _mm256_cmpgt_epi64(_mm256_setzero_si256(), borrow); // R < p
+    for(auto j = 0; j < 10; j++) R[j] = _mm256_blendv_epi8(D[j], R[j], KEEP);
+}
+
+P256_AVX2_TARGET void P256_avx2_mul(uint64_t *r, const uint64_t *a, const uint64_t *b)
+{
+    const __m256i M26 = _mm256_set1_epi64x(0x3FFFFFF);
+    const __m256i M22 = _mm256_set1_epi64x(0x3FFFFF);
+    __m256i A[10], t[20];
+    for(auto j = 0; j < 10; j++) A[j] = _mm256_loadu_si256((const __m256i *)(a + 4*j));
+    for(auto k = 0; k < 20; k++) t[k] = _mm256_setzero_si256();
+
+    for(auto i = 0; i < 10; i++){
+        __m256i B = _mm256_loadu_si256((const __m256i *)(b + 4*i));
+        for(auto j = 0; j < 10; j++) t[i+j] = _mm256_add_epi64(t[i+j], _mm256_mul_epu32(A[j], B));
+    }
+    // -p^{-1} = 1 mod 2^26: nine times 26 bits and once 22 bits
+    for(auto s = 0; s < 10; s++){
+        __m256i m = _mm256_and_si256(t[s], (s < 9) ? M26 : M22);
+        for(auto j = 0; j < 10; j++){
+            if(P256_P26[j] == 0) continue;
+            t[s+j] = _mm256_add_epi64(t[s+j], _mm256_mul_epu32(m, _mm256_set1_epi64x(P256_P26[j])));
+        }
+        if(s < 9) t[s+1] = _mm256_add_epi64(t[s+1], _mm256_srli_epi64(t[s], 26));
+    }
+    for(auto k = 9; k < 19; k++){
+        t[k+1] = _mm256_add_epi64(t[k+1], _mm256_srli_epi64(t[k], 26));
+        t[k] = _mm256_and_si256(t[k], M26);
+    }
+    // the result is t >> 256 = t >> (9*26 + 22)
+    __m256i R[10];
+    for(auto j = 0; j < 10; j++){
+        __m256i high = (j < 9) ? _mm256_and_si256(_mm256_slli_epi64(t[10+j], 4), M26) : _mm256_slli_epi64(t[10+j], 4);
+        R[j] = _mm256_or_si256(_mm256_srli_epi64(t[9+j], 22), high);
+    }
+    P256_avx2_canonical(R);
+    for(auto j = 0; j < 10; j++) _mm256_storeu_si256((__m256i *)(r + 4*j), R[j]);
+}
+
+P256_AVX2_TARGET void P256_avx2_add(uint64_t *r, const uint64_t *a, const uint64_t *b)
+{
+    const __m256i M26 = _mm256_set1_epi64x(0x3FFFFFF);
+    __m256i R[10], carry = _mm256_setzero_si256();
+    for(auto j = 0; j < 10; j++){
+        R[j] = _mm256_add_epi64(_mm256_add_epi64(_mm256_loadu_si256((const __m256i *)(a + 4*j)),
+                                                 _mm256_loadu_si256((const __m256i *)(b + 4*j))), carry);
+        carry = _mm256_srli_epi64(R[j], 26);
+        R[j] = _mm256_and_si256(R[j], M26);
+    }
+    P256_avx2_canonical(R);
+    for(auto j = 0; j < 10; j++) _mm256_storeu_si256((__m256i *)(r + 4*j), R[j]);
+}
+
+P256_AVX2_TARGET void P256_avx2_sub(uint64_t *r, const uint64_t *a, const uint64_t *b)
+{
+    const __m256i M26 = _mm256_set1_epi64x(0x3FFFFFF);
+    __m256i D[10], E[10], borrow = _mm256_setzero_si256(), carry = _mm256_setzero_si256();
+    for(auto j = 0; j < 10; j++){
+        D[j] = _mm256_add_epi64(_mm256_sub_epi64(_mm256_loadu_si256((const __m256i *)(a + 4*j)),
+                                                 _mm256_loadu_si256((const __m256i *)(b + 4*j))), borrow);
+        borrow = P256_avx2_srai(D[j], 26);
+        D[j] = _mm256_and_si256(D[j], M26);
+    }
+    for(auto j = 0; j < 10; j++){
+        E[j] = _mm256_add_epi64(_mm256_add_epi64(D[j], _mm256_set1_epi64x(P256_P26[j])), carry);
+        carry = _mm256_srli_epi64(E[j], 26);
+        E[j] = _mm256_and_si256(E[j], M26);
+    }
+    __m256i NEGATIVE = _mm256_cmpgt_epi64(_mm256_setzero_si256(), borrow);
+    for(auto j = 0; j < 10; j++) _mm256_storeu_si256((__m256i *)(r + 4*j), _mm256_blendv_epi8(D[j], E[j], NEGATIVE));
+}
+
+const P256_LANES P256_IFMA_LANES = {8, 5, 52, P256_ifma_mul, P256_ifma_add, P256_ifma_sub};
+const P256_LANES P256_AVX2_LANES = {4, 10, 26, P256_avx2_mul, P256_avx2_add, P256_avx2_sub};
+
+#endif
+
+/*
+** the default: IFMA if the CPU has it. the 4 lanes of AVX2 need 200 32x32-bit multiplications per field multiplication,
+** 50 per lane against 32 64x64-bit ones of the scalar code, which is faster on the CPUs we measured (see benchmark_backend)
+*/
+inline int P256_ISA_detect()
+{
+#ifdef __x86_64__
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512ifma")) return P256_IFMA;
+#endif
+    return P256_SCALAR;
+}
+
+inline bool P256_ISA_supported(int isa)
+{
+#ifdef __x86_64__
+    __builtin_cpu_init();
+    if(isa == P256_IFMA) return __builtin_cpu_supports("avx512ifma");
+    if(isa == P256_AVX2) return __builtin_cpu_supports("avx2");
+#endif
+    return isa == P256_SCALAR;
+}
+
+int p256_isa = P256_ISA_detect();
+
+/* load a lane block from lane_num field elements, split into limbs of limb_bits */
+inline void P256_LANES_load(const P256_LANES &lanes, uint64_t *block, const P256_FE **a)
+{
+    const uint64_t MASK = (uint64_t(1) << lanes.limb_bits) - 1;
+    for(auto l = 0; l < lanes.lane_num; l++){
+        for(auto j = 0; j < lanes.limb_num; j++){
+            size_t bit = j*lanes.limb_bits, word = bit/64, shift = bit%64;
+            uint64_t limb = a[l]->v[word] >> shift;
+            if(shift + lanes.limb_bits > 64 && word < 3) limb |= a[l]->v[word+1] << (64 - shift);
+            block[j*lanes.lane_num + l] = limb & MASK;
+        }
+    }
+}
+
+/* store lane l of a lane block */
+inline void P256_LANES_store(const P256_LANES &lanes, P256_FE &r, const uint64_t *block, size_t l)
+{
+    r.v[0] = r.v[1] = r.v[2] = r.v[3] = 0;
+    for(auto j = 0; j < lanes.limb_num; j++){
+        size_t bit = j*lanes.limb_bits, word = bit/64, shift = bit%64;
+        uint64_t limb = block[j*lanes.lane_num + l];
+        r.v[word] |= limb << shift;
+        if(shift + lanes.limb_bits > 64 && word < 3) r.v[word+1] |= limb >> (64 - shift);
+    }
+}
+
+/* the scratch of P256_batch_add for num additions, in 64-bit words */
+inline size_t P256_batch_add_scratch_size(size_t num)
+{
+    return 20*num + 16*P256_LANE_BLOCK; // 2 lane blocks per 4 additions and 12 temporary blocks, or 3*num P256_FE
+}
+
+/*
+** R[k] = A[k] + B[k] as P256_batch_add_affine with the lanes: the additions of group g are lanes g*lane_num + l.
+** the special cases (the point at infinity, A[k] = +-B[k]) take a dummy lane and are added by the scalar code
+*/
+void P256_LANES_batch_add(const P256_LANES &lanes, P256_AFFINE *R, const P256_AFFINE **A, const P256_AFFINE **B,
+                          size_t num, uint64_t *scratch)
+{
+    const size_t L = lanes.lane_num;
+    const size_t W = P256_LANE_BLOCK;
+    size_t group_num = (num + L - 1)/L;
+    uint64_t *dx = scratch, *prefix = scratch + group_num*W;
+    uint64_t *acc = prefix + group_num*W, *inv = acc + W, *ax = inv + W, *ay = ax + W, *bx = ay + W, *by = bx + W;
+    uint64_t *lambda = by + W, *t = lambda + W, *u = t + W;
+
+    const P256_FE ZERO = {{0, 0, 0, 0}};
+    const P256_FE *pax[8], *pay[8], *pbx[8], *pby[8];
+    auto gather = [&](size_t g){
+        for(auto l = 0; l < L; l++){
+            size_t k = g*L + l;
+            bool DUMMY = (k >= num) || A[k]->infinity || B[k]->infinity || P256_fe_equal(A[k]->x, B[k]->x);
+            pax[l] = DUMMY ? &ZERO : &A[k]->x;
+            pay[l] = DUMMY ? &ZERO : &A[k]->y;
+            pbx[l] = DUMMY ? &P256_R : &B[k]->x; // a dummy lane adds (1, 0) to (0, 0)
+            pby[l] = DUMMY ? &ZERO : &B[k]->y;
+        }
+    };
+
+    // running products of dx = B.x - A.x per lane
+    const P256_FE *one[8];
+    for(auto l = 0; l < L; l++) one[l] = &P256_R;
+    P256_LANES_load(lanes, acc, one);
+    for(auto g = 0; g < group_num; g++){
+        gather(g);
+        P256_LANES_load(lanes, ax, pax);
+        P256_LANES_load(lanes, bx, pbx);
+        lanes.sub(dx + g*W, bx, ax);
+        memcpy(prefix + g*W, acc, W*sizeof(uint64_t));
+        lanes.mul(acc, acc, dx + g*W);
+    }
+
+    // invert the products of the lanes together
+    P256_FE product[8], product_inv[8], local[8];
+    const P256_FE *pproduct[8];
+    for(auto l = 0; l < L; l++){
+        P256_LANES_store(lanes, product[l], acc, l);
+        pproduct[l] = &product_inv[l];
+    }
+    P256_fe_batch_inv(product_inv, product, L, local);
+    P256_LANES_load(lanes, acc, pproduct);
+
+    for(int g = int(group_num) - 1; g >= 0; g--){
+        lanes.mul(inv, acc, prefix + g*W);            // 1/dx of group g
+        lanes.mul(acc, acc, dx + g*W);
+
+        gather(g);
+        P256_LANES_load(lanes, ax, pax);
+        P256_LANES_load(lanes, ay, pay);
+        P256_LANES_load(lanes, bx, pbx);
+        P256_LANES_load(lanes, by, pby);
+        lanes.sub(t, by, ay);
+        lanes.mul(lambda, t, inv);
+        lanes.mul(t, lambda, lambda);
+        lanes.sub(t, t, ax);
+        lanes.sub(t, t, bx);                         // x3 = lambda^2 - x1 - x2
+        lanes.sub(u, ax, t);
+        lanes.mul(u, lambda, u);
+        lanes.sub(u, u, ay);                         // y3 = lambda (x1 - x3) - y1
+
+        for(auto l = 0; l < L; l++){
+            size_t k = g*L + l;
+            if(k >= num || pbx[l] == &P256_R) continue;
+            P256_LANES_store(lanes, R[k].x, t, l);
+            P256_LANES_store(lanes, R[k].y, u, l);
+            R[k].infinity = false;
+        }
+    }
+
+    // the special cases, only a doubling needs an inversion of its own
+    for(auto k = 0; k < num; k++){
+        if(A[k]->infinity) R[k] = *B[k];
+        else if(B[k]->infinity) R[k] = *A[k];
+        else if(P256_fe_equal(A[k]->x, B[k]->x)){
+            if(P256_fe_equal(A[k]->y, B[k]->y)) P256_double_affine(R[k], *A[k]);
+            else R[k].infinity = true;
+        }
+    }
+}
+
+/* R[k] = A[k] + B[k] for k < num on the instruction set p256_isa, scratch holds P256_batch_add_scratch_size(num) words */
+void P256_batch_add(P256_AFFINE *R, const P256_AFFINE **A, const P256_AFFINE **B, size_t num, uint64_t *scratch)
+{
+#ifdef __x86_64__
+    // a batch of a few additions fills too few lanes
+    if(p256_isa == P256_IFMA && num >= 16){
+        P256_LANES_batch_add(P256_IFMA_LANES, R, A, B, num, scratch);
+        return;
+    }
+    if(p256_isa == P256_AVX2 && num >= 8){
+        P256_LANES_batch_add(P256_AVX2_LANES, R, A, B, num, scratch);
+        return;
+    }
+#endif
+    P256_batch_add_affine(R, A, B, num, reinterpret_cast<P256_FE *>(scratch));
+}
+
+#endif
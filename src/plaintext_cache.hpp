@@ -0,0 +1,196 @@
+/****************************************************************************
+this hpp implements a bounded cache of recently decrypted messages
+*****************************************************************************
+* @author     This file is part of PGC, developed by Yu Chen
+* @paper      https://eprint.iacr.org/2019/319
+* @copyright  MIT license (see LICENSE file)
+*****************************************************************************/
+
+/*
+    Ciphertexts often hold a value that was decrypted recently (an unchanged balance, a common amount).
+    The cache maps the compressed point M = g^m to m, so a hit answers the DLOG with one lookup
+    instead of the giant-step walk. It sits in front of Shanks_DLOG/Parallel_Shanks_DLOG and is off by default.
+
+    The cache is split into shards by the key, each shard is a hash map plus a list that keeps
+    the eviction order under its own mutex, so concurrent decryptions rarely wait on each other.
+    A cached m is the DLOG w.r.t. the base the cache was created for, other bases bypass the cache.
+*/
+
+#ifndef __PLAINTEXT_CACHE__
+#define __PLAINTEXT_CACHE__
+
+#include "../common/global.hpp"
+#include <atomic>
+#include <list>
+#include <mutex>
+
+// the entry evicted when a full shard receives a new entry
+enum CACHE_Policy {CACHE_LRU = 0, CACHE_FIFO = 1}; // least recently used / first inserted
+
+const size_t PLAINTEXT_CACHE_MAX_SHARD_NUM = 16;
+
+struct PLAINTEXT_CACHE_Shard
+{
+    mutex mtx;
+    list<pair<string, int64_t>> order; // the front is evicted first
+    unordered_map<string, list<pair<string, int64_t>>::iterator> index;
+    size_t capacity;
+};
+
+struct PLAINTEXT_CACHE
+{
+    PLAINTEXT_CACHE_Shard *shard; // NULL if the cache is disabled
+    size_t shard_num;             // power of 2
+    size_t capacity;              // the total number of entries
+    int policy;
+    EC_POINT *base;               // the cached values are DLOGs w.r.t. base
+
+    atomic<uint64_t> hits;
+    atomic<uint64_t> misses;
+    atomic<uint64_t> evictions;
+};
+
+PLAINTEXT_CACHE plaintext_cache = {NULL, 0, 0, CACHE_LRU, NULL};
+
+inline bool PLAINTEXT_CACHE_enabled()
+{
+    return plaintext_cache.shard != NULL;
+}
+
+void PLAINTEXT_CACHE_free()
+{
+    if(plaintext_cache.shard == NULL) return;
+    delete[] plaintext_cache.shard;
+    EC_POINT_free(plaintext_cache.base);
+    plaintext_cache.shard = NULL;
+    plaintext_cache.base = NULL;
+    plaintext_cache.shard_num = 0;
+    plaintext_cache.capacity = 0;
+}
+
+/* enable the cache for DLOGs w.r.t. base: at most capacity entries, evicted by policy */
+void PLAINTEXT_CACHE_new(EC_POINT *&base, size_t capacity, int policy = CACHE_LRU)
+{
+    PLAINTEXT_CACHE_free();
+    if(capacity == 0) return;
+
+    // every shard holds at least one entry
+    size_t shard_num = 1;
+    while(shard_num*2 <= min(capacity, PLAINTEXT_CACHE_MAX_SHARD_NUM)) shard_num *= 2;
+
+    plaintext_cache.shard = new PLAINTEXT_CACHE_Shard[shard_num];
+    for(auto i = 0; i < shard_num; i++){
+        plaintext_cache.shard[i].capacity = capacity/shard_num + (i < capacity%shard_num);
+    }
+    plaintext_cache.shard_num = shard_num;
+    plaintext_cache.capacity = capacity;
+    plaintext_cache.policy = policy;
+    plaintext_cache.base = EC_POINT_dup(base, group);
+
+    plaintext_cache.hits = 0;
+    plaintext_cache.misses = 0;
+    plaintext_cache.evictions = 0;
+}
+
+/* the key of A: its compressed encoding, empty if A is not w.r.t. the cached base */
+inline string PLAINTEXT_CACHE_key(EC_POINT *&g, EC_POINT *&A, BN_CTX *ctx)
+{
+    if(EC_POINT_cmp(group, g, plaintext_cache.base, ctx) != 0) return "";
+    unsigned char buffer[POINT_LEN];
+    size_t len = EC_POINT_point2oct(group, A, POINT_CONVERSION_COMPRESSED, buffer, POINT_LEN, ctx);
+    return string(reinterpret_cast<char *>(buffer), len);
+}
+
+/* the last byte of the x-coordinate picks the shard (the point at infinity is the single byte 0) */
+inline PLAINTEXT_CACHE_Shard& PLAINTEXT_CACHE_shard(const string &key)
+{
+    return plaintext_cache.shard[(unsigned char)(key.back()) & (plaintext_cache.shard_num - 1)];
+}
+
+/* look up h = g^x: return false on a miss */
+bool PLAINTEXT_CACHE_find(EC_POINT *&g, EC_POINT *&h, int64_t &x, BN_CTX *ctx)
+{
+    if(PLAINTEXT_CACHE_enabled() == false) return false;
+    string key = PLAINTEXT_CACHE_key(g, h, ctx);
+    if(key.empty()) return false;
+
+    PLAINTEXT_CACHE_Shard &shard = PLAINTEXT_CACHE_shard(key);
+    bool finding = false;
+    {
+        lock_guard<mutex> lock(shard.mtx);
+        auto it = shard.index.find(key);
+        if(it != shard.index.end()){
+            x = it->second->second;
+            // a hit renews the entry in LRU mode
+            if(plaintext_cache.policy == CACHE_LRU) shard.order.splice(shard.order.end(), shard.order, it->second);
+            finding = true;
+        }
+    }
+    if(finding == true) plaintext_cache.hits++;
+    else plaintext_cache.misses++;
+    return finding;
+}
+
+/* record h = g^x */
+void PLAINTEXT_CACHE_insert(EC_POINT *&g, EC_POINT *&h, int64_t x, BN_CTX *ctx)
+{
+    if(PLAINTEXT_CACHE_enabled() == false) return;
+    string key = PLAINTEXT_CACHE_key(g, h, ctx);
+    if(key.empty()) return;
+
+    PLAINTEXT_CACHE_Shard &shard = PLAINTEXT_CACHE_shard(key);
+    lock_guard<mutex> lock(shard.mtx);
+    if(shard.index.find(key) != shard.index.end()) return; // another thread got there first
+    if(shard.order.size() >= shard.capacity){
+        shard.index.erase(shard.order.front().first);
+        shard.order.pop_front();
+        plaintext_cache.evictions++;
+    }
+    shard.order.push_back(make_pair(key, x));
+    shard.index[key] = prev(shard.order.end());
+}
+
+/* preload the expected values: value[i] is recorded as the DLOG of base^value[i] */
+void PLAINTEXT_CACHE_warmup(vector<int64_t> &value)
+{
+    if(PLAINTEXT_CACHE_enabled() == false) return;
+    EC_POINT *A = EC_POINT_new(group);
+    BIGNUM *m = BN_new();
+    for(auto i = 0; i < value.size(); i++){
+        BN_set_word(m, value[i] < 0 ? -uint64_t(value[i]) : value[i]);
+        BN_set_negative(m, value[i] < 0);
+        EC_POINT_mul(group, A, NULL, plaintext_cache.base, m, bn_ctx);
+        PLAINTEXT_CACHE_insert(plaintext_cache.base, A, value[i], bn_ctx);
+    }
+    BN_free(m);
+    EC_POINT_free(A);
+}
+
+/* the fraction of lookups answered by the cache */
+inline double PLAINTEXT_CACHE_hit_rate()
+{
+    uint64_t lookups = plaintext_cache.hits + plaintext_cache.misses;
+    return (lookups == 0) ? 0 : double(plaintext_cache.hits)/lookups;
+}
+
+/* reset the statistics, e.g. after the warm-up */
+void PLAINTEXT_CACHE_reset_stats()
+{
+    plaintext_cache.hits = 0;
+    plaintext_cache.misses = 0;
+    plaintext_cache.evictions = 0;
+}
+
+void PLAINTEXT_CACHE_print_stats()
+{
+    size_t size = 0;
+    for(auto i = 0; i < plaintext_cache.shard_num; i++){
+        lock_guard<mutex> lock(plaintext_cache.shard[i].mtx);
+        size += plaintext_cache.shard[i].order.size();
+    }
+    cout << "plaintext cache: " << size << "/" << plaintext_cache.capacity << " entries, "
+         << plaintext_cache.hits << " hits, " << plaintext_cache.misses << " misses (hit rate "
+         << PLAINTEXT_CACHE_hit_rate()*100 << "%), " << plaintext_cache.evictions << " evictions" << endl;
+}
+
+#endif
@@ -0,0 +1,741 @@
+/****************************************************************************
+this hpp implements the prime-order group ristretto255 over Curve25519
+*****************************************************************************
+* @author     This file is part of PGC, developed by Yu Chen
+* @paper      https://eprint.iacr.org/2019/319
+* @copyright  MIT license (see LICENSE file)
+*****************************************************************************/
+
+/*
+    ristretto255 (RFC 9496) is a group of prime order l = 2^252 + 27742317777372353535851937790883648493 built on
+    the twisted Edwards curve -x^2 + y^2 = 1 + d x^2 y^2 over p = 2^255 - 19. A group element is a class of
+    curve points that differ by a 4-torsion point, so there is no cofactor to clear, and every element has
+    a unique 32-byte encoding (RISTRETTO_POINT_LEN) against the 33 bytes of a compressed P-256 point.
+    OpenSSL has no EC_GROUP for it, so the group lives here:
+    field elements are 5x51-bit limbs, points are extended coordinates (X:Y:Z:T) with x = X/Z, y = Y/Z, xy = T/Z,
+    whose unified addition (add-2008-hwcd-3) takes 9 multiplications and has no exceptional case.
+
+    Encoding costs an inverse square root, so the bulk operations encode 2P instead of P:
+    the encoding of a doubled point is rational in P and a batch shares one inversion (as in curve25519-dalek).
+    The table build and the Shanks search thus walk on the halves of their points (see ristretto_dlog.hpp).
+    Scalars are BIGNUMs taken mod l, and the multiplications are not constant-time, like those of fast_mul.hpp.
+*/
+
+#ifndef __RISTRETTO255__
+#define __RISTRETTO255__
+
+#include "../common/global.hpp"
+
+typedef unsigned __int128 uint128_t;
+
+const size_t RISTRETTO_POINT_LEN = 32; // the encoding of a group element
+const uint32_t RISTRETTO255_ID = 0x52323535; // "R255": the group id of the hashmap header, not an OpenSSL NID
+
+struct RISTRETTO_FE
+{
+    uint64_t v[5]; // radix 2^51, little-endian
+};
+
+struct RISTRETTO_POINT
+{
+    RISTRETTO_FE X, Y, Z, T;
+};
+
+/* the other operand of an addition, prepared once: (Y+X, Y-X, 2Z, 2dT) */
+struct RISTRETTO_CACHED
+{
+    RISTRETTO_FE YpX, YmX, Z2, T2d;
+};
+
+const uint64_t RISTRETTO_MASK51 = (uint64_t(1) << 51) - 1;
+
+const RISTRETTO_FE RISTRETTO_FE_ZERO = {{0, 0, 0, 0, 0}};
+const RISTRETTO_FE RISTRETTO_FE_ONE  = {{1, 0, 0, 0, 0}};
+const RISTRETTO_FE RISTRETTO_D  = {{0x34dca135978a3ULL, 0x1a8283b156ebdULL, 0x5e7a26001c029ULL, 0x739c663a03cbbULL, 0x52036cee2b6ffULL}};
+const RISTRETTO_FE RISTRETTO_D2 = {{0x69b9426b2f159ULL, 0x35050762add7aULL, 0x3cf44c0038052ULL, 0x6738cc7407977ULL, 0x2406d9dc56dffULL}};
+const RISTRETTO_FE RISTRETTO_SQRT_M1 = {{0x61b274a0ea0b0ULL, 0x0d5a5fc8f189dULL, 0x7ef5e9cbd0c60ULL, 0x78595a6804c9eULL, 0x2b8324804fc1dULL}};
+const RISTRETTO_FE RISTRETTO_SQRT_AD_MINUS_ONE = {{0x7f6a0497b2e1bULL, 0x1836f0a97afd2ULL, 0x7d747f6be7638ULL, 0x456079e7e6498ULL, 0x376931bf2b834ULL}};
+const RISTRETTO_FE RISTRETTO_INVSQRT_A_MINUS_D = {{0x0fdaa805d40eaULL, 0x2eb482e57d339ULL, 0x007610274bc58ULL, 0x6510b613dc8ffULL, 0x786c8905cfaffULL}};
+const RISTRETTO_FE RISTRETTO_ONE_MINUS_D_SQ = {{0x409c1945fc176ULL, 0x719abc6a1fc4fULL, 0x1c37f90b20684ULL, 0x06bccca55eedfULL, 0x029072a8b2b3eULL}};
+const RISTRETTO_FE RISTRETTO_D_MINUS_ONE_SQ = {{0x55aaa44ed4d20ULL, 0x59603c3332635ULL, 0x26d3baf4a7928ULL, 0x120a66e6997a9ULL, 0x5968b37af66c2ULL}};
+
+/* the encoding of the standard generator */
+const unsigned char RISTRETTO_GENERATOR[RISTRETTO_POINT_LEN] = {
+    0xe2, 0xf2, 0xae, 0x0a, 0x6a, 0xbc, 0x4e, 0x71, 0xa8, 0x84, 0xa9, 0x61, 0xc5, 0x00, 0x51, 0x5f,
+    0x58, 0xe3, 0x0b, 0x6a, 0xa5, 0x82, 0xdd, 0x8d, 0xb6, 0xa6, 0x59, 0x45, 0xe0, 0x8d, 0x2d, 0x76};
+
+/* l and (l+1)/2 = 2^{-1} mod l */
+struct RISTRETTO_SCALARS
+{
+    BIGNUM *order;
+    BIGNUM *half;
+};
+
+RISTRETTO_SCALARS RISTRETTO_SCALARS_new()
+{
+    RISTRETTO_SCALARS scalars = {NULL, NULL};
+    BN_hex2bn(&scalars.order, "1000000000000000000000000000000014DEF9DEA2F79CD65812631A5CF5D3ED");
+    BN_hex2bn(&scalars.half, "80000000000000000000000000000000A6F7CEF517BCE6B2C09318D2E7AE9F7");
+    return scalars;
+}
+
+RISTRETTO_SCALARS ristretto_scalars = RISTRETTO_SCALARS_new();
+
+/* limbs below 2^51 (the value itself may still exceed p by less than 2^51) */
+inline void RISTRETTO_fe_carry(RISTRETTO_FE &r)
+{
+    uint64_t c;
+    c = r.v[0] >> 51; r.v[0] &= RISTRETTO_MASK51; r.v[1] += c;
+    c = r.v[1] >> 51; r.v[1] &= RISTRETTO_MASK51; r.v[2] += c;
+    c = r.v[2] >> 51; r.v[2] &= RISTRETTO_MASK51; r.v[3] += c;
+    c = r.v[3] >> 51; r.v[3] &= RISTRETTO_MASK51; r.v[4] += c;
+    c = r.v[4] >> 51; r.v[4] &= RISTRETTO_MASK51; r.v[0] += 19*c;
+}
+
+inline void RISTRETTO_fe_add(RISTRETTO_FE &r, const RISTRETTO_FE &a, const RISTRETTO_FE &b)
+{
+    for(auto j = 0; j < 5; j++) r.v[j] = a.v[j] + b.v[j];
+    RISTRETTO_fe_carry(r);
+}
+
+/* r = a + 2p - b, the limbs of 2p are 2^52 - 38 and 2^52 - 2 */
+inline void RISTRETTO_fe_sub(RISTRETTO_FE &r, const RISTRETTO_FE &a, const RISTRETTO_FE &b)
+{
+    r.v[0] = a.v[0] + 0xFFFFFFFFFFFDAULL - b.v[0];
+    for(auto j = 1; j < 5; j++) r.v[j] = a.v[j] + 0xFFFFFFFFFFFFEULL - b.v[j];
+    RISTRETTO_fe_carry(r);
+}
+
+inline void RISTRETTO_fe_neg(RISTRETTO_FE &r, const RISTRETTO_FE &a)
+{
+    RISTRETTO_fe_sub(r, RISTRETTO_FE_ZERO, a);
+}
+
+/* r = a*b mod p: 2^255 = 19 folds the upper half of the product into the lower one */
+inline void RISTRETTO_fe_mul(RISTRETTO_FE &r, const RISTRETTO_FE &a, const RISTRETTO_FE &b)
+{
+    uint64_t b1_19 = 19*b.v[1], b2_19 = 19*b.v[2], b3_19 = 19*b.v[3], b4_19 = 19*b.v[4];
+    uint128_t t0 = (uint128_t)a.v[0]*b.v[0] + (uint128_t)a.v[1]*b4_19 + (uint128_t)a.v[2]*b3_19
+                 + (uint128_t)a.v[3]*b2_19 + (uint128_t)a.v[4]*b1_19;
+    uint128_t t1 = (uint128_t)a.v[0]*b.v[1] + (uint128_t)a.v[1]*b.v[0] + (uint128_t)a.v[2]*b4_19
+                 + (uint128_t)a.v[3]*b3_19 + (uint128_t)a.v[4]*b2_19;
+    uint128_t t2 = (uint128_t)a.v[0]*b.v[2] + (uint128_t)a.v[1]*b.v[1] + (uint128_t)a.v[2]*b.v[0]
+                 + (uint128_t)a.v[3]*b4_19 + (uint128_t)a.v[4]*b3_19;
+    uint128_t t3 = (uint128_t)a.v[0]*b.v[3] + (uint128_t)a.v[1]*b.v[2] + (uint128_t)a.v[2]*b.v[1]
+                 + (uint128_t)a.v[3]*b.v[0] + (uint128_t)a.v[4]*b4_19;
+    uint128_t t4 = (uint128_t)a.v[0]*b.v[4] + (uint128_t)a.v[1]*b.v[3] + (uint128_t)a.v[2]*b.v[2]
+                 + (uint128_t)a.v[3]*b.v[1] + (uint128_t)a.v[4]*b.v[0];
+
+    t1 += (uint64_t)(t0 >> 51); r.v[0] = (uint64_t)t0 & RISTRETTO_MASK51;
+    t2 += (uint64_t)(t1 >> 51); r.v[1] = (uint64_t)t1 & RISTRETTO_MASK51;
+    t3 += (uint64_t)(t2 >> 51); r.v[2] = (uint64_t)t2 & RISTRETTO_MASK51;
+    t4 += (uint64_t)(t3 >> 51); r.v[3] = (uint64_t)t3 & RISTRETTO_MASK51;
+    r.v[4] = (uint64_t)t4 & RISTRETTO_MASK51;
+    r.v[0] += 19*(uint64_t)(t4 >> 51);
+    r.v[1] += r.v[0] >> 51;
+    r.v[0] &= RISTRETTO_MASK51;
+}
+
+inline void RISTRETTO_fe_sqr(RISTRETTO_FE &r, const RISTRETTO_FE &a)
+{
+    RISTRETTO_fe_mul(r, a, a);
+}
+
+inline void RISTRETTO_fe_sqr_n(RISTRETTO_FE &r, const RISTRETTO_FE &a, size_t n)
+{
+    r = a;
+    for(auto i = 0; i < n; i++) RISTRETTO_fe_sqr(r, r);
+}
+
+/* t = a^{2^250 - 1} and a^11, shared by the inversion and the square root */
+void RISTRETTO_fe_pow_250(RISTRETTO_FE &t, RISTRETTO_FE &a11, const RISTRETTO_FE &a)
+{
+    RISTRETTO_FE t0, t1, t2;
+    RISTRETTO_fe_sqr(t0, a);                  // a^2
+    RISTRETTO_fe_sqr_n(t1, t0, 2);            // a^8
+    RISTRETTO_fe_mul(t1, t1, a);              // a^9
+    RISTRETTO_fe_mul(a11, t0, t1);            // a^11
+    RISTRETTO_fe_sqr(t0, a11);                // a^22
+    RISTRETTO_fe_mul(t0, t0, t1);             // a^{2^5 - 1}
+    RISTRETTO_fe_sqr_n(t1, t0, 5);
+    RISTRETTO_fe_mul(t0, t1, t0);             // a^{2^10 - 1}
+    RISTRETTO_fe_sqr_n(t1, t0, 10);
+    RISTRETTO_fe_mul(t1, t1, t0);             // a^{2^20 - 1}
+    RISTRETTO_fe_sqr_n(t2, t1, 20);
+    RISTRETTO_fe_mul(t1, t2, t1);             // a^{2^40 - 1}
+    RISTRETTO_fe_sqr_n(t1, t1, 10);
+    RISTRETTO_fe_mul(t0, t1, t0);             // a^{2^50 - 1}
+    RISTRETTO_fe_sqr_n(t1, t0, 50);
+    RISTRETTO_fe_mul(t1, t1, t0);             // a^{2^100 - 1}
+    RISTRETTO_fe_sqr_n(t2, t1, 100);
+    RISTRETTO_fe_mul(t1, t2, t1);             // a^{2^200 - 1}
+    RISTRETTO_fe_sqr_n(t1, t1, 50);
+    RISTRETTO_fe_mul(t, t1, t0);              // a^{2^250 - 1}
+}
+
+/* r = a^{-1} = a^{p-2} = a^{2^255 - 21} (r = 0 for a = 0) */
+void RISTRETTO_fe_inv(RISTRETTO_FE &r, const RISTRETTO_FE &a)
+{
+    RISTRETTO_FE t, a11;
+    RISTRETTO_fe_pow_250(t, a11, a);
+    RISTRETTO_fe_sqr_n(t, t, 5);
+    RISTRETTO_fe_mul(r, t, a11);
+}
+
+/* r = a^{(p-5)/8} = a^{2^252 - 3} */
+void RISTRETTO_fe_pow22523(RISTRETTO_FE &r, const RISTRETTO_FE &a)
+{
+    RISTRETTO_FE t, a11;
+    RISTRETTO_fe_pow_250(t, a11, a);
+    RISTRETTO_fe_sqr_n(t, t, 2);
+    RISTRETTO_fe_mul(r, t, a);
+}
+
+/* the canonical value in little-endian 32 bytes */
+void RISTRETTO_fe_to_bytes(unsigned char *buffer, const RISTRETTO_FE &a)
+{
+    RISTRETTO_FE t = a;
+    RISTRETTO_fe_carry(t);
+    // q = 1 iff t >= p, i.e. t + 19 carries out of 2^255
+    uint64_t q = (t.v[0] + 19) >> 51;
+    for(auto j = 1; j < 5; j++) q = (t.v[j] + q) >> 51;
+    t.v[0] += 19*q;
+    for(auto j = 0; j < 4; j++){
+        t.v[j+1] += t.v[j] >> 51;
+        t.v[j] &= RISTRETTO_MASK51;
+    }
+    t.v[4] &= RISTRETTO_MASK51;
+
+    uint64_t word[4];
+    word[0] = t.v[0] | (t.v[1] << 51);
+    word[1] = (t.v[1] >> 13) | (t.v[2] << 38);
+    word[2] = (t.v[2] >> 26) | (t.v[3] << 25);
+    word[3] = (t.v[3] >> 39) | (t.v[4] << 12);
+    for(auto j = 0; j < 32; j++) buffer[j] = (unsigned char)(word[j/8] >> (8*(j%8)));
+}
+
+/* the top bit is ignored */
+void RISTRETTO_fe_from_bytes(RISTRETTO_FE &r, const unsigned char *buffer)
+{
+    uint64_t word[4] = {0, 0, 0, 0};
+    for(auto j = 0; j < 32; j++) word[j/8] |= uint64_t(buffer[j]) << (8*(j%8));
+    r.v[0] = word[0] & RISTRETTO_MASK51;
+    r.v[1] = ((word[0] >> 51) | (word[1] << 13)) & RISTRETTO_MASK51;
+    r.v[2] = ((word[1] >> 38) | (word[2] << 26)) & RISTRETTO_MASK51;
+    r.v[3] = ((word[2] >> 25) | (word[3] << 39)) & RISTRETTO_MASK51;
+    r.v[4] = (word[3] >> 12) & RISTRETTO_MASK51;
+}
+
+inline bool RISTRETTO_fe_is_negative(const RISTRETTO_FE &a)
+{
+    unsigned char buffer[32];
+    RISTRETTO_fe_to_bytes(buffer, a);
+    return buffer[0] & 1;
+}
+
+inline bool RISTRETTO_fe_equal(const RISTRETTO_FE &a, const RISTRETTO_FE &b)
+{
+    unsigned char buffer_a[32], buffer_b[32];
+    RISTRETTO_fe_to_bytes(buffer_a, a);
+    RISTRETTO_fe_to_bytes(buffer_b, b);
+    return memcmp(buffer_a, buffer_b, 32) == 0;
+}
+
+inline bool RISTRETTO_fe_is_zero(const RISTRETTO_FE &a)
+{
+    return RISTRETTO_fe_equal(a, RISTRETTO_FE_ZERO);
+}
+
+/* |a|: a or -a, whichever is non-negative */
+inline void RISTRETTO_fe_abs(RISTRETTO_FE &r, const RISTRETTO_FE &a)
+{
+    if(RISTRETTO_fe_is_negative(a)) RISTRETTO_fe_neg(r, a);
+    else r = a;
+}
+
+/*
+** r = sqrt(u/v) if u/v is a square, sqrt(i*u/v) otherwise (SQRT_RATIO_M1 of RFC 9496), r is non-negative.
+** return whether u/v is a square
+*/
+bool RISTRETTO_fe_sqrt_ratio(RISTRETTO_FE &r, const RISTRETTO_FE &u, const RISTRETTO_FE &v)
+{
+    RISTRETTO_FE v3, v7, t, check, u_neg, u_neg_i;
+    RISTRETTO_fe_sqr(v3, v);
+    RISTRETTO_fe_mul(v3, v3, v);              // v^3
+    RISTRETTO_fe_sqr(v7, v3);
+    RISTRETTO_fe_mul(v7, v7, v);              // v^7
+    RISTRETTO_fe_mul(t, u, v7);
+    RISTRETTO_fe_pow22523(t, t);              // (u v^7)^{(p-5)/8}
+    RISTRETTO_fe_mul(r, u, v3);
+    RISTRETTO_fe_mul(r, r, t);                // r = u v^3 (u v^7)^{(p-5)/8}
+
+    RISTRETTO_fe_sqr(check, r);
+    RISTRETTO_fe_mul(check, check, v);
+    RISTRETTO_fe_neg(u_neg, u);
+    RISTRETTO_fe_mul(u_neg_i, u_neg, RISTRETTO_SQRT_M1);
+    bool correct_sign = RISTRETTO_fe_equal(check, u);
+    bool flipped_sign = RISTRETTO_fe_equal(check, u_neg);
+    bool flipped_sign_i = RISTRETTO_fe_equal(check, u_neg_i);
+    if(flipped_sign || flipped_sign_i) RISTRETTO_fe_mul(r, r, RISTRETTO_SQRT_M1);
+    RISTRETTO_fe_abs(r, r);
+    return correct_sign || flipped_sign;
+}
+
+inline void RISTRETTO_identity(RISTRETTO_POINT &R)
+{
+    R.X = RISTRETTO_FE_ZERO;
+    R.Y = RISTRETTO_FE_ONE;
+    R.Z = RISTRETTO_FE_ONE;
+    R.T = RISTRETTO_FE_ZERO;
+}
+
+/* R = A + B (add-2008-hwcd-3, a = -1): complete, R may alias A or B */
+void RISTRETTO_add(RISTRETTO_POINT &R, const RISTRETTO_POINT &A, const RISTRETTO_POINT &B)
+{
+    RISTRETTO_FE a, b, c, d, t, E, F, G, H;
+    RISTRETTO_fe_sub(a, A.Y, A.X);
+    RISTRETTO_fe_sub(t, B.Y, B.X);
+    RISTRETTO_fe_mul(a, a, t);                // (Y1 - X1)(Y2 - X2)
+    RISTRETTO_fe_add(b, A.Y, A.X);
+    RISTRETTO_fe_add(t, B.Y, B.X);
+    RISTRETTO_fe_mul(b, b, t);                // (Y1 + X1)(Y2 + X2)
+    RISTRETTO_fe_mul(c, A.T, B.T);
+    RISTRETTO_fe_mul(c, c, RISTRETTO_D2);     // 2d T1 T2
+    RISTRETTO_fe_mul(d, A.Z, B.Z);
+    RISTRETTO_fe_add(d, d, d);                // 2 Z1 Z2
+    RISTRETTO_fe_sub(E, b, a);
+    RISTRETTO_fe_sub(F, d, c);
+    RISTRETTO_fe_add(G, d, c);
+    RISTRETTO_fe_add(H, b, a);
+    RISTRETTO_fe_mul(R.X, E, F);
+    RISTRETTO_fe_mul(R.Y, G, H);
+    RISTRETTO_fe_mul(R.T, E, H);
+    RISTRETTO_fe_mul(R.Z, F, G);
+}
+
+/* R = 2A (dbl-2008-hwcd, a = -1) */
+void RISTRETTO_double(RISTRETTO_POINT &R, const RISTRETTO_POINT &A)
+{
+    RISTRETTO_FE a, b, c, E, F, G, H;
+    RISTRETTO_fe_sqr(a, A.X);
+    RISTRETTO_fe_sqr(b, A.Y);
+    RISTRETTO_fe_sqr(c, A.Z);
+    RISTRETTO_fe_add(c, c, c);                // 2 Z^2
+    RISTRETTO_fe_add(E, A.X, A.Y);
+    RISTRETTO_fe_sqr(E, E);
+    RISTRETTO_fe_sub(E, E, a);
+    RISTRETTO_fe_sub(E, E, b);                // E = (X + Y)^2 - X^2 - Y^2
+    RISTRETTO_fe_sub(G, b, a);                // G = -X^2 + Y^2
+    RISTRETTO_fe_sub(F, G, c);
+    RISTRETTO_fe_add(H, a, b);
+    RISTRETTO_fe_neg(H, H);                   // H = -X^2 - Y^2
+    RISTRETTO_fe_mul(R.X, E, F);
+    RISTRETTO_fe_mul(R.Y, G, H);
+    RISTRETTO_fe_mul(R.T, E, H);
+    RISTRETTO_fe_mul(R.Z, F, G);
+}
+
+inline void RISTRETTO_negate(RISTRETTO_POINT &R, const RISTRETTO_POINT &A)
+{
+    RISTRETTO_fe_neg(R.X, A.X);
+    R.Y = A.Y;
+    R.Z = A.Z;
+    RISTRETTO_fe_neg(R.T, A.T);
+}
+
+inline void RISTRETTO_to_cached(RISTRETTO_CACHED &C, const RISTRETTO_POINT &A)
+{
+    RISTRETTO_fe_add(C.YpX, A.Y, A.X);
+    RISTRETTO_fe_sub(C.YmX, A.Y, A.X);
+    RISTRETTO_fe_add(C.Z2, A.Z, A.Z);
+    RISTRETTO_fe_mul(C.T2d, A.T, RISTRETTO_D2);
+}
+
+/* R = A + C (SUBTRACT = false) or A - C (SUBTRACT = true) */
+inline void RISTRETTO_add_cached(RISTRETTO_POINT &R, const RISTRETTO_POINT &A, const RISTRETTO_CACHED &C,
+                                 bool SUBTRACT = false)
+{
+    RISTRETTO_FE a, b, c, d, E, F, G, H;
+    RISTRETTO_fe_sub(a, A.Y, A.X);
+    RISTRETTO_fe_add(b, A.Y, A.X);
+    // -C = (Y-X, Y+X, 2Z, -2dT)
+    RISTRETTO_fe_mul(a, a, SUBTRACT ? C.YpX : C.YmX);
+    RISTRETTO_fe_mul(b, b, SUBTRACT ? C.YmX : C.YpX);
+    RISTRETTO_fe_mul(c, A.T, C.T2d);
+    RISTRETTO_fe_mul(d, A.Z, C.Z2);
+    RISTRETTO_fe_sub(E, b, a);
+    RISTRETTO_fe_add(H, b, a);
+    if(SUBTRACT){
+        RISTRETTO_fe_add(F, d, c);
+        RISTRETTO_fe_sub(G, d, c);
+    }
+    else{
+        RISTRETTO_fe_sub(F, d, c);
+        RISTRETTO_fe_add(G, d, c);
+    }
+    RISTRETTO_fe_mul(R.X, E, F);
+    RISTRETTO_fe_mul(R.Y, G, H);
+    RISTRETTO_fe_mul(R.T, E, H);
+    RISTRETTO_fe_mul(R.Z, F, G);
+}
+
+/* A = B as group elements: the classes agree iff X1 Y2 = Y1 X2 or Y1 Y2 = X1 X2 */
+bool RISTRETTO_equal(const RISTRETTO_POINT &A, const RISTRETTO_POINT &B)
+{
+    RISTRETTO_FE t1, t2;
+    RISTRETTO_fe_mul(t1, A.X, B.Y);
+    RISTRETTO_fe_mul(t2, A.Y, B.X);
+    if(RISTRETTO_fe_equal(t1, t2)) return true;
+    RISTRETTO_fe_mul(t1, A.Y, B.Y);
+    RISTRETTO_fe_mul(t2, A.X, B.X);
+    return RISTRETTO_fe_equal(t1, t2);
+}
+
+/* the 32-byte encoding of A (RFC 9496, Sec. 4.3.2) */
+void RISTRETTO_encode(unsigned char *buffer, const RISTRETTO_POINT &A)
+{
+    RISTRETTO_FE u1, u2, t, invsqrt, den1, den2, z_inv, x, y, den_inv;
+    RISTRETTO_fe_add(u1, A.Z, A.Y);
+    RISTRETTO_fe_sub(t, A.Z, A.Y);
+    RISTRETTO_fe_mul(u1, u1, t);              // u1 = (Z + Y)(Z - Y)
+    RISTRETTO_fe_mul(u2, A.X, A.Y);           // u2 = X Y
+    RISTRETTO_fe_sqr(t, u2);
+    RISTRETTO_fe_mul(t, t, u1);
+    RISTRETTO_fe_sqrt_ratio(invsqrt, RISTRETTO_FE_ONE, t);
+    RISTRETTO_fe_mul(den1, invsqrt, u1);
+    RISTRETTO_fe_mul(den2, invsqrt, u2);
+    RISTRETTO_fe_mul(z_inv, den1, den2);
+    RISTRETTO_fe_mul(z_inv, z_inv, A.T);
+
+    RISTRETTO_fe_mul(t, A.T, z_inv);
+    if(RISTRETTO_fe_is_negative(t)){
+        // rotate by the 4-torsion point: (x, y) -> (iy, ix)
+        RISTRETTO_fe_mul(x, A.Y, RISTRETTO_SQRT_M1);
+        RISTRETTO_fe_mul(y, A.X, RISTRETTO_SQRT_M1);
+        RISTRETTO_fe_mul(den_inv, den1, RISTRETTO_INVSQRT_A_MINUS_D);
+    }
+    else{
+        x = A.X;
+        y = A.Y;
+        den_inv = den2;
+    }
+    RISTRETTO_fe_mul(t, x, z_inv);
+    if(RISTRETTO_fe_is_negative(t)) RISTRETTO_fe_neg(y, y);
+    RISTRETTO_fe_sub(t, A.Z, y);
+    RISTRETTO_fe_mul(t, den_inv, t);
+    RISTRETTO_fe_abs(t, t);
+    RISTRETTO_fe_to_bytes(buffer, t);
+}
+
+/* decode 32 bytes (RFC 9496, Sec. 4.3.1): return false for a non-canonical or invalid encoding */
+bool RISTRETTO_decode(RISTRETTO_POINT &A, const unsigned char *buffer)
+{
+    RISTRETTO_FE s, ss, u1, u2, u2_sqr, v, t, invsqrt, den_x, den_y;
+    RISTRETTO_fe_from_bytes(s, buffer);
+    unsigned char check[32];
+    RISTRETTO_fe_to_bytes(check, s);
+    if(memcmp(check, buffer, 32) != 0 || (check[0] & 1)) return false; // s >= p or s < 0
+
+    RISTRETTO_fe_sqr(ss, s);
+    RISTRETTO_fe_sub(u1, RISTRETTO_FE_ONE, ss);
+    RISTRETTO_fe_add(u2, RISTRETTO_FE_ONE, ss);
+    RISTRETTO_fe_sqr(u2_sqr, u2);
+    RISTRETTO_fe_sqr(t, u1);
+    RISTRETTO_fe_mul(t, t, RISTRETTO_D);
+    RISTRETTO_fe_add(t, t, u2_sqr);
+    RISTRETTO_fe_neg(v, t);                   // v = -d u1^2 - u2^2
+    RISTRETTO_fe_mul(t, v, u2_sqr);
+    bool was_square = RISTRETTO_fe_sqrt_ratio(invsqrt, RISTRETTO_FE_ONE, t);
+    RISTRETTO_fe_mul(den_x, invsqrt, u2);
+    RISTRETTO_fe_mul(den_y, invsqrt, den_x);
+    RISTRETTO_fe_mul(den_y, den_y, v);
+
+    RISTRETTO_fe_add(t, s, s);
+    RISTRETTO_fe_mul(t, t, den_x);
+    RISTRETTO_fe_abs(A.X, t);                 // x = |2 s den_x|
+    RISTRETTO_fe_mul(A.Y, u1, den_y);
+    A.Z = RISTRETTO_FE_ONE;
+    RISTRETTO_fe_mul(A.T, A.X, A.Y);
+    return was_square && !RISTRETTO_fe_is_negative(A.T) && !RISTRETTO_fe_is_zero(A.Y);
+}
+
+/* the one-way map of 32 bytes to a group element (MAP of RFC 9496, Sec. 4.3.4) */
+void RISTRETTO_map(RISTRETTO_POINT &R, const unsigned char *buffer)
+{
+    RISTRETTO_FE t, r, u, v, s, s_prime, c, N, w0, w1, w2, w3, tmp;
+    RISTRETTO_fe_from_bytes(t, buffer);
+    RISTRETTO_fe_sqr(r, t);
+    RISTRETTO_fe_mul(r, r, RISTRETTO_SQRT_M1);              // r = i t^2
+    RISTRETTO_fe_add(u, r, RISTRETTO_FE_ONE);
+    RISTRETTO_fe_mul(u, u, RISTRETTO_ONE_MINUS_D_SQ);       // u = (r + 1)(1 - d^2)
+    RISTRETTO_fe_mul(v, r, RISTRETTO_D);
+    RISTRETTO_fe_add(v, v, RISTRETTO_FE_ONE);
+    RISTRETTO_fe_neg(v, v);
+    RISTRETTO_fe_add(tmp, r, RISTRETTO_D);
+    RISTRETTO_fe_mul(v, v, tmp);                            // v = (-1 - r d)(r + d)
+    bool was_square = RISTRETTO_fe_sqrt_ratio(s, u, v);
+    RISTRETTO_fe_mul(s_prime, s, t);
+    RISTRETTO_fe_abs(s_prime, s_prime);
+    RISTRETTO_fe_neg(s_prime, s_prime);
+    if(was_square == false){
+        s = s_prime;
+        c = r;
+    }
+    else RISTRETTO_fe_neg(c, RISTRETTO_FE_ONE);
+    RISTRETTO_fe_sub(tmp, r, RISTRETTO_FE_ONE);
+    RISTRETTO_fe_mul(N, c, tmp);
+    RISTRETTO_fe_mul(N, N, RISTRETTO_D_MINUS_ONE_SQ);
+    RISTRETTO_fe_sub(N, N, v);                              // N = c (r - 1)(d - 1)^2 - v
+
+    RISTRETTO_fe_mul(w0, s, v);
+    RISTRETTO_fe_add(w0, w0, w0);                           // w0 = 2 s v
+    RISTRETTO_fe_mul(w1, N, RISTRETTO_SQRT_AD_MINUS_ONE);
+    RISTRETTO_fe_sqr(tmp, s);
+    RISTRETTO_fe_sub(w2, RISTRETTO_FE_ONE, tmp);            // w2 = 1 - s^2
+    RISTRETTO_fe_add(w3, RISTRETTO_FE_ONE, tmp);            // w3 = 1 + s^2
+    RISTRETTO_fe_mul(R.X, w0, w3);
+    RISTRETTO_fe_mul(R.Y, w2, w1);
+    RISTRETTO_fe_mul(R.Z, w1, w3);
+    RISTRETTO_fe_mul(R.T, w0, w2);
+}
+
+/* hash to the group: 64 uniform bytes give MAP(b[0..32)) + MAP(b[32..64)) */
+void RISTRETTO_from_uniform_bytes(RISTRETTO_POINT &R, const unsigned char *buffer)
+{
+    RISTRETTO_POINT A, B;
+    RISTRETTO_map(A, buffer);
+    RISTRETTO_map(B, buffer + 32);
+    RISTRETTO_add(R, A, B);
+}
+
+/* the standard generator */
+void RISTRETTO_generator(RISTRETTO_POINT &G)
+{
+    RISTRETTO_decode(G, RISTRETTO_GENERATOR);
+}
+
+/* h = hash of the encoding of g: nobody knows log_g h */
+void Hash_RISTRETTO_to_RISTRETTO(const RISTRETTO_POINT &g, RISTRETTO_POINT &h)
+{
+    unsigned char buffer[RISTRETTO_POINT_LEN];
+    unsigned char hash_output[SHA512_DIGEST_LENGTH];
+    RISTRETTO_encode(buffer, g);
+    SHA512(buffer, RISTRETTO_POINT_LEN, hash_output);
+    RISTRETTO_from_uniform_bytes(h, hash_output);
+}
+
+/* k in [0, l) */
+inline void RISTRETTO_random(BIGNUM *k)
+{
+    BN_rand_range(k, ristretto_scalars.order);
+}
+
+/*
+** the signed radix-16 digits of k mod l: k = sum_i digit[i] 16^i with digit[i] in [-8, 8)
+** (the top digit is at most 2, since l < 2^253)
+*/
+void RISTRETTO_digits(int8_t digit[64], const BIGNUM *k, BN_CTX *ctx)
+{
+    BN_CTX_start(ctx);
+    BIGNUM *e = BN_CTX_get(ctx);
+    BN_nnmod(e, k, ristretto_scalars.order, ctx);
+    unsigned char buffer[32];
+    BN_bn2lebinpad(e, buffer, 32);
+    BN_CTX_end(ctx);
+
+    for(auto i = 0; i < 32; i++){
+        digit[2*i] = buffer[i] & 15;
+        digit[2*i+1] = buffer[i] >> 4;
+    }
+    int8_t carry = 0;
+    for(auto i = 0; i < 63; i++){
+        digit[i] += carry;
+        carry = (digit[i] + 8) >> 4;
+        digit[i] -= carry << 4;
+    }
+    digit[63] += carry;
+}
+
+/* multiple[d-1] = d*A for d in [1, 8] */
+inline void RISTRETTO_multiples(RISTRETTO_CACHED multiple[8], const RISTRETTO_POINT &A)
+{
+    RISTRETTO_POINT P = A;
+    RISTRETTO_to_cached(multiple[0], P);
+    for(auto d = 1; d < 8; d++){
+        RISTRETTO_add_cached(P, P, multiple[0]);
+        RISTRETTO_to_cached(multiple[d], P);
+    }
+}
+
+/* R += digit*A for the multiples of A */
+inline void RISTRETTO_add_digit(RISTRETTO_POINT &R, const RISTRETTO_CACHED multiple[8], int digit)
+{
+    if(digit > 0) RISTRETTO_add_cached(R, R, multiple[digit-1]);
+    if(digit < 0) RISTRETTO_add_cached(R, R, multiple[-digit-1], true);
+}
+
+/* R = k*A: 4 doublings and an addition per digit */
+void RISTRETTO_mul(RISTRETTO_POINT &R, const RISTRETTO_POINT &A, const BIGNUM *k, BN_CTX *ctx)
+{
+    int8_t digit[64];
+    RISTRETTO_digits(digit, k, ctx);
+    RISTRETTO_CACHED multiple[8];
+    RISTRETTO_multiples(multiple, A);
+
+    RISTRETTO_POINT Q;
+    RISTRETTO_identity(Q);
+    for(int i = 63; i >= 0; i--){
+        if(i < 63) for(auto j = 0; j < 4; j++) RISTRETTO_double(Q, Q);
+        RISTRETTO_add_digit(Q, multiple, digit[i]);
+    }
+    R = Q;
+}
+
+/* R = a*A + b*B: the two digit strings share the doublings (Straus) */
+void RISTRETTO_mul2(RISTRETTO_POINT &R, const BIGNUM *a, const RISTRETTO_POINT &A,
+                    const BIGNUM *b, const RISTRETTO_POINT &B, BN_CTX *ctx)
+{
+    int8_t digit_a[64], digit_b[64];
+    RISTRETTO_digits(digit_a, a, ctx);
+    RISTRETTO_digits(digit_b, b, ctx);
+    RISTRETTO_CACHED multiple_a[8], multiple_b[8];
+    RISTRETTO_multiples(multiple_a, A);
+    RISTRETTO_multiples(multiple_b, B);
+
+    RISTRETTO_POINT Q;
+    RISTRETTO_identity(Q);
+    for(int i = 63; i >= 0; i--){
+        if(i < 63) for(auto j = 0; j < 4; j++) RISTRETTO_double(Q, Q);
+        RISTRETTO_add_digit(Q, multiple_a, digit_a[i]);
+        RISTRETTO_add_digit(Q, multiple_b, digit_b[i]);
+    }
+    R = Q;
+}
+
+/* fixed-base table: point[8*i + d-1] = d * 16^i * base, a multiplication takes one addition per digit */
+struct RISTRETTO_TABLE
+{
+    vector<RISTRETTO_CACHED> point;
+};
+
+void RISTRETTO_TABLE_build(RISTRETTO_TABLE &table, const RISTRETTO_POINT &base)
+{
+    table.point.resize(64*8);
+    RISTRETTO_POINT row_base = base;
+    for(auto i = 0; i < 64; i++){
+        RISTRETTO_multiples(table.point.data() + 8*i, row_base);
+        for(auto j = 0; j < 4; j++) RISTRETTO_double(row_base, row_base);
+    }
+}
+
+void RISTRETTO_TABLE_mul(RISTRETTO_POINT &R, RISTRETTO_TABLE &table, const BIGNUM *k, BN_CTX *ctx)
+{
+    int8_t digit[64];
+    RISTRETTO_digits(digit, k, ctx);
+    RISTRETTO_POINT Q;
+    RISTRETTO_identity(Q);
+    for(auto i = 0; i < 64; i++) RISTRETTO_add_digit(Q, table.point.data() + 8*i, digit[i]);
+    R = Q;
+}
+
+/* the fingerprint of an encoding: its leading 8 bytes (the encoding of the identity is 0) */
+inline uint64_t RISTRETTO_fingerprint(const unsigned char *buffer)
+{
+    uint64_t fingerprint = 0;
+    for(auto k = 7; k >= 0; k--) fingerprint = (fingerprint << 8) | buffer[k];
+    return fingerprint;
+}
+
+/*
+** fingerprint[k] = the fingerprint of the encoding of 2*A[k] for k < num, with one inversion for the batch:
+** with e = 2XY, f = Z^2 + dT^2, g = Y^2 + X^2, h = Z^2 - dT^2 of A, the doubled point is (ef : gh : fh : eg)
+** and its encoding only needs 1/(eg) and 1/(fh), no square root. scratch holds 6*num field elements
+*/
+void RISTRETTO_batch_double_fingerprint(uint64_t *fingerprint, const RISTRETTO_POINT *A, size_t num,
+                                        RISTRETTO_FE *scratch)
+{
+    RISTRETTO_FE *e = scratch, *f = e + num, *g = f + num, *h = g + num, *efgh = h + num, *prefix = efgh + num;
+    RISTRETTO_FE acc = RISTRETTO_FE_ONE;
+    for(auto k = 0; k < num; k++){
+        RISTRETTO_FE XX, YY, ZZ, dTT, eg, fh;
+        RISTRETTO_fe_sqr(XX, A[k].X);
+        RISTRETTO_fe_sqr(YY, A[k].Y);
+        RISTRETTO_fe_sqr(ZZ, A[k].Z);
+        RISTRETTO_fe_sqr(dTT, A[k].T);
+        RISTRETTO_fe_mul(dTT, dTT, RISTRETTO_D);
+        RISTRETTO_fe_mul(e[k], A[k].X, A[k].Y);
+        RISTRETTO_fe_add(e[k], e[k], e[k]);
+        RISTRETTO_fe_add(f[k], ZZ, dTT);
+        RISTRETTO_fe_add(g[k], YY, XX);
+        RISTRETTO_fe_sub(h[k], ZZ, dTT);
+        RISTRETTO_fe_mul(eg, e[k], g[k]);
+        RISTRETTO_fe_mul(fh, f[k], h[k]);
+        RISTRETTO_fe_mul(efgh[k], eg, fh);
+        // 2A is the identity iff e = 0, it is left out of the inversion
+        prefix[k] = acc;
+        if(!RISTRETTO_fe_is_zero(efgh[k])) RISTRETTO_fe_mul(acc, acc, efgh[k]);
+    }
+    RISTRETTO_fe_inv(acc, acc);
+    for(int k = int(num) - 1; k >= 0; k--){
+        if(RISTRETTO_fe_is_zero(efgh[k])){
+            fingerprint[k] = 0;
+            continue;
+        }
+        RISTRETTO_FE inv, eg, fh, z_inv, t_inv, magic, t, s;
+        RISTRETTO_fe_mul(inv, acc, prefix[k]);
+        RISTRETTO_fe_mul(acc, acc, efgh[k]);
+        RISTRETTO_fe_mul(eg, e[k], g[k]);
+        RISTRETTO_fe_mul(fh, f[k], h[k]);
+        RISTRETTO_fe_mul(z_inv, eg, inv);     // 1/(fh)
+        RISTRETTO_fe_mul(t_inv, fh, inv);     // 1/(eg)
+
+        magic = RISTRETTO_INVSQRT_A_MINUS_D;
+        RISTRETTO_fe_mul(t, eg, z_inv);
+        if(RISTRETTO_fe_is_negative(t)){
+            // the same rotation as in RISTRETTO_encode
+            RISTRETTO_fe_neg(t, e[k]);
+            e[k] = g[k];
+            g[k] = t;
+            RISTRETTO_fe_mul(h[k], f[k], RISTRETTO_SQRT_M1);
+            magic = RISTRETTO_SQRT_M1;
+        }
+        RISTRETTO_fe_mul(t, h[k], e[k]);
+        RISTRETTO_fe_mul(t, t, z_inv);
+        if(RISTRETTO_fe_is_negative(t)) RISTRETTO_fe_neg(g[k], g[k]);
+        RISTRETTO_fe_mul(t, g[k], t_inv);
+        RISTRETTO_fe_mul(t, magic, t);
+        RISTRETTO_fe_sub(s, h[k], g[k]);
+        RISTRETTO_fe_mul(s, s, t);
+        RISTRETTO_fe_abs(s, s);
+
+        unsigned char buffer[32];
+        RISTRETTO_fe_to_bytes(buffer, s);
+        fingerprint[k] = RISTRETTO_fingerprint(buffer);
+    }
+}
+
+void RISTRETTO_print(const RISTRETTO_POINT &A, string note)
+{
+    unsigned char buffer[RISTRETTO_POINT_LEN];
+    RISTRETTO_encode(buffer, A);
+    cout << note << " = ";
+    for(auto k = 0; k < RISTRETTO_POINT_LEN; k++) printf("%02x", buffer[k]);
+    cout << endl;
+}
+
+void RISTRETTO_serialize(const RISTRETTO_POINT &A, ofstream &fout)
+{
+    unsigned char buffer[RISTRETTO_POINT_LEN];
+    RISTRETTO_encode(buffer, A);
+    fout.write(reinterpret_cast<char *>(buffer), RISTRETTO_POINT_LEN);
+}
+
+/* return false for an invalid encoding */
+bool RISTRETTO_deserialize(RISTRETTO_POINT &A, ifstream &fin)
+{
+    unsigned char buffer[RISTRETTO_POINT_LEN];
+    fin.read(reinterpret_cast<char *>(buffer), RISTRETTO_POINT_LEN);
+    return RISTRETTO_decode(A, buffer);
+}
+
+#endif
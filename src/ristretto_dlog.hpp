@@ -0,0 +1,230 @@
+/****************************************************************************
+this hpp implements the Shanks DLOG algorithm over ristretto255
+*****************************************************************************
+* @author     This file is part of PGC, developed by Yu Chen
+* @paper      https://eprint.iacr.org/2019/319
+* @copyright  MIT license (see LICENSE file)
+*****************************************************************************/
+
+/*
+    The table and its file are those of calculate_dlog.hpp (HASHMAP, HASHMAP_write, HASHMAP_map), only the points differ.
+    The key of an entry is the fingerprint of the 32-byte encoding of g^i. The encoding of a single point
+    costs an inverse square root, whereas the encodings of doubled points share one inversion per batch
+    (RISTRETTO_batch_double_fingerprint), so both the build and the search walk on halves:
+    with g' = 2^{-1} g the build walks i*g' and fingerprints 2*(i*g') = g^i, and the search walks
+    M' - j*TABLE_SIZE*g' for M' = 2^{-1} M and fingerprints M - j*TABLE_SIZE*g.
+    The header keys the file on RISTRETTO255_ID and the encoding of g (32 bytes, padded with a zero).
+*/
+
+#ifndef __RISTRETTO_DLOG__
+#define __RISTRETTO_DLOG__
+
+#include "../common/global.hpp"
+#include "calculate_dlog.hpp"
+#include "ristretto255.hpp"
+
+HASHMAP ristretto_point2index_map = {NULL, 0, 0, 0, NULL, 0, HASHMAP_XY_MODE}; // key: fingerprint of the encoding of g^i, value: i
+
+const size_t RISTRETTO_BATCH_SIZE = 64; // the points fingerprinted with one inversion
+
+void RISTRETTO_HASHMAP_Header_new(HASHMAP_Header &header, const RISTRETTO_POINT &g, uint64_t table_size, uint64_t slot_num)
+{
+    memset(&header, 0, sizeof(HASHMAP_Header));
+    memcpy(header.magic, HASHMAP_MAGIC, sizeof(HASHMAP_MAGIC));
+    header.version = HASHMAP_VERSION;
+    header.curve_id = RISTRETTO255_ID;
+    header.mode = HASHMAP_XY_MODE;
+    header.table_size = table_size;
+    header.entry_num = table_size;
+    header.slot_num = slot_num;
+    RISTRETTO_encode(header.base_point, g);
+}
+
+/*
+** fingerprint[i - startindex] = the fingerprint of g^i for i in [startindex, startindex + length),
+** where startpoint = startindex * g' and g' = 2^{-1} g
+*/
+void RISTRETTO_vector_serialize(RISTRETTO_POINT &g_half, RISTRETTO_POINT &startpoint,
+                                uint64_t startindex, uint64_t length, uint64_t *fingerprint)
+{
+    RISTRETTO_CACHED step;
+    RISTRETTO_to_cached(step, g_half);
+    vector<RISTRETTO_POINT> batch(RISTRETTO_BATCH_SIZE);
+    vector<RISTRETTO_FE> scratch(6*RISTRETTO_BATCH_SIZE);
+
+    RISTRETTO_POINT P = startpoint;
+    for(uint64_t done = 0; done < length; ){
+        size_t num = min<uint64_t>(RISTRETTO_BATCH_SIZE, length - done);
+        for(auto k = 0; k < num; k++){
+            batch[k] = P;
+            RISTRETTO_add_cached(P, P, step);
+        }
+        RISTRETTO_batch_double_fingerprint(fingerprint + startindex + done, batch.data(), num, scratch.data());
+        done += num;
+    }
+}
+
+/* build the hash map of g^i for i < TABLE_SIZE, task i takes an even share of the entries */
+void RISTRETTO_HASHMAP_serialize(RISTRETTO_POINT &g, string hashmap_file, uint64_t TABLE_SIZE, uint64_t IO_THREAD_NUM)
+{
+    cout << "hash map does not exist, begin to build and serialize >>>" << endl;
+
+    auto start_time = chrono::steady_clock::now(); // start to count the time
+    uint64_t entry_num = HASHMAP_entry_num(TABLE_SIZE, HASHMAP_XY_MODE);
+
+    RISTRETTO_POINT g_half;
+    RISTRETTO_mul(g_half, g, ristretto_scalars.half, bn_ctx);
+
+    BIGNUM *BN_range = BN_new();
+    vector<RISTRETTO_POINT> startpoint(IO_THREAD_NUM);
+    vector<uint64_t> startindex(IO_THREAD_NUM);
+    vector<uint64_t> length(IO_THREAD_NUM);
+    for (auto i = 0; i < IO_THREAD_NUM; i++){
+        startindex[i] = i*entry_num/IO_THREAD_NUM;
+        length[i] = (i+1)*entry_num/IO_THREAD_NUM - startindex[i];
+        BN_set_word(BN_range, startindex[i]);
+        RISTRETTO_mul(startpoint[i], g_half, BN_range, bn_ctx);
+    }
+    BN_free(BN_range);
+
+    uint64_t *fingerprint = new uint64_t[entry_num]();
+    vector<function<void()>> initialize_task;
+    for(auto i = 0; i < IO_THREAD_NUM; i++){
+        initialize_task.push_back(bind(RISTRETTO_vector_serialize, std::ref(g_half), std::ref(startpoint[i]),
+                                  startindex[i], length[i], fingerprint));
+    }
+    THREAD_POOL_run(initialize_task);
+
+    // insert the fingerprints into the table, then serialize it to hashmap_file
+    HASHMAP map;
+    HASHMAP_new(map, entry_num, HASHMAP_XY_MODE);
+    for(uint64_t i = 0; i < entry_num; i++) HASHMAP_insert(map, fingerprint[i], i);
+    delete[] fingerprint;
+
+    HASHMAP_Header header;
+    RISTRETTO_HASHMAP_Header_new(header, g, TABLE_SIZE, map.slot_num);
+    HASHMAP_write(map, header, hashmap_file);
+    HASHMAP_free(map);
+
+    auto end_time = chrono::steady_clock::now(); // end to count the time
+    auto running_time = end_time - start_time;
+    cout << "hash map building and serializing takes time = "
+        << chrono::duration <double, milli> (running_time).count() << " ms" << endl;
+}
+
+/* map hashmap file into ristretto_point2index_map, return false if it is missing or built for another g or TABLE_SIZE */
+bool RISTRETTO_HASHMAP_deserialize(RISTRETTO_POINT &g, string hashmap_file, uint64_t TABLE_SIZE)
+{
+    HASHMAP_Header expected_header;
+    RISTRETTO_HASHMAP_Header_new(expected_header, g, TABLE_SIZE, 0);
+    return HASHMAP_map(ristretto_point2index_map, hashmap_file, expected_header);
+}
+
+/*
+** search task: giant steps j in [start, end) of the walk from A_half = 2^{-1} A,
+** raise the stop flag for the other tasks once it finds x in [0, RANGE) with g^x = A
+*/
+void RISTRETTO_search_index(RISTRETTO_POINT &A_half, RISTRETTO_POINT &giantstep_half, RISTRETTO_TABLE &g_table,
+                            RISTRETTO_POINT &A, uint64_t TABLE_SIZE, uint64_t RANGE,
+                            uint64_t start, uint64_t end, int64_t &x, int &finding, atomic<bool> &stop)
+{
+    BN_CTX *ctx = THREAD_POOL_context()->bn_ctx;
+    BIGNUM *BN_x = BN_new();
+    RISTRETTO_CACHED step;
+    RISTRETTO_to_cached(step, giantstep_half);
+
+    // the candidate of giant step start: A_half - start*giantstep_half
+    RISTRETTO_POINT P;
+    BN_set_word(BN_x, start);
+    RISTRETTO_mul(P, giantstep_half, BN_x, ctx);
+    RISTRETTO_negate(P, P);
+    RISTRETTO_add(P, P, A_half);
+
+    vector<RISTRETTO_POINT> batch(RISTRETTO_BATCH_SIZE);
+    vector<RISTRETTO_FE> scratch(6*RISTRETTO_BATCH_SIZE);
+    uint64_t fingerprint[RISTRETTO_BATCH_SIZE];
+    for(uint64_t j = start; j < end && stop == false; ){
+        size_t num = min<uint64_t>(RISTRETTO_BATCH_SIZE, end - j);
+        for(auto k = 0; k < num; k++){
+            batch[k] = P;
+            RISTRETTO_add_cached(P, P, step, true);
+        }
+        RISTRETTO_batch_double_fingerprint(fingerprint, batch.data(), num, scratch.data());
+        for(auto k = 0; k < num; k++){
+            HASHMAP_prefetch_ahead(ristretto_point2index_map, fingerprint, k, num);
+            uint64_t i, slot = HASHMAP_FIRST_SLOT;
+            while(finding == 0 && HASHMAP_find_next(ristretto_point2index_map, fingerprint[k], slot, i) == true){
+                uint64_t candidate = (j + k)*TABLE_SIZE + i;
+                if(candidate >= RANGE) continue;
+                // rule out a false hit of the truncated fingerprint
+                RISTRETTO_POINT check;
+                BN_set_word(BN_x, candidate);
+                RISTRETTO_TABLE_mul(check, g_table, BN_x, ctx);
+                if(RISTRETTO_equal(check, A) == false) continue;
+                x = candidate;
+                finding = 1;
+                stop = true;
+            }
+            if(finding == 1) break;
+        }
+        j += num;
+    }
+    BN_free(BN_x);
+}
+
+/*
+** compute x in [lo, hi) s.t. g^x = A with the table of g, given A and A_half = 2^{-1} A;
+** g_table is the fixed-base table of g, g_half = 2^{-1} g
+*/
+bool RISTRETTO_Shanks_DLOG(BIGNUM *&x, RISTRETTO_TABLE &g_table, RISTRETTO_POINT &g_half,
+                           RISTRETTO_POINT &A, RISTRETTO_POINT &A_half,
+                           int64_t lo, int64_t hi, uint64_t TABLE_SIZE, uint64_t DEC_THREAD_NUM)
+{
+    if(HASHMAP_empty(ristretto_point2index_map) == true)
+    {
+        cout << "the hashmap is empty" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    // shift the interval to [0, hi - lo): A = A - lo*g, A_half = A_half - lo*g_half
+    BIGNUM *BN_lo = BN_new();
+    BN_set_word(BN_lo, uint64_t(lo < 0 ? -lo : lo));
+    if(lo > 0) BN_set_negative(BN_lo, 1);
+    RISTRETTO_POINT B, B_half, shift;
+    RISTRETTO_TABLE_mul(shift, g_table, BN_lo, bn_ctx);
+    RISTRETTO_add(B, A, shift);
+    RISTRETTO_mul(shift, g_half, BN_lo, bn_ctx);
+    RISTRETTO_add(B_half, A_half, shift);
+
+    // the giant step TABLE_SIZE*g_half
+    RISTRETTO_POINT giantstep_half;
+    BN_set_word(BN_lo, TABLE_SIZE);
+    RISTRETTO_mul(giantstep_half, g_half, BN_lo, bn_ctx);
+    BN_free(BN_lo);
+
+    uint64_t RANGE = uint64_t(hi) - uint64_t(lo);
+    uint64_t loop_num = (RANGE + TABLE_SIZE - 1) / TABLE_SIZE;
+
+    vector<int64_t> result(DEC_THREAD_NUM);
+    vector<int> finding(DEC_THREAD_NUM, 0);
+    atomic<bool> stop(false);
+    vector<function<void()>> searchtask;
+    for(auto i = 0; i < DEC_THREAD_NUM; i++){
+        searchtask.push_back(bind(RISTRETTO_search_index, std::ref(B_half), std::ref(giantstep_half), std::ref(g_table),
+                             std::ref(B), TABLE_SIZE, RANGE, i*loop_num/DEC_THREAD_NUM, (i+1)*loop_num/DEC_THREAD_NUM,
+                             std::ref(result[i]), std::ref(finding[i]), std::ref(stop)));
+    }
+    THREAD_POOL_run(searchtask);
+
+    for(auto i = 0; i < DEC_THREAD_NUM; i++)
+    {
+        if(finding[i] == 1)
+        {
+            Shanks_result(x, result[i] + lo);
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif
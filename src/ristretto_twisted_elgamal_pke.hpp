@@ -0,0 +1,260 @@
+/****************************************************************************
+this hpp implements twisted ElGamal PKE scheme over ristretto255
+*****************************************************************************
+* @author     This file is part of PGC, developed by Yu Chen
+* @paper      https://eprint.iacr.org/2019/319
+* @copyright  MIT license (see LICENSE file)
+*****************************************************************************/
+
+/*
+    The scheme of twisted_elgamal_pke.hpp over the group of ristretto255.hpp: X = pk^r, Y = g^r h^m,
+    decryption recovers h^m = Y X^{-sk^{-1}} and searches m with the table of h (ristretto_dlog.hpp).
+    A ciphertext is 2*RISTRETTO_POINT_LEN = 64 bytes (66 over P-256) and the table file keys the encoding of h.
+    The points are plain structs, so PP, KP and CT need no allocation beyond the BIGNUM of the secret key;
+    global_initialize is still called first, it sets up the thread pool and bn_ctx.
+*/
+
+#ifndef __RISTRETTO_TWISTED_ELGAMAL__
+#define __RISTRETTO_TWISTED_ELGAMAL__
+
+#include "../common/global.hpp"
+#include "../common/print.hpp"
+#include "../common/routines.hpp"
+
+#include "ristretto255.hpp"
+#include "ristretto_dlog.hpp"
+
+const string ristretto_hashmap_file = "r_point2index.table"; // name of hashmap file
+
+// define the structure of PP
+struct Ristretto_Twisted_ElGamal_PP
+{
+    size_t MSG_LEN; // the bit length of the size of message space
+    int64_t MSG_LO;
+    int64_t MSG_HI; // the message space [MSG_LO, MSG_HI), also the DLOG interval
+    uint64_t TABLE_SIZE; // the number of baby steps
+    size_t IO_THREAD_NUM; // the number of threads building the hash map
+    size_t DEC_THREAD_NUM; // the number of threads searching the DLOG
+
+    RISTRETTO_POINT g;
+    RISTRETTO_POINT h; // two random generators
+    RISTRETTO_POINT h_half; // 2^{-1} h: the search walks on halves (see ristretto_dlog.hpp)
+    RISTRETTO_TABLE g_table;
+    RISTRETTO_TABLE h_table; // fixed-base tables for g^r and h^m
+};
+
+// define the structure of keypair
+struct Ristretto_Twisted_ElGamal_KP
+{
+    RISTRETTO_POINT pk;  // define pk
+    BIGNUM *sk;          // define sk
+};
+
+// define the structure of ciphertext
+struct Ristretto_Twisted_ElGamal_CT
+{
+    RISTRETTO_POINT X; // X = pk^r
+    RISTRETTO_POINT Y; // Y = g^r h^m
+};
+
+void Ristretto_Twisted_ElGamal_KP_new(Ristretto_Twisted_ElGamal_KP &keypair)
+{
+    keypair.sk = BN_new();
+}
+
+void Ristretto_Twisted_ElGamal_KP_free(Ristretto_Twisted_ElGamal_KP &keypair)
+{
+    BN_free(keypair.sk);
+}
+
+void Ristretto_Twisted_ElGamal_PP_print(Ristretto_Twisted_ElGamal_PP &pp)
+{
+    cout << "the length of message space = " << pp.MSG_LEN << endl;
+    cout << "the message space = [" << pp.MSG_LO << ", " << pp.MSG_HI << ")" << endl;
+    cout << "the table size for fast decryption = " << pp.TABLE_SIZE << endl;
+    RISTRETTO_print(pp.g, "pp.g");
+    RISTRETTO_print(pp.h, "pp.h");
+}
+
+void Ristretto_Twisted_ElGamal_KP_print(Ristretto_Twisted_ElGamal_KP &keypair)
+{
+    RISTRETTO_print(keypair.pk, "pk");
+    BN_print(keypair.sk, "sk");
+}
+
+void Ristretto_Twisted_ElGamal_CT_print(Ristretto_Twisted_ElGamal_CT &CT)
+{
+    RISTRETTO_print(CT.X, "CT.X");
+    RISTRETTO_print(CT.Y, "CT.Y");
+}
+
+void Ristretto_Twisted_ElGamal_CT_serialize(Ristretto_Twisted_ElGamal_CT &CT, ofstream &fout)
+{
+    RISTRETTO_serialize(CT.X, fout);
+    RISTRETTO_serialize(CT.Y, fout);
+}
+
+/* return false if either point is not a valid encoding */
+bool Ristretto_Twisted_ElGamal_CT_deserialize(Ristretto_Twisted_ElGamal_CT &CT, ifstream &fin)
+{
+    bool valid_X = RISTRETTO_deserialize(CT.X, fin);
+    bool valid_Y = RISTRETTO_deserialize(CT.Y, fin);
+    return valid_X && valid_Y;
+}
+
+/* Setup algorithm for the message space [MSG_LO, MSG_HI) with a table of TABLE_SIZE baby steps */
+void Ristretto_Twisted_ElGamal_Interval_Setup(Ristretto_Twisted_ElGamal_PP &pp, int64_t MSG_LO, int64_t MSG_HI,
+                                              uint64_t TABLE_SIZE, size_t IO_THREAD_NUM, size_t DEC_THREAD_NUM)
+{
+    if(MSG_HI <= MSG_LO || TABLE_SIZE == 0)
+    {
+        cout << "the message space [" << MSG_LO << ", " << MSG_HI << ") or the table size is invalid" << endl;
+        exit(EXIT_FAILURE);
+    }
+    pp.MSG_LO = MSG_LO;
+    pp.MSG_HI = MSG_HI;
+    pp.TABLE_SIZE = TABLE_SIZE;
+    pp.MSG_LEN = 0;
+    for(uint64_t size = uint64_t(MSG_HI) - uint64_t(MSG_LO) - 1; size != 0; size >>= 1) pp.MSG_LEN++;
+    pp.IO_THREAD_NUM = IO_THREAD_NUM;
+    pp.DEC_THREAD_NUM = DEC_THREAD_NUM;
+
+    RISTRETTO_generator(pp.g);
+    /* generate pp.h via deterministic manner */
+    Hash_RISTRETTO_to_RISTRETTO(pp.g, pp.h);
+    RISTRETTO_mul(pp.h_half, pp.h, ristretto_scalars.half, bn_ctx);
+    RISTRETTO_TABLE_build(pp.g_table, pp.g);
+    RISTRETTO_TABLE_build(pp.h_table, pp.h);
+
+    #ifdef DEBUG
+    cout << "generate the public parameters for twisted ElGamal over ristretto255 >>>" << endl;
+    Ristretto_Twisted_ElGamal_PP_print(pp);
+    #endif
+}
+
+/* Setup algorithm for the message space [0, 2^MSG_LEN), MSG_LEN <= 62 */
+void Ristretto_Twisted_ElGamal_Setup(Ristretto_Twisted_ElGamal_PP &pp, size_t MSG_LEN, size_t TUNNING,
+                                     size_t IO_THREAD_NUM, size_t DEC_THREAD_NUM)
+{
+    Ristretto_Twisted_ElGamal_Interval_Setup(pp, 0, int64_t(1) << MSG_LEN, Shanks_table_size(MSG_LEN, TUNNING),
+                                             IO_THREAD_NUM, DEC_THREAD_NUM);
+}
+
+/* map the table of h, (re)generate it if it is missing or built for other parameters */
+void Ristretto_Twisted_ElGamal_Initialize(Ristretto_Twisted_ElGamal_PP &pp)
+{
+    cout << "initialize Twisted ElGamal Homomorphic PKE over ristretto255 >>>" << endl;
+    if(!FILE_exist(ristretto_hashmap_file)
+       || !RISTRETTO_HASHMAP_deserialize(pp.h, ristretto_hashmap_file, pp.TABLE_SIZE))
+    {
+        RISTRETTO_HASHMAP_serialize(pp.h, ristretto_hashmap_file, pp.TABLE_SIZE, pp.IO_THREAD_NUM);
+        if(!RISTRETTO_HASHMAP_deserialize(pp.h, ristretto_hashmap_file, pp.TABLE_SIZE))
+        {
+            cout << "fail to load the hash map" << endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+/* KeyGen algorithm */
+void Ristretto_Twisted_ElGamal_KeyGen(Ristretto_Twisted_ElGamal_PP &pp, Ristretto_Twisted_ElGamal_KP &keypair)
+{
+    do RISTRETTO_random(keypair.sk); while(BN_is_zero(keypair.sk)); // sk \sample Z_l^*
+    RISTRETTO_TABLE_mul(keypair.pk, pp.g_table, keypair.sk, bn_ctx); // pk = g^sk
+
+    #ifdef DEBUG
+    cout << "key generation finished >>>" << endl;
+    Ristretto_Twisted_ElGamal_KP_print(keypair);
+    #endif
+}
+
+/* Encryption algorithm: compute CT = Enc(pk, m; r) with explicit randomness */
+void Ristretto_Twisted_ElGamal_Enc(Ristretto_Twisted_ElGamal_PP &pp,
+                                   RISTRETTO_POINT &pk,
+                                   BIGNUM* &m,
+                                   BIGNUM* &r,
+                                   Ristretto_Twisted_ElGamal_CT &CT)
+{
+    RISTRETTO_mul(CT.X, pk, r, bn_ctx);            // X = pk^r
+    RISTRETTO_POINT M;
+    RISTRETTO_TABLE_mul(M, pp.h_table, m, bn_ctx);    // M = h^m
+    RISTRETTO_TABLE_mul(CT.Y, pp.g_table, r, bn_ctx); // Y = g^r
+    RISTRETTO_add(CT.Y, CT.Y, M);                     // Y = g^r h^m
+
+    #ifdef DEBUG
+        cout << "twisted ElGamal encryption finishes >>>"<< endl;
+        Ristretto_Twisted_ElGamal_CT_print(CT);
+    #endif
+}
+
+/* Encryption algorithm: compute CT = Enc(pk, m; r) */
+void Ristretto_Twisted_ElGamal_Enc(Ristretto_Twisted_ElGamal_PP &pp,
+                                   RISTRETTO_POINT &pk,
+                                   BIGNUM* &m,
+                                   Ristretto_Twisted_ElGamal_CT &CT)
+{
+    // generate the random coins
+    BIGNUM *r = BN_new();
+    RISTRETTO_random(r);
+
+    Ristretto_Twisted_ElGamal_Enc(pp, pk, m, r, CT);
+
+    BN_free(r);
+}
+
+/*
+** Decryption algorithm: compute m = Dec(sk, CT) in [MSG_LO, MSG_HI);
+** the search needs the half of h^m as well, both come from one double multiplication:
+** 2^{-1} h^m = 2^{-1} Y - (2^{-1} sk^{-1}) X
+*/
+void Ristretto_Twisted_ElGamal_Dec(Ristretto_Twisted_ElGamal_PP &pp,
+                                   BIGNUM* &sk,
+                                   Ristretto_Twisted_ElGamal_CT &CT,
+                                   BIGNUM* &m)
+{
+    BIGNUM *sk_inverse = BN_new();
+    BN_mod_inverse(sk_inverse, sk, ristretto_scalars.order, bn_ctx); // compute the inverse of sk in Z_l^*
+    BN_mod_mul(sk_inverse, sk_inverse, ristretto_scalars.half, ristretto_scalars.order, bn_ctx);
+    BN_set_negative(sk_inverse, 1);
+
+    RISTRETTO_POINT M, M_half;
+    RISTRETTO_mul2(M_half, ristretto_scalars.half, CT.Y, sk_inverse, CT.X, bn_ctx); // M_half = 2^{-1} h^m
+    RISTRETTO_double(M, M_half);                                                      // M = h^m
+
+    bool success = RISTRETTO_Shanks_DLOG(m, pp.h_table, pp.h_half, M, M_half,
+                                         pp.MSG_LO, pp.MSG_HI, pp.TABLE_SIZE, pp.DEC_THREAD_NUM);
+    BN_free(sk_inverse);
+    if(success == false)
+    {
+        cout << "decyption fails in the specified range";
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* homomorphic add */
+void Ristretto_Twisted_ElGamal_HomoAdd(Ristretto_Twisted_ElGamal_CT &CT_result,
+                                       Ristretto_Twisted_ElGamal_CT &CT1, Ristretto_Twisted_ElGamal_CT &CT2)
+{
+    RISTRETTO_add(CT_result.X, CT1.X, CT2.X);
+    RISTRETTO_add(CT_result.Y, CT1.Y, CT2.Y);
+}
+
+/* homomorphic sub */
+void Ristretto_Twisted_ElGamal_HomoSub(Ristretto_Twisted_ElGamal_CT &CT_result,
+                                       Ristretto_Twisted_ElGamal_CT &CT1, Ristretto_Twisted_ElGamal_CT &CT2)
+{
+    RISTRETTO_CACHED C;
+    RISTRETTO_to_cached(C, CT2.X);
+    RISTRETTO_add_cached(CT_result.X, CT1.X, C, true);
+    RISTRETTO_to_cached(C, CT2.Y);
+    RISTRETTO_add_cached(CT_result.Y, CT1.Y, C, true);
+}
+
+/* scalar operation */
+void Ristretto_Twisted_ElGamal_ScalarMul(Ristretto_Twisted_ElGamal_CT &CT_result, Ristretto_Twisted_ElGamal_CT &CT, BIGNUM *&k)
+{
+    RISTRETTO_mul(CT_result.X, CT.X, k, bn_ctx);
+    RISTRETTO_mul(CT_result.Y, CT.Y, k, bn_ctx);
+}
+
+#endif
@@ -0,0 +1,577 @@
+/****************************************************************************
+this hpp implements the GLV variable-base multiplication on secp256k1
+*****************************************************************************
+* @author     This file is part of PGC, developed by Yu Chen
+* @paper      https://eprint.iacr.org/2019/319
+* @copyright  MIT license (see LICENSE file)
+*****************************************************************************/
+
+/*
+    secp256k1 (y^2 = x^3 + 7 over p = 2^256 - 2^32 - 977) has the endomorphism phi(x, y) = (beta*x, y)
+    with phi(A) = lambda*A, where beta and lambda are cube roots of unity mod p and mod the order n.
+    GLV splits k = k1 + k2*lambda mod n with |k1|, |k2| < 2^129, so k*A = k1*A + k2*phi(A) takes
+    half of the doublings: both halves are recoded to width-5 wNAF and share the doublings (joint wNAF),
+    the odd multiples of A are normalised with one inversion and those of phi(A) cost one field multiplication each.
+
+    Field elements are 4x64-bit limbs below p (no Montgomery form, 2^256 = 2^32 + 977 mod p folds the product),
+    the point formulas are those of p256.hpp with a = 0 in the doubling.
+    It serves pk^r in Enc, X^{sk^{-1}} in Dec and k*CT in ScalarMul through ECP_mul, which global_initialize
+    routes here for NID_secp256k1 (group_backend = GROUP_SECP256K1_GLV).
+    Like the fixed-base tables of fast_mul.hpp, the multiplication is not constant-time.
+*/
+
+#ifndef __SECP256K1__
+#define __SECP256K1__
+
+#include "../common/global.hpp"
+#include "p256.hpp"
+
+struct SECP256K1_FE
+{
+    uint64_t v[4]; // little-endian limbs, the value is below p
+};
+
+struct SECP256K1_AFFINE
+{
+    SECP256K1_FE x, y;
+    bool infinity;
+};
+
+struct SECP256K1_JACOBIAN
+{
+    SECP256K1_FE X, Y, Z; // Z = 0 stands for the point at infinity
+};
+
+const SECP256K1_FE SECP256K1_P    = {{0xFFFFFFFEFFFFFC2FULL, 0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL}};
+const SECP256K1_FE SECP256K1_ONE  = {{1, 0, 0, 0}};
+const SECP256K1_FE SECP256K1_BETA = {{0xC1396C28719501EEULL, 0x9CF0497512F58995ULL, 0x6E64479EAC3434E9ULL, 0x7AE96A2B657C0710ULL}};
+const uint64_t SECP256K1_C = 0x1000003D1ULL; // 2^256 mod p
+
+const size_t SECP256K1_WNAF_WIDTH = 5;  // digits are odd in [-15, 15]
+const size_t SECP256K1_WNAF_LEN = 131;  // |k1|, |k2| < 2^129, plus the final carry
+const size_t SECP256K1_TABLE_SIZE = 1 << (SECP256K1_WNAF_WIDTH - 2); // A, 3A, ..., 15A
+
+/* the lattice basis of the decomposition (see the Guide to Elliptic Curve Cryptography, Sec. 3.5) */
+struct SECP256K1_GLV
+{
+    BIGNUM *lambda;
+    BIGNUM *a1, *b1, *a2, *b2; // (a1, b1), (a2, b2) with a + b*lambda = 0 mod n, b1 < 0
+    BIGNUM *half_order;
+};
+
+SECP256K1_GLV SECP256K1_GLV_new()
+{
+    SECP256K1_GLV glv = {NULL, NULL, NULL, NULL, NULL, NULL};
+    BN_hex2bn(&glv.lambda, "5363AD4CC05C30E0A5261C028812645A122E22EA20816678DF02967C1B23BD72");
+    BN_hex2bn(&glv.a1, "3086D221A7D46BCDE86C90E49284EB15");
+    BN_hex2bn(&glv.b1, "-E4437ED6010E88286F547FA90ABFE4C3");
+    BN_hex2bn(&glv.a2, "114CA50F7A8E2F3F657C1108D9D44CFD8");
+    BN_hex2bn(&glv.b2, "3086D221A7D46BCDE86C90E49284EB15");
+    BN_hex2bn(&glv.half_order, "7FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF5D576E7357A4501DDFE92F46681B20A0"); // (n-1)/2
+    return glv;
+}
+
+SECP256K1_GLV secp256k1_glv = SECP256K1_GLV_new();
+
+inline bool SECP256K1_fe_is_zero(const SECP256K1_FE &a)
+{
+    return (a.v[0] | a.v[1] | a.v[2] | a.v[3]) == 0;
+}
+
+/* r = t - p if t >= p (t < 2p is given by the 4 limbs and the carry) */
+inline void SECP256K1_fe_reduce(SECP256K1_FE &r, const uint64_t t[4], uint64_t carry)
+{
+    uint64_t s[4];
+    unsigned char borrow = 0;
+    for(auto j = 0; j < 4; j++) s[j] = P256_sbb(t[j], SECP256K1_P.v[j], borrow);
+    bool KEEP = (borrow > carry);
+    for(auto j = 0; j < 4; j++) r.v[j] = KEEP ? t[j] : s[j];
+}
+
+inline void SECP256K1_fe_add(SECP256K1_FE &r, const SECP256K1_FE &a, const SECP256K1_FE &b)
+{
+    uint64_t t[4];
+    unsigned char carry = 0;
+    for(auto j = 0; j < 4; j++) t[j] = P256_adc(a.v[j], b.v[j], carry);
+    SECP256K1_fe_reduce(r, t, carry);
+}
+
+inline void SECP256K1_fe_sub(SECP256K1_FE &r, const SECP256K1_FE &a, const SECP256K1_FE &b)
+{
+    uint64_t t[4];
+    unsigned char borrow = 0;
+    for(auto j = 0; j < 4; j++) t[j] = P256_sbb(a.v[j], b.v[j], borrow);
+    uint64_t mask = 0 - uint64_t(borrow);
+    unsigned char carry = 0;
+    for(auto j = 0; j < 4; j++) r.v[j] = P256_adc(t[j], SECP256K1_P.v[j] & mask, carry);
+}
+
+/*
+** r = a*b mod p: the high half of the 512-bit product is folded twice with 2^256 = C mod p,
+** the first fold leaves a 5th limb below 2^34, the second one at most a carry, and then r < 2p
+*/
+inline void SECP256K1_fe_mul(SECP256K1_FE &r, const SECP256K1_FE &a, const SECP256K1_FE &b)
+{
+    uint64_t t[8];
+    uint128_t s;
+    uint64_t carry = 0;
+    for(auto j = 0; j < 4; j++){
+        s = (uint128_t)a.v[j]*b.v[0] + carry;
+        t[j] = (uint64_t)s;
+        carry = (uint64_t)(s >> 64);
+    }
+    t[4] = carry;
+    for(auto i = 1; i < 4; i++){
+        carry = 0;
+        for(auto j = 0; j < 4; j++){
+            s = (uint128_t)a.v[j]*b.v[i] + t[i+j] + carry;
+            t[i+j] = (uint64_t)s;
+            carry = (uint64_t)(s >> 64);
+        }
+        t[i+4] = carry;
+    }
+
+    carry = 0;
+    for(auto j = 0; j < 4; j++){
+        s = (uint128_t)t[j+4]*SECP256K1_C + t[j] + carry;
+        t[j] = (uint64_t)s;
+        carry = (uint64_t)(s >> 64);
+    }
+    s = (uint128_t)carry*SECP256K1_C + t[0];
+    t[0] = (uint64_t)s;
+    unsigned char c = 0;
+    t[1] = P256_adc(t[1], (uint64_t)(s >> 64), c);
+    t[2] = P256_adc(t[2], 0, c);
+    t[3] = P256_adc(t[3], 0, c);
+    // a carry out wrapped t around to a value below 2^64, adding C once more cannot carry again
+    if(c){
+        c = 0;
+        t[0] = P256_adc(t[0], SECP256K1_C, c);
+        t[1] = P256_adc(t[1], 0, c);
+        t[2] = P256_adc(t[2], 0, c);
+        t[3] = P256_adc(t[3], 0, c);
+    }
+    SECP256K1_fe_reduce(r, t, 0);
+}
+
+inline void SECP256K1_fe_sqr(SECP256K1_FE &r, const SECP256K1_FE &a)
+{
+    SECP256K1_fe_mul(r, a, a);
+}
+
+inline void SECP256K1_fe_sqr_n(SECP256K1_FE &r, const SECP256K1_FE &a, size_t n)
+{
+    r = a;
+    for(auto i = 0; i < n; i++) SECP256K1_fe_sqr(r, r);
+}
+
+/* r = a^{-1} = a^{p-2} (a != 0): the addition chain of libsecp256k1, 255 squarings and 15 multiplications */
+void SECP256K1_fe_inv(SECP256K1_FE &r, const SECP256K1_FE &a)
+{
+    SECP256K1_FE x2, x3, x6, x9, x11, x22, x44, x88, x176, x220, x223, t;
+    SECP256K1_fe_sqr(x2, a);
+    SECP256K1_fe_mul(x2, x2, a);
+    SECP256K1_fe_sqr(x3, x2);
+    SECP256K1_fe_mul(x3, x3, a);
+    SECP256K1_fe_sqr_n(x6, x3, 3);
+    SECP256K1_fe_mul(x6, x6, x3);
+    SECP256K1_fe_sqr_n(x9, x6, 3);
+    SECP256K1_fe_mul(x9, x9, x3);
+    SECP256K1_fe_sqr_n(x11, x9, 2);
+    SECP256K1_fe_mul(x11, x11, x2);
+    SECP256K1_fe_sqr_n(x22, x11, 11);
+    SECP256K1_fe_mul(x22, x22, x11);
+    SECP256K1_fe_sqr_n(x44, x22, 22);
+    SECP256K1_fe_mul(x44, x44, x22);
+    SECP256K1_fe_sqr_n(x88, x44, 44);
+    SECP256K1_fe_mul(x88, x88, x44);
+    SECP256K1_fe_sqr_n(x176, x88, 88);
+    SECP256K1_fe_mul(x176, x176, x88);
+    SECP256K1_fe_sqr_n(x220, x176, 44);
+    SECP256K1_fe_mul(x220, x220, x44);
+    SECP256K1_fe_sqr_n(x223, x220, 3);
+    SECP256K1_fe_mul(x223, x223, x3);
+
+    SECP256K1_fe_sqr_n(t, x223, 23);
+    SECP256K1_fe_mul(t, t, x22);
+    SECP256K1_fe_sqr_n(t, t, 5);
+    SECP256K1_fe_mul(t, t, a);
+    SECP256K1_fe_sqr_n(t, t, 3);
+    SECP256K1_fe_mul(t, t, x2);
+    SECP256K1_fe_sqr_n(t, t, 2);
+    SECP256K1_fe_mul(r, t, a);
+}
+
+/* big-endian 32 bytes <-> limbs */
+inline void SECP256K1_fe_from_bytes(SECP256K1_FE &r, const unsigned char *buffer)
+{
+    for(auto j = 0; j < 4; j++){
+        r.v[j] = 0;
+        for(auto k = 0; k < 8; k++) r.v[j] = (r.v[j] << 8) | buffer[(3-j)*8 + k];
+    }
+}
+
+inline void SECP256K1_fe_to_bytes(unsigned char *buffer, const SECP256K1_FE &a)
+{
+    for(auto j = 0; j < 4; j++){
+        for(auto k = 0; k < 8; k++) buffer[(3-j)*8 + k] = (unsigned char)(a.v[j] >> (56 - 8*k));
+    }
+}
+
+inline void SECP256K1_set_infinity(SECP256K1_JACOBIAN &R)
+{
+    R.X = R.Y = SECP256K1_ONE;
+    R.Z.v[0] = R.Z.v[1] = R.Z.v[2] = R.Z.v[3] = 0;
+}
+
+inline void SECP256K1_jacobian_from_affine(SECP256K1_JACOBIAN &R, const SECP256K1_AFFINE &A)
+{
+    if(A.infinity){
+        SECP256K1_set_infinity(R);
+        return;
+    }
+    R.X = A.x;
+    R.Y = A.y;
+    R.Z = SECP256K1_ONE;
+}
+
+/* R = 2A (dbl-2009-l, a = 0) */
+void SECP256K1_double(SECP256K1_JACOBIAN &R, const SECP256K1_JACOBIAN &A)
+{
+    if(SECP256K1_fe_is_zero(A.Z) || SECP256K1_fe_is_zero(A.Y)){
+        SECP256K1_set_infinity(R);
+        return;
+    }
+    SECP256K1_FE XX, YY, YYYY, D, E, F, t;
+    SECP256K1_fe_sqr(XX, A.X);
+    SECP256K1_fe_sqr(YY, A.Y);
+    SECP256K1_fe_sqr(YYYY, YY);
+    SECP256K1_fe_add(t, A.X, YY);
+    SECP256K1_fe_sqr(t, t);
+    SECP256K1_fe_sub(t, t, XX);
+    SECP256K1_fe_sub(t, t, YYYY);
+    SECP256K1_fe_add(D, t, t);                 // D = 2((X + YY)^2 - XX - YYYY)
+    SECP256K1_fe_add(E, XX, XX);
+    SECP256K1_fe_add(E, E, XX);                // E = 3 XX
+    SECP256K1_fe_sqr(F, E);
+
+    SECP256K1_fe_mul(t, A.Y, A.Z);
+    SECP256K1_fe_add(R.Z, t, t);               // Z3 = 2 Y Z
+    SECP256K1_fe_sub(t, F, D);
+    SECP256K1_fe_sub(R.X, t, D);               // X3 = F - 2D
+    SECP256K1_fe_sub(t, D, R.X);
+    SECP256K1_fe_mul(t, E, t);
+    SECP256K1_fe_add(YYYY, YYYY, YYYY);
+    SECP256K1_fe_add(YYYY, YYYY, YYYY);
+    SECP256K1_fe_add(YYYY, YYYY, YYYY);        // 8 YYYY
+    SECP256K1_fe_sub(R.Y, t, YYYY);            // Y3 = E (D - X3) - 8 YYYY
+}
+
+/* R = A + B with B affine (madd-2007-bl): R may alias A */
+void SECP256K1_add_mixed(SECP256K1_JACOBIAN &R, const SECP256K1_JACOBIAN &A, const SECP256K1_AFFINE &B)
+{
+    if(B.infinity){
+        R = A;
+        return;
+    }
+    if(SECP256K1_fe_is_zero(A.Z)){
+        SECP256K1_jacobian_from_affine(R, B);
+        return;
+    }
+    SECP256K1_FE Z1Z1, U2, S2, H, HH, I, J, r, V, t;
+    SECP256K1_fe_sqr(Z1Z1, A.Z);
+    SECP256K1_fe_mul(U2, B.x, Z1Z1);
+    SECP256K1_fe_mul(S2, B.y, A.Z);
+    SECP256K1_fe_mul(S2, S2, Z1Z1);
+    SECP256K1_fe_sub(H, U2, A.X);
+    SECP256K1_fe_sub(r, S2, A.Y);
+    if(SECP256K1_fe_is_zero(H)){
+        // A = B: double, A = -B: infinity
+        if(SECP256K1_fe_is_zero(r)){
+            SECP256K1_JACOBIAN D;
+            SECP256K1_jacobian_from_affine(D, B);
+            SECP256K1_double(R, D);
+        }
+        else SECP256K1_set_infinity(R);
+        return;
+    }
+    SECP256K1_fe_sqr(HH, H);
+    SECP256K1_fe_add(I, HH, HH);
+    SECP256K1_fe_add(I, I, I);                 // I = 4 HH
+    SECP256K1_fe_mul(J, H, I);
+    SECP256K1_fe_add(r, r, r);                 // r = 2 (S2 - Y1)
+    SECP256K1_fe_mul(V, A.X, I);
+
+    SECP256K1_FE Y1J;
+    SECP256K1_fe_mul(Y1J, A.Y, J);
+    SECP256K1_fe_add(t, A.Z, H);
+    SECP256K1_fe_sqr(t, t);
+    SECP256K1_fe_sub(t, t, Z1Z1);
+    SECP256K1_fe_sub(R.Z, t, HH);              // Z3 = (Z1 + H)^2 - Z1Z1 - HH
+
+    SECP256K1_fe_sqr(t, r);
+    SECP256K1_fe_sub(t, t, J);
+    SECP256K1_fe_sub(t, t, V);
+    SECP256K1_fe_sub(R.X, t, V);               // X3 = r^2 - J - 2V
+    SECP256K1_fe_sub(t, V, R.X);
+    SECP256K1_fe_mul(t, r, t);
+    SECP256K1_fe_add(Y1J, Y1J, Y1J);
+    SECP256K1_fe_sub(R.Y, t, Y1J);             // Y3 = r (V - X3) - 2 Y1 J
+}
+
+/* R = A + B (add-2007-bl), for the table of odd multiples: R may alias A */
+void SECP256K1_add(SECP256K1_JACOBIAN &R, const SECP256K1_JACOBIAN &A, const SECP256K1_JACOBIAN &B)
+{
+    if(SECP256K1_fe_is_zero(B.Z)){
+        R = A;
+        return;
+    }
+    if(SECP256K1_fe_is_zero(A.Z)){
+        R = B;
+        return;
+    }
+    SECP256K1_FE Z1Z1, Z2Z2, U1, U2, S1, S2, H, I, J, r, V, t;
+    SECP256K1_fe_sqr(Z1Z1, A.Z);
+    SECP256K1_fe_sqr(Z2Z2, B.Z);
+    SECP256K1_fe_mul(U1, A.X, Z2Z2);
+    SECP256K1_fe_mul(U2, B.X, Z1Z1);
+    SECP256K1_fe_mul(S1, A.Y, B.Z);
+    SECP256K1_fe_mul(S1, S1, Z2Z2);
+    SECP256K1_fe_mul(S2, B.Y, A.Z);
+    SECP256K1_fe_mul(S2, S2, Z1Z1);
+    SECP256K1_fe_sub(H, U2, U1);
+    SECP256K1_fe_sub(r, S2, S1);
+    if(SECP256K1_fe_is_zero(H)){
+        if(SECP256K1_fe_is_zero(r)) SECP256K1_double(R, A);
+        else SECP256K1_set_infinity(R);
+        return;
+    }
+    SECP256K1_fe_add(I, H, H);
+    SECP256K1_fe_sqr(I, I);                    // I = (2H)^2
+    SECP256K1_fe_mul(J, H, I);
+    SECP256K1_fe_add(r, r, r);                 // r = 2 (S2 - S1)
+    SECP256K1_fe_mul(V, U1, I);
+
+    SECP256K1_fe_add(t, A.Z, B.Z);
+    SECP256K1_fe_sqr(t, t);
+    SECP256K1_fe_sub(t, t, Z1Z1);
+    SECP256K1_fe_sub(t, t, Z2Z2);
+    SECP256K1_fe_mul(R.Z, t, H);               // Z3 = ((Z1 + Z2)^2 - Z1Z1 - Z2Z2) H
+
+    SECP256K1_fe_sqr(t, r);
+    SECP256K1_fe_sub(t, t, J);
+    SECP256K1_fe_sub(t, t, V);
+    SECP256K1_fe_sub(t, t, V);                 // X3 = r^2 - J - 2V
+    SECP256K1_fe_mul(S1, S1, J);
+    SECP256K1_fe_add(S1, S1, S1);
+    SECP256K1_fe_sub(V, V, t);
+    R.X = t;
+    SECP256K1_fe_mul(V, r, V);
+    SECP256K1_fe_sub(R.Y, V, S1);              // Y3 = r (V - X3) - 2 S1 J
+}
+
+/* R[k] = J[k] in affine form for k < num (batch inversion of the Z, none of them is 0) */
+void SECP256K1_batch_normalize(SECP256K1_AFFINE *R, const SECP256K1_JACOBIAN *J, size_t num)
+{
+    SECP256K1_FE prefix[SECP256K1_TABLE_SIZE + 1];
+    SECP256K1_FE acc = SECP256K1_ONE;
+    for(auto k = 0; k < num; k++){
+        prefix[k] = acc;
+        SECP256K1_fe_mul(acc, acc, J[k].Z);
+    }
+    SECP256K1_fe_inv(acc, acc);
+    for(int k = int(num) - 1; k >= 0; k--){
+        SECP256K1_FE zinv, zinv2;
+        SECP256K1_fe_mul(zinv, acc, prefix[k]);
+        SECP256K1_fe_mul(acc, acc, J[k].Z);
+        SECP256K1_fe_sqr(zinv2, zinv);
+        SECP256K1_fe_mul(R[k].x, J[k].X, zinv2);
+        SECP256K1_fe_mul(zinv2, zinv2, zinv);
+        SECP256K1_fe_mul(R[k].y, J[k].Y, zinv2);
+        R[k].infinity = false;
+    }
+}
+
+/* R = -A */
+inline void SECP256K1_negate(SECP256K1_AFFINE &R, const SECP256K1_AFFINE &A)
+{
+    R = A;
+    if(A.infinity == false) SECP256K1_fe_sub(R.y, SECP256K1_FE{{0, 0, 0, 0}}, A.y);
+}
+
+/* the affine coordinates of P (false if P is the point at infinity) */
+bool SECP256K1_from_EC_POINT(SECP256K1_AFFINE &A, const EC_POINT *P, BN_CTX *ctx)
+{
+    A.infinity = EC_POINT_is_at_infinity(group, P);
+    if(A.infinity) return false;
+    BN_CTX_start(ctx);
+    BIGNUM *x = BN_CTX_get(ctx);
+    BIGNUM *y = BN_CTX_get(ctx);
+    EC_POINT_get_affine_coordinates(group, P, x, y, ctx);
+    unsigned char buffer[32];
+    BN_bn2binpad(x, buffer, 32);
+    SECP256K1_fe_from_bytes(A.x, buffer);
+    BN_bn2binpad(y, buffer, 32);
+    SECP256K1_fe_from_bytes(A.y, buffer);
+    BN_CTX_end(ctx);
+    return true;
+}
+
+void SECP256K1_to_EC_POINT(EC_POINT *P, const SECP256K1_JACOBIAN &A, BN_CTX *ctx)
+{
+    if(SECP256K1_fe_is_zero(A.Z)){
+        EC_POINT_set_to_infinity(group, P);
+        return;
+    }
+    SECP256K1_FE zinv, zinv2, x, y;
+    SECP256K1_fe_inv(zinv, A.Z);
+    SECP256K1_fe_sqr(zinv2, zinv);
+    SECP256K1_fe_mul(x, A.X, zinv2);
+    SECP256K1_fe_mul(zinv2, zinv2, zinv);
+    SECP256K1_fe_mul(y, A.Y, zinv2);
+
+    BN_CTX_start(ctx);
+    BIGNUM *bn_x = BN_CTX_get(ctx);
+    BIGNUM *bn_y = BN_CTX_get(ctx);
+    unsigned char buffer[32];
+    SECP256K1_fe_to_bytes(buffer, x);
+    BN_bin2bn(buffer, 32, bn_x);
+    SECP256K1_fe_to_bytes(buffer, y);
+    BN_bin2bn(buffer, 32, bn_y);
+    EC_POINT_set_affine_coordinates(group, P, bn_x, bn_y, ctx);
+    BN_CTX_end(ctx);
+}
+
+/*
+** k = k1 + k2*lambda mod n: with c1 = round(b2*k/n), c2 = round(-b1*k/n),
+** k1 = k - c1*a1 - c2*a2 and k2 = -c1*b1 - c2*b2. k is reduced mod n first
+*/
+void SECP256K1_GLV_decompose(BIGNUM *k1, BIGNUM *k2, const BIGNUM *k, BN_CTX *ctx)
+{
+    BN_CTX_start(ctx);
+    BIGNUM *e = BN_CTX_get(ctx);
+    BIGNUM *c1 = BN_CTX_get(ctx);
+    BIGNUM *c2 = BN_CTX_get(ctx);
+    BIGNUM *t = BN_CTX_get(ctx);
+
+    BN_nnmod(e, k, order, ctx);
+    BN_mul(c1, secp256k1_glv.b2, e, ctx);
+    BN_add(c1, c1, secp256k1_glv.half_order);
+    BN_div(c1, NULL, c1, order, ctx);
+    BN_mul(c2, secp256k1_glv.b1, e, ctx);
+    BN_set_negative(c2, 0);                    // -b1*k >= 0
+    BN_add(c2, c2, secp256k1_glv.half_order);
+    BN_div(c2, NULL, c2, order, ctx);
+
+    BN_mul(t, c1, secp256k1_glv.a1, ctx);
+    BN_sub(k1, e, t);
+    BN_mul(t, c2, secp256k1_glv.a2, ctx);
+    BN_sub(k1, k1, t);
+    BN_mul(k2, c1, secp256k1_glv.b1, ctx);
+    BN_set_negative(k2, !BN_is_negative(k2) && !BN_is_zero(k2));
+    BN_mul(t, c2, secp256k1_glv.b2, ctx);
+    BN_sub(k2, k2, t);
+    BN_CTX_end(ctx);
+}
+
+/*
+** the width-w NAF of |k| (k < 2^{SECP256K1_WNAF_LEN-1}): digit[i] is 0 or odd in (-2^{w-1}, 2^{w-1}),
+** any w consecutive digits hold at most one non-zero. return the number of digits up to the highest non-zero one
+*/
+size_t SECP256K1_wnaf(int digit[SECP256K1_WNAF_LEN], const BIGNUM *k)
+{
+    unsigned char buffer[24];
+    BN_bn2lebinpad(k, buffer, 24);
+    uint64_t limb[3] = {0, 0, 0};
+    for(auto j = 0; j < 24; j++) limb[j/8] |= uint64_t(buffer[j]) << (8*(j%8));
+
+    const int w = SECP256K1_WNAF_WIDTH;
+    for(auto i = 0; i < SECP256K1_WNAF_LEN; i++) digit[i] = 0;
+    size_t len = 0;
+    int carry = 0;
+    for(int bit = 0; bit < SECP256K1_WNAF_LEN; ){
+        if(int((limb[bit/64] >> (bit%64)) & 1) == carry){
+            bit++;
+            continue;
+        }
+        int now = min(w, int(SECP256K1_WNAF_LEN) - bit);
+        // the bits [bit, bit + now), which may cross a limb
+        uint64_t word = limb[bit/64] >> (bit%64);
+        if(bit%64 + now > 64 && bit/64 + 1 < 3) word |= limb[bit/64 + 1] << (64 - bit%64);
+        int d = int(word & ((1ULL << now) - 1)) + carry;
+        carry = (d >> (w-1)) & 1;
+        d -= carry << w;
+        digit[bit] = d;
+        len = bit + 1;
+        bit += now;
+    }
+    return len;
+}
+
+/* R = k*A by GLV with joint wNAF */
+void SECP256K1_GLV_mul(EC_POINT *R, const EC_POINT *A, const BIGNUM *k, BN_CTX *ctx)
+{
+    SECP256K1_AFFINE P;
+    if(SECP256K1_from_EC_POINT(P, A, ctx) == false){
+        EC_POINT_set_to_infinity(group, R);
+        return;
+    }
+
+    BN_CTX_start(ctx);
+    BIGNUM *k1 = BN_CTX_get(ctx);
+    BIGNUM *k2 = BN_CTX_get(ctx);
+    SECP256K1_GLV_decompose(k1, k2, k, ctx);
+    // the bound of the decomposition leaves room for the carry of the recoding
+    if(BN_num_bits(k1) >= SECP256K1_WNAF_LEN - 1 || BN_num_bits(k2) >= SECP256K1_WNAF_LEN - 1){
+        EC_POINT_mul(group, R, NULL, A, k, ctx);
+        BN_CTX_end(ctx);
+        return;
+    }
+    int digit1[SECP256K1_WNAF_LEN], digit2[SECP256K1_WNAF_LEN];
+    size_t len1 = SECP256K1_wnaf(digit1, k1);
+    size_t len2 = SECP256K1_wnaf(digit2, k2);
+    int sign1 = BN_is_negative(k1) ? -1 : 1;
+    int sign2 = BN_is_negative(k2) ? -1 : 1;
+    BN_CTX_end(ctx);
+
+    // table1[i] = (2i+1)*A, table2[i] = phi(table1[i]) = (2i+1)*lambda*A
+    SECP256K1_JACOBIAN J[SECP256K1_TABLE_SIZE], D;
+    SECP256K1_AFFINE table1[SECP256K1_TABLE_SIZE], table2[SECP256K1_TABLE_SIZE];
+    SECP256K1_jacobian_from_affine(J[0], P);
+    SECP256K1_double(D, J[0]);
+    for(auto i = 1; i < SECP256K1_TABLE_SIZE; i++) SECP256K1_add(J[i], J[i-1], D);
+    SECP256K1_batch_normalize(table1, J, SECP256K1_TABLE_SIZE);
+    for(auto i = 0; i < SECP256K1_TABLE_SIZE; i++){
+        SECP256K1_fe_mul(table2[i].x, table1[i].x, SECP256K1_BETA);
+        table2[i].y = table1[i].y;
+        table2[i].infinity = false;
+    }
+
+    SECP256K1_JACOBIAN Q;
+    SECP256K1_set_infinity(Q);
+    SECP256K1_AFFINE T;
+    for(int i = int(max(len1, len2)) - 1; i >= 0; i--){
+        SECP256K1_double(Q, Q);
+        int d1 = digit1[i] * sign1, d2 = digit2[i] * sign2;
+        if(d1 > 0) SECP256K1_add_mixed(Q, Q, table1[d1/2]);
+        if(d1 < 0){
+            SECP256K1_negate(T, table1[(-d1)/2]);
+            SECP256K1_add_mixed(Q, Q, T);
+        }
+        if(d2 > 0) SECP256K1_add_mixed(Q, Q, table2[d2/2]);
+        if(d2 < 0){
+            SECP256K1_negate(T, table2[(-d2)/2]);
+            SECP256K1_add_mixed(Q, Q, T);
+        }
+    }
+    SECP256K1_to_EC_POINT(R, Q, ctx);
+}
+
+/* variable-base multiplication R = k*A: GLV on secp256k1 (group_backend = GROUP_SECP256K1_GLV), OpenSSL otherwise */
+inline void ECP_mul(EC_POINT *R, const EC_POINT *A, const BIGNUM *k, BN_CTX *ctx)
+{
+    if(group_backend == GROUP_SECP256K1_GLV) SECP256K1_GLV_mul(R, A, k, ctx);
+    else EC_POINT_mul(group, R, NULL, A, k, ctx);
+}
+
+#endif
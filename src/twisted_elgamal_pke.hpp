@@ -11,21 +11,30 @@ this hpp implements twisted ElGamal PKE scheme
 #include "../common/routines.hpp"
 
 #include "calculate_dlog.hpp"
-//#include "fast_mul.hpp"
+#include "kangaroo_dlog.hpp"
+#include "fast_mul.hpp"
+#include "secp256k1.hpp"
 
 const string hashmap_file  = "h_point2index.table"; // name of hashmap file
+const string kangaroo_file = "h_kangaroo.table";    // name of kangaroo table file
 
 // define the structure of PP
 struct Twisted_ElGamal_PP
 {
-    size_t MSG_LEN; // the length of message space, also the length of the DLOG interval  
+    size_t MSG_LEN; // the bit length of the size of message space  
     BIGNUM *BN_MSG_SIZE; // the size of message space
-    size_t TUNNING; //increase this parameter in [0, RANGE_LEN/2]: larger table leads to less running time
+    int64_t MSG_LO; 
+    int64_t MSG_HI; // the message space [MSG_LO, MSG_HI), also the DLOG interval 
+    uint64_t TABLE_SIZE; // the number of baby steps: larger table leads to less running time
+    size_t TUNNING; // the log of TABLE_SIZE, or TABLE_SIZE = 2^{MSG_LEN/2 + TUNNING} if given to Setup
     size_t IO_THREAD_NUM; // optimized number of threads for faster building hash map 
     size_t DEC_THREAD_NUM; // optimized number of threads for faster decryption: CPU dependent
+    size_t DLOG_METHOD; // SHANKS, SHANKS_X_ONLY or KANGAROO: for KANGAROO the table holds 2^TUNNING distinguished points
 
     EC_POINT *g; 
     EC_POINT *h; // two random generators 
+    ECP_Precompute_Table g_table; 
+    ECP_Precompute_Table h_table; // fixed-base tables of g and h built by Setup: Y = g^r h^m is one accumulation over both
 };
 
 // define the structure of keypair
@@ -50,12 +59,45 @@ struct MR_Twisted_ElGamal_CT
     EC_POINT *Y; // Y = G^m H^r 
 };
 
+/*
+** per-key decryption state: it caches -sk^{-1} and the negated giant step, and owns its BN_CTX and 
+** scratch points, so that decryption does not allocate; use one decryptor per thread
+*/
+struct Twisted_ElGamal_Decryptor
+{
+    BIGNUM *minus_sk_inverse;   // -sk^{-1} mod order
+    EC_POINT *ECP_giantstep;    // -h^giantstep_size
+    EC_POINT *M;                // M = h^m
+    BN_CTX *ctx; 
+    SHANKS_CONTEXT sc; 
+};
+
+/*
+** offline/online encryption: a per-recipient pool of precomputed (pk^r, g^r) pairs that a background 
+** thread refills whenever it drops below half of its capacity, so an online encryption only computes h^m
+*/
+struct Twisted_ElGamal_Randomness_Pool
+{
+    EC_POINT *pk; 
+    ECP_Precompute_Table pk_table; // the refill thread computes pk^r with a fixed-base table
+    vector<EC_POINT *> X;       // ring buffer of pk^r
+    vector<EC_POINT *> Y;       // ring buffer of g^r
+    size_t head; 
+    size_t count;               // the number of ready pairs
+    mutex mtx; 
+    condition_variable refill_cv; 
+    bool stop; 
+    thread refiller; 
+};
+
 /* allocate memory for PP */ 
 void Twisted_ElGamal_PP_new(Twisted_ElGamal_PP &pp)
 { 
     pp.g = EC_POINT_new(group);
     pp.h = EC_POINT_new(group); 
     pp.BN_MSG_SIZE = BN_new(); 
+    ECP_Precompute_Table_new(pp.g_table); 
+    ECP_Precompute_Table_new(pp.h_table); 
 }
 
 /* free memory of PP */ 
@@ -64,6 +106,8 @@ void Twisted_ElGamal_PP_free(Twisted_ElGamal_PP &pp)
     EC_POINT_free(pp.g);
     EC_POINT_free(pp.h);
     BN_free(pp.BN_MSG_SIZE); 
+    ECP_Precompute_Table_free(pp.g_table); 
+    ECP_Precompute_Table_free(pp.h_table); 
 }
 
 void Twisted_ElGamal_KP_new(Twisted_ElGamal_KP &keypair)
@@ -107,7 +151,8 @@ void MR_Twisted_ElGamal_CT_free(MR_Twisted_ElGamal_CT &CT)
 void Twisted_ElGamal_PP_print(Twisted_ElGamal_PP &pp)
 {
     cout << "the length of message space = " << pp.MSG_LEN << endl; 
-    cout << "the tunning parameter for fast decryption = " << pp.TUNNING << endl;
+    cout << "the message space = [" << pp.MSG_LO << ", " << pp.MSG_HI << ")" << endl; 
+    cout << "the table size for fast decryption = " << pp.TABLE_SIZE << endl;
     ECP_print(pp.g, "pp.g"); 
     ECP_print(pp.h, "pp.h"); 
 } 
@@ -157,25 +202,42 @@ void MR_Twisted_ElGamal_CT_deserialize(MR_Twisted_ElGamal_CT &CT, ifstream& fin)
     ECP_deserialize(CT.Y, fin); 
 }
 
-/* Setup algorithm */ 
-void Twisted_ElGamal_Setup(Twisted_ElGamal_PP &pp, size_t MSG_LEN, size_t TUNNING, 
-                           size_t IO_THREAD_NUM, size_t DEC_THREAD_NUM)
+/* 
+** Setup algorithm for the message space [MSG_LO, MSG_HI) with a table of TABLE_SIZE baby steps 
+** (KANGAROO: 2^floor(log TABLE_SIZE) distinguished points); neither has to be a power of two, 
+** so a tight bound on the messages means proportionally fewer giant steps 
+*/ 
+void Twisted_ElGamal_Interval_Setup(Twisted_ElGamal_PP &pp, int64_t MSG_LO, int64_t MSG_HI, uint64_t TABLE_SIZE, 
+                                    size_t IO_THREAD_NUM, size_t DEC_THREAD_NUM, size_t DLOG_METHOD = SHANKS)
 { 
-    pp.MSG_LEN = MSG_LEN; 
-    pp.TUNNING = TUNNING; 
+    if(MSG_HI <= MSG_LO || TABLE_SIZE == 0)
+    {
+        cout << "the message space [" << MSG_LO << ", " << MSG_HI << ") or the table size is invalid" << endl; 
+        exit(EXIT_FAILURE); 
+    }
+    pp.MSG_LO = MSG_LO; 
+    pp.MSG_HI = MSG_HI; 
+    pp.TABLE_SIZE = TABLE_SIZE; 
+    pp.MSG_LEN = 0; 
+    for(uint64_t size = uint64_t(MSG_HI) - uint64_t(MSG_LO) - 1; size != 0; size >>= 1) pp.MSG_LEN++; 
+    pp.TUNNING = 0; 
+    for(uint64_t size = TABLE_SIZE; size > 1; size >>= 1) pp.TUNNING++; 
     pp.IO_THREAD_NUM = IO_THREAD_NUM;
     pp.DEC_THREAD_NUM = DEC_THREAD_NUM; 
-    /* set the message space to 2^{MSG_LEN} */
-    BN_set_word(pp.BN_MSG_SIZE, uint64_t(pow(2, pp.MSG_LEN))); 
+    pp.DLOG_METHOD = DLOG_METHOD; 
+    /* set the size of message space to MSG_HI - MSG_LO */
+    BN_set_word(pp.BN_MSG_SIZE, uint64_t(MSG_HI) - uint64_t(MSG_LO)); 
 
     #ifdef DEBUG
-    cout << "message space = [0, ";   
-    cout << BN_bn2hex(pp.BN_MSG_SIZE) << ')' << endl; 
+    cout << "message space = [" << MSG_LO << ", " << MSG_HI << ")" << endl; 
     #endif
   
     EC_POINT_copy(pp.g, generator); 
     /* generate pp.h via deterministic manner */
     Hash_ECP_to_ECP(pp.g, pp.h); 
+    /* the fixed-base tables of g and h serve every encryption under pp */
+    ECP_Precompute_Table_build(pp.g_table, pp.g); 
+    ECP_Precompute_Table_build(pp.h_table, pp.h); 
 
     #ifdef DEBUG
     cout << "generate the public parameters for twisted ElGamal >>>" << endl; 
@@ -183,18 +245,87 @@ void Twisted_ElGamal_Setup(Twisted_ElGamal_PP &pp, size_t MSG_LEN, size_t TUNNIN
     #endif
 }
 
-/* initialize the hashmap to accelerate decryption */
-void Twisted_ElGamal_Initialize(Twisted_ElGamal_PP &pp)
+/* Setup algorithm for the message space [0, 2^MSG_LEN), MSG_LEN <= 62 */ 
+void Twisted_ElGamal_Setup(Twisted_ElGamal_PP &pp, size_t MSG_LEN, size_t TUNNING, 
+                           size_t IO_THREAD_NUM, size_t DEC_THREAD_NUM, size_t DLOG_METHOD = SHANKS)
+{ 
+    // for KANGAROO the table holds 2^TUNNING distinguished points
+    uint64_t TABLE_SIZE = (DLOG_METHOD == KANGAROO) ? uint64_t(1) << TUNNING : Shanks_table_size(MSG_LEN, TUNNING); 
+    Twisted_ElGamal_Interval_Setup(pp, 0, int64_t(1) << MSG_LEN, TABLE_SIZE, IO_THREAD_NUM, DEC_THREAD_NUM, DLOG_METHOD); 
+    pp.TUNNING = TUNNING; 
+}
+
+/* initialize the hashmap to accelerate decryption, TABLE_PLACEMENT (see HASHMAP_place) moves the mapped table to huge pages */
+void Twisted_ElGamal_Initialize(Twisted_ElGamal_PP &pp, int TABLE_PLACEMENT = HASHMAP_MAPPED)
 {
     cout << "initialize Twisted ElGamal Homomorphic PKE >>>" << endl; 
-    /* generate or load the point2index.table */
-    if(!FILE_exist(hashmap_file))
+    /* load the kangaroo table, (re)generate it if it is missing or built for other parameters */
+    if(pp.DLOG_METHOD == KANGAROO)
+    {
+        if(!KANGAROO_deserialize(pp.h, kangaroo_file, pp.MSG_LEN, pp.TUNNING)){
+            KANGAROO_serialize(pp.h, kangaroo_file, pp.MSG_LEN, pp.TUNNING, pp.IO_THREAD_NUM);
+        }
+        return; 
+    }
+
+    /* map the point2index.table, (re)generate it if it is missing or built for other parameters */
+    uint32_t mode = (pp.DLOG_METHOD == SHANKS_X_ONLY) ? HASHMAP_X_MODE : HASHMAP_XY_MODE; 
+    if(!FILE_exist(hashmap_file) || !HASHMAP_deserialize(pp.h, hashmap_file, pp.TABLE_SIZE, mode))
     {
         // generate and serialize the point_2_index table
-        Parallel_HASHMAP_serialize(pp.h, hashmap_file, pp.MSG_LEN, pp.TUNNING, pp.IO_THREAD_NUM); 
+        Parallel_HASHMAP_serialize(pp.h, hashmap_file, pp.TABLE_SIZE, pp.IO_THREAD_NUM, mode);
+        // map the table from file
+        if(!HASHMAP_deserialize(pp.h, hashmap_file, pp.TABLE_SIZE, mode))
+        {
+            cout << "fail to load the hash map" << endl;
+            exit(EXIT_FAILURE);
+        }
     }
-    // load the table from file 
-    HASHMAP_deserialize(hashmap_file, pp.MSG_LEN, pp.TUNNING); 
+
+    /* back the table with huge pages and/or NUMA-local copies if asked to */
+    HASHMAP_place(point2index_map, TABLE_PLACEMENT); 
+
+    /* precompute the affine giant-step ladder, so that the candidates of the search are independent */
+    GIANTSTEP_LADDER_build(pp.h, pp.MSG_LO, pp.MSG_HI, pp.TABLE_SIZE); 
+
+    /* the small tier answers small |m| before the main table is probed */
+    SMALL_HASHMAP_build(pp.h, SMALL_TABLE_SIZE); 
+}
+
+/* 
+** enable the cache of recently decrypted messages in front of Shanks decryption (see plaintext_cache.hpp): 
+** at most capacity entries evicted by policy (CACHE_LRU or CACHE_FIFO), PLAINTEXT_CACHE_warmup preloads the expected messages
+*/
+void Twisted_ElGamal_Cache_new(Twisted_ElGamal_PP &pp, size_t capacity, int policy = CACHE_LRU)
+{
+    PLAINTEXT_CACHE_new(pp.h, capacity, policy); 
+}
+
+/* 
+** M = h^m: for m in [0, MSG_HI) the giant-step ladder built by Initialize gives h^m in a few additions, 
+** otherwise (no ladder, m out of range or negative) it falls back to the fixed-base table of h
+*/
+void encode_message(Twisted_ElGamal_PP &pp, BIGNUM *&m, EC_POINT *&M, BN_CTX *ctx)
+{
+    if(BN_is_negative(m) == 0 && BN_num_bits(m) < 64 && DLOG_encode(M, BN_get_word(m), ctx) == true) return; 
+    ECP_Precompute_Table_mul(pp.h_table, M, m, ctx); 
+}
+
+/* 
+** Y = g^r h^m: when OpenSSL serves g^r (P-256) it is g^r plus h^m of encode_message, which takes the ladder 
+** for m in [0, MSG_HI); otherwise h^m adds a few digits to the accumulation of g^r (ECP_Precompute_Table_mul2), 
+** which beats the ladder there (ladder vs mul2 for 32-bit m: 23 vs 30 us on P-256, 45 vs 32 us on secp256k1)
+*/
+void encode_Y(Twisted_ElGamal_PP &pp, BIGNUM *&r, BIGNUM *&m, EC_POINT *&Y, BN_CTX *ctx)
+{
+    if(ECP_Precompute_Table_openssl(pp.g_table) == false){
+        ECP_Precompute_Table_mul2(pp.g_table, pp.h_table, Y, r, m, ctx); 
+        return; 
+    }
+    EC_POINT *M = THREAD_POOL_context()->scratch[1]; 
+    encode_message(pp, m, M, ctx);                   // M = h^m
+    ECP_Precompute_Table_mul(pp.g_table, Y, r, ctx); // Y = g^r
+    EC_POINT_add(group, Y, Y, M, ctx);               // Y = g^r h^m
 }
 
 /* KeyGen algorithm */ 
@@ -220,8 +351,8 @@ void Twisted_ElGamal_Enc(Twisted_ElGamal_PP &pp,
     BN_random(r);
 
     // begin encryption
-    EC_POINT_mul(group, CT.X, NULL, pk, r, bn_ctx); // X = pk^r
-    EC_POINT_mul(group, CT.Y, r, pp.h, m, bn_ctx);  // Y = g^r h^m
+    ECP_mul(CT.X, pk, r, bn_ctx); // X = pk^r
+    encode_Y(pp, r, m, CT.Y, bn_ctx); // Y = g^r h^m
     
     BN_free(r); 
 
@@ -239,8 +370,25 @@ void Twisted_ElGamal_Enc(Twisted_ElGamal_PP &pp,
                          Twisted_ElGamal_CT &CT)
 { 
     // begin encryption
-    EC_POINT_mul(group, CT.X, NULL, pk, r, bn_ctx); // X = pk^r
-    EC_POINT_mul(group, CT.Y, r, pp.h, m, bn_ctx); // Y = g^r h^m
+    ECP_mul(CT.X, pk, r, bn_ctx); // X = pk^r
+    encode_Y(pp, r, m, CT.Y, bn_ctx); // Y = g^r h^m
+
+    #ifdef DEBUG
+        cout << "twisted ElGamal encryption finishes >>>"<< endl;
+        Twisted_ElGamal_CT_print(CT); 
+    #endif
+}
+
+/* encryption with the precomputed table of pk: X = pk^r is a fixed-base multiplication */
+void Twisted_ElGamal_Enc(Twisted_ElGamal_PP &pp, 
+                         ECP_Precompute_Table &pk_table, 
+                         BIGNUM* &m, 
+                         BIGNUM* &r, 
+                         Twisted_ElGamal_CT &CT)
+{ 
+    // begin encryption
+    ECP_Precompute_Table_mul(pk_table, CT.X, r, bn_ctx); // X = pk^r
+    encode_Y(pp, r, m, CT.Y, bn_ctx); // Y = g^r h^m
 
     #ifdef DEBUG
         cout << "twisted ElGamal encryption finishes >>>"<< endl;
@@ -248,6 +396,20 @@ void Twisted_ElGamal_Enc(Twisted_ElGamal_PP &pp,
     #endif
 }
 
+void Twisted_ElGamal_Enc(Twisted_ElGamal_PP &pp, 
+                         ECP_Precompute_Table &pk_table, 
+                         BIGNUM* &m, 
+                         Twisted_ElGamal_CT &CT)
+{ 
+    // generate the random coins 
+    BIGNUM *r = BN_new(); 
+    BN_random(r);
+
+    Twisted_ElGamal_Enc(pp, pk_table, m, r, CT); 
+
+    BN_free(r); 
+}
+
 /* Decryption algorithm: compute m = Dec(sk, CT) */ 
 void Twisted_ElGamal_Dec(Twisted_ElGamal_PP &pp, 
                          BIGNUM* &sk, 
@@ -259,12 +421,47 @@ void Twisted_ElGamal_Dec(Twisted_ElGamal_PP &pp,
     BN_mod_inverse(sk_inverse, sk, order, bn_ctx);  // compute the inverse of sk in Z_q^* 
 
     EC_POINT *M = EC_POINT_new(group); 
-    EC_POINT_mul(group, M, NULL, CT.X, sk_inverse, bn_ctx); // M = X^{sk^{-1}} = g^r 
+    ECP_mul(M, CT.X, sk_inverse, bn_ctx); // M = X^{sk^{-1}} = g^r 
     EC_POINT_invert(group, M, bn_ctx);          // M = -g^r
     EC_POINT_add(group, M, CT.Y, M, bn_ctx);    // M = h^m
 
     //Brute_Search(m, pp.h, M); 
-    bool success = Shanks_DLOG(m, pp.h, M, pp.MSG_LEN, pp.TUNNING); // use Shanks's algorithm to decrypt
+    bool success; 
+    if(pp.DLOG_METHOD == KANGAROO) success = Kangaroo_DLOG(m, M, pp.MSG_LO, pp.MSG_HI, bn_ctx); 
+    else success = Shanks_DLOG(m, pp.h, M, pp.MSG_LO, pp.MSG_HI, pp.TABLE_SIZE); // use Shanks's algorithm to decrypt
+  
+    BN_free(sk_inverse); 
+    EC_POINT_free(M);
+    if(success == false)
+    {
+        cout << "decyption fails in the specified range"; 
+        exit(EXIT_FAILURE); 
+    }  
+}
+
+/*
+** signed decryption: m in the centred interval of the size of message space ([-2^{MSG_LEN-1}, 2^{MSG_LEN-1}) by default) 
+** is recovered with the same table: the search starts from the identity in both directions, 
+** so a small |m| of either sign is as fast as before
+*/
+void Twisted_ElGamal_Signed_Dec(Twisted_ElGamal_PP &pp, 
+                                BIGNUM* &sk, 
+                                Twisted_ElGamal_CT &CT, 
+                                BIGNUM* &m)
+{ 
+    BIGNUM *sk_inverse = BN_new(); 
+    BN_mod_inverse(sk_inverse, sk, order, bn_ctx);  // compute the inverse of sk in Z_q^* 
+
+    EC_POINT *M = EC_POINT_new(group); 
+    ECP_mul(M, CT.X, sk_inverse, bn_ctx); // M = X^{sk^{-1}} = g^r 
+    EC_POINT_invert(group, M, bn_ctx);          // M = -g^r
+    EC_POINT_add(group, M, CT.Y, M, bn_ctx);    // M = h^m
+
+    bool success; 
+    int64_t half = (uint64_t(pp.MSG_HI) - uint64_t(pp.MSG_LO))/2; // the centred interval [-half, MSG_HI - MSG_LO - half)
+    int64_t lo = -half, hi = int64_t(uint64_t(pp.MSG_HI) - uint64_t(pp.MSG_LO) - half); 
+    if(pp.DLOG_METHOD == KANGAROO) success = Kangaroo_DLOG(m, M, lo, hi, bn_ctx); 
+    else success = Shanks_DLOG(m, pp.h, M, lo, hi, pp.TABLE_SIZE); 
   
     BN_free(sk_inverse); 
     EC_POINT_free(M);
@@ -276,13 +473,99 @@ void Twisted_ElGamal_Dec(Twisted_ElGamal_PP &pp,
 }
 
 
+/*
+** progressive decryption: the sub-ranges of prior (the most likely first) are searched first, then the search 
+** widens up to the message space. return false if m is not in the message space; the prior is ignored by KANGAROO
+*/
+bool Twisted_ElGamal_Progressive_Dec(Twisted_ElGamal_PP &pp, BIGNUM *&sk, Twisted_ElGamal_CT &CT, 
+                                     vector<DLOG_INTERVAL> &prior, BIGNUM *&m)
+{
+    BIGNUM *sk_inverse = BN_new(); 
+    BN_mod_inverse(sk_inverse, sk, order, bn_ctx);  // compute the inverse of sk in Z_q^* 
+
+    EC_POINT *M = EC_POINT_new(group); 
+    ECP_mul(M, CT.X, sk_inverse, bn_ctx); // M = X^{sk^{-1}} = g^r 
+    EC_POINT_invert(group, M, bn_ctx);          // M = -g^r
+    EC_POINT_add(group, M, CT.Y, M, bn_ctx);    // M = h^m
+
+    bool success; 
+    if(pp.DLOG_METHOD == KANGAROO) success = Kangaroo_DLOG(m, M, pp.MSG_LO, pp.MSG_HI, bn_ctx); 
+    else success = Progressive_Shanks_DLOG(m, pp.h, M, pp.MSG_LO, pp.MSG_HI, pp.TABLE_SIZE, prior); 
+
+    BN_free(sk_inverse); 
+    EC_POINT_free(M);
+    return success; 
+}
+
+/*
+** batch decryption: m[i] = Dec(sk, CT[i]) for all i, the DLOG of all ciphertexts is solved in one Shanks pass;
+** m[i] should be allocated by the caller, success[i] = 0 indicates m[i] is not in the specified range
+*/
+void Twisted_ElGamal_Batch_Dec(Twisted_ElGamal_PP &pp, BIGNUM *&sk, vector<Twisted_ElGamal_CT> &CT, 
+                               vector<BIGNUM *> &m, vector<int> &success)
+{
+    BIGNUM *sk_inverse = BN_new(); 
+    BN_mod_inverse(sk_inverse, sk, order, bn_ctx);  // compute the inverse of sk in Z_q^* 
+
+    vector<EC_POINT *> M(CT.size()); 
+    for(auto i = 0; i < CT.size(); i++){
+        M[i] = EC_POINT_new(group); 
+        ECP_mul(M[i], CT[i].X, sk_inverse, bn_ctx); // M = X^{sk^{-1}} = g^r 
+        EC_POINT_invert(group, M[i], bn_ctx);             // M = -g^r
+        EC_POINT_add(group, M[i], CT[i].Y, M[i], bn_ctx); // M = h^m
+    }
+
+    if(pp.DLOG_METHOD == KANGAROO) Batch_Kangaroo_DLOG(m, M, pp.MSG_LO, pp.MSG_HI, success); 
+    else Batch_Shanks_DLOG(m, pp.h, M, pp.MSG_LO, pp.MSG_HI, pp.TABLE_SIZE, success); 
+
+    BN_free(sk_inverse); 
+    for(auto i = 0; i < M.size(); i++){
+        EC_POINT_free(M[i]); 
+    }
+}
+
+void Twisted_ElGamal_Decryptor_new(Twisted_ElGamal_PP &pp, BIGNUM *&sk, Twisted_ElGamal_Decryptor &decryptor)
+{
+    decryptor.ctx = BN_CTX_new(); 
+    decryptor.minus_sk_inverse = BN_new(); 
+    BN_mod_inverse(decryptor.minus_sk_inverse, sk, order, decryptor.ctx);  // compute the inverse of sk in Z_q^* 
+    BN_sub(decryptor.minus_sk_inverse, order, decryptor.minus_sk_inverse); // negate it
+
+    decryptor.ECP_giantstep = EC_POINT_new(group); 
+    Shanks_giantstep(decryptor.ECP_giantstep, pp.h, pp.TABLE_SIZE, decryptor.ctx); 
+
+    decryptor.M = EC_POINT_new(group); 
+    SHANKS_CONTEXT_new(decryptor.sc, decryptor.ctx); 
+}
+
+void Twisted_ElGamal_Decryptor_free(Twisted_ElGamal_Decryptor &decryptor)
+{
+    SHANKS_CONTEXT_free(decryptor.sc); 
+    EC_POINT_free(decryptor.M); 
+    EC_POINT_free(decryptor.ECP_giantstep); 
+    BN_free(decryptor.minus_sk_inverse); 
+    BN_CTX_free(decryptor.ctx); 
+}
+
+/* decryption with a decryptor: success = false indicates m is not in the specified range */
+bool Twisted_ElGamal_Decryptor_Dec(Twisted_ElGamal_PP &pp, Twisted_ElGamal_Decryptor &decryptor, 
+                                   Twisted_ElGamal_CT &CT, BIGNUM *&m)
+{
+    ECP_mul(decryptor.M, CT.X, decryptor.minus_sk_inverse, decryptor.ctx); // M = X^{-sk^{-1}} = g^{-r}
+    EC_POINT_add(group, decryptor.M, decryptor.M, CT.Y, decryptor.ctx);      // M = Y X^{-sk^{-1}} = h^m
+
+    if(pp.DLOG_METHOD == KANGAROO) return Kangaroo_DLOG(m, decryptor.M, pp.MSG_LO, pp.MSG_HI, decryptor.ctx); 
+    return Shanks_DLOG(m, pp.h, decryptor.M, decryptor.ECP_giantstep, pp.MSG_LO, pp.MSG_HI, pp.TABLE_SIZE, 
+                       decryptor.sc); 
+}
+
 /* Encaps algorithm: compute (CT, k) = Encaps(pk, r): where CT = pk^r, k = g^r */ 
 void Twisted_ElGamal_Encaps(Twisted_ElGamal_PP &pp, EC_POINT* &pk, BIGNUM* &r, 
                             EC_POINT* &CT, EC_POINT* &KEY)
 { 
     // begin encryption
-    EC_POINT_mul(group, CT, NULL, pk, r, bn_ctx); // CT = pk^r
-    EC_POINT_mul(group, KEY, NULL, pp.g, r, bn_ctx); // KEY = g^r
+    ECP_mul(CT, pk, r, bn_ctx); // CT = pk^r
+    ECP_mul(KEY, pp.g, r, bn_ctx); // KEY = g^r
 
     #ifdef DEBUG
         cout << "twisted ElGamal encapsulation finishes >>>"<< endl;
@@ -297,7 +580,7 @@ void Twisted_ElGamal_Decaps(Twisted_ElGamal_PP &pp, BIGNUM* &sk, EC_POINT* &CT,
     //begin decryption  
     BIGNUM *sk_inverse = BN_new(); 
     BN_mod_inverse(sk_inverse, sk, order, bn_ctx);  // compute the inverse of sk in Z_q^* 
-    EC_POINT_mul(group, KEY, NULL, CT, sk_inverse, bn_ctx); // KEY = CT^{sk^{-1}} = g^r 
+    ECP_mul(KEY, CT, sk_inverse, bn_ctx); // KEY = CT^{sk^{-1}} = g^r 
 
     #ifdef DEBUG
         cout << "twisted ElGamal decapsulation finishes >>>"<< endl;
@@ -318,13 +601,13 @@ void Twisted_ElGamal_ReRand(Twisted_ElGamal_PP &pp,
     BN_mod_inverse(sk_inverse, sk, order, bn_ctx);  // compute the inverse of sk in Z_q^* 
 
     EC_POINT *M = EC_POINT_new(group); 
-    EC_POINT_mul(group, M, NULL, CT.X, sk_inverse, bn_ctx); // M = X^{sk^{-1}} = g^r 
+    ECP_mul(M, CT.X, sk_inverse, bn_ctx); // M = X^{sk^{-1}} = g^r 
     EC_POINT_invert(group, M, bn_ctx);          // M = -g^r
     EC_POINT_add(group, M, CT.Y, M, bn_ctx);    // M = h^m
 
     // begin re-encryption with the given randomness 
-    EC_POINT_mul(group, CT_new.X, NULL, pk, r, bn_ctx); // CT_new.X = pk^r 
-    EC_POINT_mul(group, CT_new.Y, r, NULL, NULL, bn_ctx); // CT_new.Y = g^r 
+    ECP_mul(CT_new.X, pk, r, bn_ctx); // CT_new.X = pk^r 
+    ECP_Precompute_Table_mul(pp.g_table, CT_new.Y, r, bn_ctx); // CT_new.Y = g^r 
 
     EC_POINT_add(group, CT_new.Y, CT_new.Y, M, bn_ctx);    // M = h^m
 
@@ -337,6 +620,33 @@ void Twisted_ElGamal_ReRand(Twisted_ElGamal_PP &pp,
     EC_POINT_free(M); 
 }
 
+/* re-randomization with the precomputed table of pk: CT_new.X = pk^r is a fixed-base multiplication */
+void Twisted_ElGamal_ReRand(Twisted_ElGamal_PP &pp, 
+                             ECP_Precompute_Table &pk_table, 
+                             BIGNUM* &sk, 
+                             Twisted_ElGamal_CT &CT, 
+                             Twisted_ElGamal_CT &CT_new, 
+                             BIGNUM* &r)
+{ 
+    // begin partial decryption  
+    BIGNUM *sk_inverse = BN_new(); 
+    BN_mod_inverse(sk_inverse, sk, order, bn_ctx);  // compute the inverse of sk in Z_q^* 
+
+    EC_POINT *M = EC_POINT_new(group); 
+    ECP_mul(M, CT.X, sk_inverse, bn_ctx); // M = X^{sk^{-1}} = g^r 
+    EC_POINT_invert(group, M, bn_ctx);          // M = -g^r
+    EC_POINT_add(group, M, CT.Y, M, bn_ctx);    // M = h^m
+
+    // begin re-encryption with the given randomness 
+    ECP_Precompute_Table_mul(pk_table, CT_new.X, r, bn_ctx); // CT_new.X = pk^r 
+    ECP_Precompute_Table_mul(pp.g_table, CT_new.Y, r, bn_ctx); // CT_new.Y = g^r 
+
+    EC_POINT_add(group, CT_new.Y, CT_new.Y, M, bn_ctx);    // CT_new.Y = g^r h^m
+
+    BN_free(sk_inverse); 
+    EC_POINT_free(M); 
+}
+
 
 /* homomorphic add */
 void Twisted_ElGamal_HomoAdd(Twisted_ElGamal_CT &CT_result, Twisted_ElGamal_CT &CT1, Twisted_ElGamal_CT &CT2)
@@ -355,8 +665,8 @@ void Twisted_ElGamal_HomoSub(Twisted_ElGamal_CT &CT_result, Twisted_ElGamal_CT &
 /* scalar operation */
 void Twisted_ElGamal_ScalarMul(Twisted_ElGamal_CT &CT_result, Twisted_ElGamal_CT &CT, BIGNUM *&k)
 { 
-    EC_POINT_mul(group, CT_result.X, NULL, CT.X, k, bn_ctx);  
-    EC_POINT_mul(group, CT_result.Y, NULL, CT.Y, k, bn_ctx);  
+    ECP_mul(CT_result.X, CT.X, k, bn_ctx);  
+    ECP_mul(CT_result.Y, CT.Y, k, bn_ctx);  
 }
 
 
@@ -370,9 +680,9 @@ void MR_Twisted_ElGamal_Enc(Twisted_ElGamal_PP &pp,
                             BIGNUM* &r, 
                             MR_Twisted_ElGamal_CT &CT)
 { 
-    EC_POINT_mul(group, CT.X1, NULL, pk1, r, bn_ctx); // CT_new.X1 = pk1^r
-    EC_POINT_mul(group, CT.X2, NULL, pk2, r, bn_ctx); // CT_new.X2 = pk2^r
-    EC_POINT_mul(group, CT.Y, r, pp.h, m, bn_ctx); // Y = g^r h^m
+    ECP_mul(CT.X1, pk1, r, bn_ctx); // CT_new.X1 = pk1^r
+    ECP_mul(CT.X2, pk2, r, bn_ctx); // CT_new.X2 = pk2^r
+    encode_Y(pp, r, m, CT.Y, bn_ctx); // Y = g^r h^m
    
     #ifdef DEBUG
         cout << "2-recipient 1-message twisted ElGamal encryption finishes >>>"<< endl;
@@ -380,29 +690,165 @@ void MR_Twisted_ElGamal_Enc(Twisted_ElGamal_PP &pp,
     #endif
 }
 
+/* 2-recipient encryption with the precomputed tables of pk1 and pk2 */
+void MR_Twisted_ElGamal_Enc(Twisted_ElGamal_PP &pp, 
+                            ECP_Precompute_Table &pk1_table, 
+                            ECP_Precompute_Table &pk2_table, 
+                            BIGNUM* &m, 
+                            BIGNUM* &r, 
+                            MR_Twisted_ElGamal_CT &CT)
+{ 
+    ECP_Precompute_Table_mul(pk1_table, CT.X1, r, bn_ctx); // CT_new.X1 = pk1^r
+    ECP_Precompute_Table_mul(pk2_table, CT.X2, r, bn_ctx); // CT_new.X2 = pk2^r
+    encode_Y(pp, r, m, CT.Y, bn_ctx); // Y = g^r h^m
+}
+
+
+/* background task: keep the pool filled with fresh (pk^r, g^r) pairs */
+void Twisted_ElGamal_Randomness_Pool_refill(Twisted_ElGamal_Randomness_Pool &pool)
+{
+    BN_CTX *ctx = BN_CTX_new(); 
+    BIGNUM *r = BN_new(); 
+    EC_POINT *X = EC_POINT_new(group); 
+    EC_POINT *Y = EC_POINT_new(group); 
+    size_t capacity = pool.X.size(); 
+
+    while(true)
+    {
+        {
+            unique_lock<mutex> lock(pool.mtx); 
+            while(pool.stop == false && pool.count > capacity/2) pool.refill_cv.wait(lock); 
+            if(pool.stop == true) break; 
+        }
+        // fill up to the capacity: the multiplications run outside the lock
+        while(true)
+        {
+            BN_random(r); 
+            ECP_Precompute_Table_mul(pool.pk_table, X, r, ctx); // X = pk^r
+            EC_POINT_mul(group, Y, r, NULL, NULL, ctx);         // Y = g^r
+
+            lock_guard<mutex> lock(pool.mtx); 
+            if(pool.stop == true || pool.count == capacity) break; 
+            size_t tail = (pool.head + pool.count) % capacity; 
+            EC_POINT_copy(pool.X[tail], X); 
+            EC_POINT_copy(pool.Y[tail], Y); 
+            pool.count++; 
+        }
+    }
+
+    BN_CTX_free(ctx); 
+    BN_free(r); 
+    EC_POINT_free(X); 
+    EC_POINT_free(Y); 
+}
+
+/* create a pool of POOL_SIZE pairs for pk and start its refill thread */
+void Twisted_ElGamal_Randomness_Pool_new(Twisted_ElGamal_PP &pp, EC_POINT *&pk, 
+                                         Twisted_ElGamal_Randomness_Pool &pool, size_t POOL_SIZE)
+{
+    pool.pk = EC_POINT_new(group); 
+    EC_POINT_copy(pool.pk, pk); 
+    ECP_Precompute_Table_new(pool.pk_table); 
+    ECP_Precompute_Table_build(pool.pk_table, pk); 
+
+    pool.X.resize(POOL_SIZE); 
+    pool.Y.resize(POOL_SIZE); 
+    for(auto i = 0; i < POOL_SIZE; i++){
+        pool.X[i] = EC_POINT_new(group); 
+        pool.Y[i] = EC_POINT_new(group); 
+    }
+    pool.head = 0; 
+    pool.count = 0; 
+    pool.stop = false; 
+    pool.refiller = thread(Twisted_ElGamal_Randomness_Pool_refill, std::ref(pool)); 
+}
+
+void Twisted_ElGamal_Randomness_Pool_free(Twisted_ElGamal_Randomness_Pool &pool)
+{
+    {
+        lock_guard<mutex> lock(pool.mtx); 
+        pool.stop = true; 
+    }
+    pool.refill_cv.notify_one(); 
+    pool.refiller.join(); 
+
+    for(auto i = 0; i < pool.X.size(); i++){
+        EC_POINT_free(pool.X[i]); 
+        EC_POINT_free(pool.Y[i]); 
+    }
+    pool.X.clear(); 
+    pool.Y.clear(); 
+    ECP_Precompute_Table_free(pool.pk_table); 
+    EC_POINT_free(pool.pk); 
+}
+
+/* the number of ready pairs */
+size_t Twisted_ElGamal_Randomness_Pool_size(Twisted_ElGamal_Randomness_Pool &pool)
+{
+    lock_guard<mutex> lock(pool.mtx); 
+    return pool.count; 
+}
+
+/* 
+** online encryption to the recipient of the pool: CT = (pk^r, g^r h^m) with a precomputed pair; 
+** if the pool is drained the pair is computed on the spot
+*/
+void Twisted_ElGamal_Online_Enc(Twisted_ElGamal_PP &pp, Twisted_ElGamal_Randomness_Pool &pool, 
+                                BIGNUM* &m, Twisted_ElGamal_CT &CT)
+{ 
+    bool ready = false; 
+    {
+        lock_guard<mutex> lock(pool.mtx); 
+        if(pool.count > 0)
+        {
+            EC_POINT_copy(CT.X, pool.X[pool.head]); // X = pk^r
+            EC_POINT_copy(CT.Y, pool.Y[pool.head]); // Y = g^r
+            pool.head = (pool.head + 1) % pool.X.size(); 
+            pool.count--; 
+            ready = true; 
+        }
+        if(pool.count <= pool.X.size()/2) pool.refill_cv.notify_one(); 
+    }
+
+    BN_CTX *ctx = THREAD_POOL_context()->bn_ctx; 
+    if(ready == false)
+    {
+        BN_CTX_start(ctx); 
+        BIGNUM *r = BN_CTX_get(ctx); 
+        BN_random(r); 
+        ECP_Precompute_Table_mul(pool.pk_table, CT.X, r, ctx); // X = pk^r
+        EC_POINT_mul(group, CT.Y, r, NULL, NULL, ctx);         // Y = g^r
+        BN_CTX_end(ctx); 
+    }
+
+    EC_POINT *M = THREAD_POOL_context()->scratch[1]; 
+    encode_message(pp, m, M, ctx);              // M = h^m
+    EC_POINT_add(group, CT.Y, CT.Y, M, ctx);    // Y = g^r h^m
+}
+
 /* parallel implementation */
 
 /*
     https://www.openssl.org/docs/manmaster/man3/BN_CTX_new.html
     A given BN_CTX must only be used by a single thread of execution. 
     No locking is performed, and the internal pool allocator will not properly handle multiple threads of execution. 
-    Thus, in multithread programming, a lazy and safe approach is setting bn_ctx = NULL
+    Thus, the tasks submitted to the thread pool take the BN_CTX of the thread that runs them
 */
 
 // parallel encryption
 inline void exp_operation(EC_POINT *&RESULT, EC_POINT *&A, BIGNUM *&r) 
 { 
-    EC_POINT_mul(group, RESULT, NULL, A, r, NULL); // RESULT = A^r
+    ECP_mul(RESULT, A, r, THREAD_POOL_context()->bn_ctx); // RESULT = A^r
 } 
 
 inline void builtin_exp_operation(EC_POINT *&RESULT, BIGNUM *&r) 
 { 
-    EC_POINT_mul(group, RESULT, r, NULL, NULL, NULL);  // RESULT = g^r 
+    EC_POINT_mul(group, RESULT, r, NULL, NULL, THREAD_POOL_context()->bn_ctx);  // RESULT = g^r 
 } 
 
-inline void multiexp_operation(EC_POINT *&RESULT, EC_POINT *&h, BIGNUM *&r, BIGNUM *&m) 
+inline void multiexp_operation(EC_POINT *&RESULT, Twisted_ElGamal_PP &pp, BIGNUM *&r, BIGNUM *&m) 
 { 
-    EC_POINT_mul(group, RESULT, r, h, m, bn_ctx);  // Y = g^r h^m
+    encode_Y(pp, r, m, RESULT, THREAD_POOL_context()->bn_ctx);  // Y = g^r h^m
 } 
 
 /* Parallel Encryption algorithm: compute CT = Enc(pk, m; r) */
@@ -412,12 +858,9 @@ void Twisted_ElGamal_Parallel_Enc(Twisted_ElGamal_PP &pp, EC_POINT *&pk, BIGNUM
     BIGNUM *r = BN_new(); 
     BN_random(r);
 
-    thread enc_thread1(exp_operation, std::ref(CT.X), std::ref(pk), std::ref(r));     // spawn new thread that calls foo()
-    thread enc_thread2(multiexp_operation, std::ref(CT.Y), std::ref(pp.h), std::ref(r), std::ref(m));
-
-    // synchronize threads
-    enc_thread1.join();                // pauses until first finishes
-    enc_thread2.join();               // pauses until second finishes
+    vector<function<void()>> task = {bind(exp_operation, std::ref(CT.X), std::ref(pk), std::ref(r)), 
+                                     bind(multiexp_operation, std::ref(CT.Y), std::ref(pp), std::ref(r), std::ref(m))}; 
+    THREAD_POOL_run(task); 
 
     BN_free(r); 
 }
@@ -431,11 +874,40 @@ void Twisted_ElGamal_Parallel_Dec(Twisted_ElGamal_PP &pp, BIGNUM *&sk, Twisted_E
     BN_mod_inverse(sk_inverse, sk, order, bn_ctx);  // compute the inverse of sk in Z_p^* 
 
     EC_POINT *M = EC_POINT_new(group); 
-    EC_POINT_mul(group, M, NULL, CT.X, sk_inverse, bn_ctx); // M = X^{sk^{-1}} = g^r 
+    ECP_mul(M, CT.X, sk_inverse, bn_ctx); // M = X^{sk^{-1}} = g^r 
+    EC_POINT_invert(group, M, bn_ctx);          // M = -g^r
+    EC_POINT_add(group, M, CT.Y, M, bn_ctx);    // M = h^m
+
+    bool success; 
+    if(pp.DLOG_METHOD == KANGAROO) success = Parallel_Kangaroo_DLOG(m, M, pp.MSG_LO, pp.MSG_HI, pp.DEC_THREAD_NUM); 
+    else success = Parallel_Shanks_DLOG(m, pp.h, M, pp.MSG_LO, pp.MSG_HI, pp.TABLE_SIZE, pp.DEC_THREAD_NUM); // use Shanks's algorithm to decrypt
+  
+    BN_free(sk_inverse); 
+    EC_POINT_free(M);
+
+    if(success == false)
+    {
+        cout << "decyption fails: cannot find the message in the specified range"; 
+        exit(EXIT_FAILURE); 
+    }  
+}
+
+/* Signed decryption algorithm: m in the centred interval of the size of message space */
+void Twisted_ElGamal_Parallel_Signed_Dec(Twisted_ElGamal_PP &pp, BIGNUM *&sk, Twisted_ElGamal_CT &CT, BIGNUM *&m)
+{ 
+    BIGNUM *sk_inverse = BN_new(); 
+    BN_mod_inverse(sk_inverse, sk, order, bn_ctx);  // compute the inverse of sk in Z_p^* 
+
+    EC_POINT *M = EC_POINT_new(group); 
+    ECP_mul(M, CT.X, sk_inverse, bn_ctx); // M = X^{sk^{-1}} = g^r 
     EC_POINT_invert(group, M, bn_ctx);          // M = -g^r
     EC_POINT_add(group, M, CT.Y, M, bn_ctx);    // M = h^m
 
-    bool success = Parallel_Shanks_DLOG(m, pp.h, M, pp.MSG_LEN, pp.TUNNING, pp.DEC_THREAD_NUM); // use Shanks's algorithm to decrypt
+    bool success; 
+    int64_t half = (uint64_t(pp.MSG_HI) - uint64_t(pp.MSG_LO))/2; // the centred interval [-half, MSG_HI - MSG_LO - half)
+    int64_t lo = -half, hi = int64_t(uint64_t(pp.MSG_HI) - uint64_t(pp.MSG_LO) - half); 
+    if(pp.DLOG_METHOD == KANGAROO) success = Parallel_Kangaroo_DLOG(m, M, lo, hi, pp.DEC_THREAD_NUM); 
+    else success = Parallel_Shanks_DLOG(m, pp.h, M, lo, hi, pp.TABLE_SIZE, pp.DEC_THREAD_NUM); 
   
     BN_free(sk_inverse); 
     EC_POINT_free(M);
@@ -456,16 +928,14 @@ void Twisted_ElGamal_Parallel_ReRand(Twisted_ElGamal_PP &pp, EC_POINT *&pk, BIGN
     BN_mod_inverse(sk_inverse, sk, order, bn_ctx);  // compute the inverse of sk in Z_p^* 
 
     EC_POINT *M = EC_POINT_new(group); 
-    EC_POINT_mul(group, M, NULL, CT.X, sk_inverse, bn_ctx); // M = X^{sk^{-1}} = g^r 
+    ECP_mul(M, CT.X, sk_inverse, bn_ctx); // M = X^{sk^{-1}} = g^r 
     EC_POINT_invert(group, M, bn_ctx);          // M = -g^r
     EC_POINT_add(group, M, CT.Y, M, bn_ctx);    // M = h^m
 
     /* re-encryption with the given randomness */
-    thread rerand_thread1(exp_operation, std::ref(CT.X), std::ref(pk), std::ref(r));
-    thread rerand_thread2(builtin_exp_operation, std::ref(CT.Y), std::ref(r));
-
-    rerand_thread1.join(); 
-    rerand_thread2.join(); 
+    vector<function<void()>> task = {bind(exp_operation, std::ref(CT.X), std::ref(pk), std::ref(r)), 
+                                     bind(builtin_exp_operation, std::ref(CT.Y), std::ref(r))}; 
+    THREAD_POOL_run(task); 
 
     EC_POINT_add(group, CT_new.Y, CT_new.Y, M, bn_ctx);    // Y = g^r h^m
 
@@ -476,42 +946,38 @@ void Twisted_ElGamal_Parallel_ReRand(Twisted_ElGamal_PP &pp, EC_POINT *&pk, BIGN
 /* parallel homomorphic add */
 inline void add_operation(EC_POINT *&RESULT, EC_POINT *&X, EC_POINT *&Y) 
 { 
-    EC_POINT_add(group, RESULT, X, Y, NULL);  
+    EC_POINT_add(group, RESULT, X, Y, THREAD_POOL_context()->bn_ctx);  
 } 
 
 void Twisted_ElGamal_Parallel_HomoAdd(Twisted_ElGamal_CT &CT_result, Twisted_ElGamal_CT &CT1, Twisted_ElGamal_CT &CT2)
 { 
-    thread add_thread1(add_operation, std::ref(CT_result.X), std::ref(CT1.X), std::ref(CT2.X));
-    thread add_thread2(add_operation, std::ref(CT_result.Y), std::ref(CT1.Y), std::ref(CT2.Y));
-
-    add_thread1.join(); 
-    add_thread2.join(); 
+    vector<function<void()>> task = {bind(add_operation, std::ref(CT_result.X), std::ref(CT1.X), std::ref(CT2.X)), 
+                                     bind(add_operation, std::ref(CT_result.Y), std::ref(CT1.Y), std::ref(CT2.Y))}; 
+    THREAD_POOL_run(task); 
 }
 
 /* parallel homomorphic sub */
 inline void sub_operation(EC_POINT *&RESULT, EC_POINT *&X, EC_POINT *&Y) 
 { 
-    EC_POINT_sub_without_bnctx(RESULT, X, Y);  
+    WORKER_CONTEXT *context = THREAD_POOL_context(); // the scratch point spares an allocation per call
+    EC_POINT_copy(context->scratch[0], Y); 
+    EC_POINT_invert(group, context->scratch[0], context->bn_ctx); 
+    EC_POINT_add(group, RESULT, X, context->scratch[0], context->bn_ctx); // RESULT = X - Y
 }
 
 void Twisted_ElGamal_Parallel_HomoSub(Twisted_ElGamal_CT &CT_result, Twisted_ElGamal_CT &CT1, Twisted_ElGamal_CT &CT2)
 { 
-    thread sub_thread1(sub_operation, std::ref(CT_result.X), std::ref(CT1.X), std::ref(CT2.X));
-    thread sub_thread2(sub_operation, std::ref(CT_result.Y), std::ref(CT1.Y), std::ref(CT2.Y));
-
-    sub_thread1.join(); 
-    sub_thread2.join(); 
+    vector<function<void()>> task = {bind(sub_operation, std::ref(CT_result.X), std::ref(CT1.X), std::ref(CT2.X)), 
+                                     bind(sub_operation, std::ref(CT_result.Y), std::ref(CT1.Y), std::ref(CT2.Y))}; 
+    THREAD_POOL_run(task); 
 }
 
 /* parallel scalar operation */
 void Twisted_ElGamal_Parallel_ScalarMul(Twisted_ElGamal_CT &CT_result, Twisted_ElGamal_CT &CT, BIGNUM *&k)
 { 
-    thread scalar_thread1(exp_operation, std::ref(CT_result.X), std::ref(CT.X), std::ref(k));
-    thread scalar_thread2(exp_operation, std::ref(CT_result.Y), std::ref(CT.Y), std::ref(k));
-    
-    // synchronize threads
-    scalar_thread1.join(); 
-    scalar_thread2.join(); 
+    vector<function<void()>> task = {bind(exp_operation, std::ref(CT_result.X), std::ref(CT.X), std::ref(k)), 
+                                     bind(exp_operation, std::ref(CT_result.Y), std::ref(CT.Y), std::ref(k))}; 
+    THREAD_POOL_run(task); 
 }
 
 
@@ -2,6 +2,15 @@
 
 #include "../src/elgamal_pke.hpp"
 
+/* compare the decrypted m' with the plaintext m, a mismatch is reported and counted in FAIL_NUM */
+void check_decryption(BIGNUM *&m, BIGNUM *&m_prime, size_t &FAIL_NUM)
+{
+    if(BN_cmp(m, m_prime) != 0){
+        cout << "decryption fails: m' != m" << endl; 
+        FAIL_NUM++; 
+    }
+}
+
 void test_elgamal(size_t MSG_LEN, size_t MAP_TUNNING, size_t IO_THREAD_NUM, size_t DEC_THREAD_NUM)
 {
     cout << "begin the basic correctness test >>>" << endl; 
@@ -21,6 +30,7 @@ void test_elgamal(size_t MSG_LEN, size_t MAP_TUNNING, size_t IO_THREAD_NUM, size
 
     BIGNUM *m = BN_new(); 
     BIGNUM *m_prime = BN_new();
+    size_t FAIL_NUM = 0; 
 
     /* random test */ 
     SplitLine_print('-'); 
@@ -31,6 +41,7 @@ void test_elgamal(size_t MSG_LEN, size_t MAP_TUNNING, size_t IO_THREAD_NUM, size
     ElGamal_Enc(pp, keypair.pk, m, CT);
     ElGamal_Dec(pp, keypair.sk, CT, m_prime); 
     BN_print(m_prime, "m'"); 
+    check_decryption(m, m_prime, FAIL_NUM); 
 
     // boundary test
     SplitLine_print('-'); 
@@ -40,6 +51,7 @@ void test_elgamal(size_t MSG_LEN, size_t MAP_TUNNING, size_t IO_THREAD_NUM, size
     ElGamal_Enc(pp, keypair.pk, m, CT);
     ElGamal_Dec(pp, keypair.sk, CT, m_prime); 
     BN_print(m_prime, "m'"); 
+    check_decryption(m, m_prime, FAIL_NUM); 
 
     SplitLine_print('-'); 
     cout << "begin the right boundary test >>>" << endl; 
@@ -48,6 +60,37 @@ void test_elgamal(size_t MSG_LEN, size_t MAP_TUNNING, size_t IO_THREAD_NUM, size
     ElGamal_Enc(pp, keypair.pk, m, CT);
     ElGamal_Dec(pp, keypair.sk, CT, m_prime); 
     BN_print(m_prime, "m'"); 
+    check_decryption(m, m_prime, FAIL_NUM); 
+
+    // signed boundary test: the centred interval [-2^{MSG_LEN-1}, 2^{MSG_LEN-1})
+    SplitLine_print('-'); 
+    cout << "begin the signed boundary test >>>" << endl; 
+    BN_rshift1(m, pp.BN_MSG_SIZE); 
+    BN_set_negative(m, 1); 
+    BN_print(m, "m"); 
+    ElGamal_Enc(pp, keypair.pk, m, CT);
+    ElGamal_Signed_Dec(pp, keypair.sk, CT, m_prime); 
+    BN_print(m_prime, "m'"); 
+    check_decryption(m, m_prime, FAIL_NUM); 
+
+    BN_set_word(m, 1); 
+    BN_set_negative(m, 1); 
+    BN_print(m, "m"); 
+    ElGamal_Enc(pp, keypair.pk, m, CT);
+    ElGamal_Signed_Dec(pp, keypair.sk, CT, m_prime); 
+    BN_print(m_prime, "m'"); 
+    check_decryption(m, m_prime, FAIL_NUM); 
+
+    BN_rshift1(m, pp.BN_MSG_SIZE); 
+    BN_sub(m, m, BN_1); 
+    BN_print(m, "m"); 
+    ElGamal_Enc(pp, keypair.pk, m, CT);
+    ElGamal_Signed_Dec(pp, keypair.sk, CT, m_prime); 
+    BN_print(m_prime, "m'"); 
+    check_decryption(m, m_prime, FAIL_NUM); 
+
+    SplitLine_print('-'); 
+    cout << "the basic correctness test fails " << FAIL_NUM << " times out of 6" << endl; 
  
     ElGamal_PP_free(pp); 
     ElGamal_KP_free(keypair); 
@@ -147,6 +190,53 @@ void benchmark_elgamal(size_t MSG_LEN, size_t MAP_TUNNING,
         } 
     }
 
+    /* test batch decryption efficiency: all ciphertexts under the first key */
+    vector<ElGamal_CT> CT_batch(TEST_NUM); 
+    vector<BIGNUM *> m_batch(TEST_NUM); 
+    vector<int> success(TEST_NUM); 
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        ElGamal_CT_new(CT_batch[i]); 
+        ElGamal_Enc(pp, keypair[0].pk, m[i], CT_batch[i]); 
+        m_batch[i] = BN_new(); 
+    }
+    start_time = chrono::steady_clock::now(); 
+    ElGamal_Batch_Dec(pp, keypair[0].sk, CT_batch, m_batch, success); 
+    end_time = chrono::steady_clock::now(); 
+    running_time = end_time - start_time;
+    cout << "average batch decryption takes time = " 
+    << chrono::duration <double, milli> (running_time).count()/TEST_NUM << " ms" << endl;
+
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        if(success[i] == 0 || BN_cmp(m[i], m_batch[i]) != 0){ 
+            cout << "batch decryption fails in the specified range" << endl;
+        } 
+    }
+
+    /* test decryptor efficiency: sk^{-1}, the giant step and the scratch state are cached */
+    ElGamal_Decryptor decryptor; 
+    ElGamal_Decryptor_new(pp, keypair[0].sk, decryptor); 
+    start_time = chrono::steady_clock::now(); 
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        success[i] = ElGamal_Decryptor_Dec(pp, decryptor, CT_batch[i], m_batch[i]); 
+    }
+    end_time = chrono::steady_clock::now(); 
+    running_time = end_time - start_time;
+    cout << "average decryptor decryption takes time = " 
+    << chrono::duration <double, milli> (running_time).count()/TEST_NUM << " ms" << endl;
+    ElGamal_Decryptor_free(decryptor); 
+
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        if(success[i] == 0 || BN_cmp(m[i], m_batch[i]) != 0){ 
+            cout << "decryptor decryption fails in the specified range" << endl;
+        } 
+        ElGamal_CT_free(CT_batch[i]); 
+        BN_free(m_batch[i]); 
+    }
+
     /* test homomorphic add efficiency */
     start_time = chrono::steady_clock::now(); 
     for(auto i = 0; i < TEST_NUM; i++)
@@ -2,90 +2,291 @@
 
 #include "../src/twisted_elgamal_pke.hpp"
 
+/* 
+** probes per second of the DLOG hash table for several prefetch windows, with and without the cuckoo filter: 
+** the fingerprints are probed in batches of SEARCH_BATCH_SIZE as in the Shanks search, 1 in 64 of them hits
+*/
+void benchmark_prefetch(size_t ENTRY_NUM, size_t PROBE_NUM)
+{
+    HASHMAP map;
+    HASHMAP_new(map, ENTRY_NUM);
+    vector<uint64_t> key(ENTRY_NUM);
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    for(auto i = 0; i < ENTRY_NUM; i++){
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17; // xorshift64
+        key[i] = state;
+        HASHMAP_insert(map, key[i], i);
+    }
+    cout << "hash table of " << ENTRY_NUM << " entries (" << map.slot_num*sizeof(HASHMAP_Entry)/(1 << 20) << " MB, filter " 
+    << map.filter_bucket_num*sizeof(uint32_t)/(1 << 20) << " MB)" << endl;
+
+    vector<uint64_t> fingerprint(PROBE_NUM);
+    for(auto k = 0; k < PROBE_NUM; k++){
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+        fingerprint[k] = (k % 64 == 0) ? key[state % ENTRY_NUM] : state;
+    }
+
+    size_t default_window = prefetch_window;
+    uint64_t filter_bucket_num = map.filter_bucket_num;
+    size_t window[5] = {0, 4, 8, 16, 32};
+    for(auto w = 0; w < 10; w++)
+    {
+        prefetch_window = window[w % 5];
+        map.filter_bucket_num = (w < 5) ? filter_bucket_num : 0; // the second round ignores the filter
+        uint64_t value, hits = 0;
+        auto start_time = chrono::steady_clock::now();
+        for(size_t base = 0; base < PROBE_NUM; base += SEARCH_BATCH_SIZE){
+            size_t num = min(SEARCH_BATCH_SIZE, PROBE_NUM - base);
+            for(auto k = 0; k < num; k++){
+                HASHMAP_prefetch_ahead(map, fingerprint.data() + base, k, num);
+                hits += HASHMAP_find(map, fingerprint[base+k], value);
+            }
+        }
+        auto end_time = chrono::steady_clock::now();
+        auto running_time = end_time - start_time;
+        cout << ((w < 5) ? "filter, " : "no filter, ") << "prefetch window = " << prefetch_window << ": " 
+        << PROBE_NUM/chrono::duration <double> (running_time).count()/1e6 << " million probes/s (" 
+        << hits << " hits)" << endl;
+    }
+    prefetch_window = default_window;
+    map.filter_bucket_num = filter_bucket_num;
+
+    HASHMAP_free(map);
+}
+
+/*
+** point additions per second of either backend (the native one for every instruction set the CPU supports), 
+** as they occur in the table build and the search: a walk P, P+g, P+2g, ... with the fingerprint of every point, 
+** and the candidates h + ladder[j] 
+*/
+void benchmark_backend(size_t ADD_NUM)
+{
+    BN_CTX *ctx = bn_ctx; 
+    EC_POINT *g = EC_POINT_dup(generator, group); 
+    EC_POINT *h = EC_POINT_new(group); 
+    BIGNUM *r = BN_new(); 
+    BN_random(r); 
+    EC_POINT_mul(group, h, r, NULL, NULL, ctx); 
+
+    vector<EC_POINT *> A(BATCH_SIZE); 
+    vector<EC_POINT *> ladder(BATCH_SIZE); 
+    for(auto k = 0; k < BATCH_SIZE; k++){
+        A[k] = EC_POINT_new(group); 
+        ladder[k] = EC_POINT_new(group); 
+        BN_set_word(r, k+1); 
+        EC_POINT_mul(group, ladder[k], r, NULL, NULL, ctx); 
+    }
+    ECP_batch_make_affine(BATCH_SIZE, ladder.data(), ctx); 
+    vector<uint64_t> fingerprint(BATCH_SIZE), native_fingerprint(BATCH_SIZE+1); 
+
+    // OpenSSL: EC_POINT_add and the batch fingerprint
+    auto start_time = chrono::steady_clock::now();
+    EC_POINT_copy(A[0], h); 
+    for(auto n = 0; n < ADD_NUM; n += BATCH_SIZE){
+        for(auto k = 1; k < BATCH_SIZE; k++) EC_POINT_add(group, A[k], A[k-1], g, ctx); 
+        ECP_batch_fingerprint(A.data(), BATCH_SIZE, fingerprint.data(), ctx); 
+        EC_POINT_add(group, A[0], A[BATCH_SIZE-1], g, ctx); 
+    }
+    auto end_time = chrono::steady_clock::now();
+    double openssl_walk = ADD_NUM/chrono::duration <double> (end_time - start_time).count(); 
+
+    start_time = chrono::steady_clock::now();
+    for(auto n = 0; n < ADD_NUM; n += BATCH_SIZE){
+        for(auto k = 0; k < BATCH_SIZE; k++) EC_POINT_add(group, A[k], h, ladder[k], ctx); 
+        ECP_batch_fingerprint(A.data(), BATCH_SIZE, fingerprint.data(), ctx); 
+    }
+    end_time = chrono::steady_clock::now();
+    double openssl_ladder = ADD_NUM/chrono::duration <double> (end_time - start_time).count(); 
+
+    // native: the walk adds the multiples k*g, the ladder is converted once
+    vector<P256_AFFINE> multiple, native_ladder(BATCH_SIZE); 
+    P256_multiples(multiple, g, BATCH_SIZE, ctx); 
+    for(auto k = 0; k < BATCH_SIZE; k++) P256_from_EC_POINT(native_ladder[k], ladder[k], ctx); 
+    P256_AFFINE startpoint, target; 
+    P256_from_EC_POINT(startpoint, h, ctx); 
+    P256_from_EC_POINT(target, h, ctx); 
+    P256_BATCH batch; 
+    P256_BATCH_new(batch, BATCH_SIZE+1); 
+
+    cout << "OpenSSL: walk " << openssl_walk/1000000 << " M adds/s, ladder " << openssl_ladder/1000000 << " M adds/s" << endl; 
+
+    const char *ISA_NAME[3] = {"scalar", "AVX2", "AVX-512 IFMA"}; 
+    int default_isa = p256_isa; 
+    for(int isa = P256_SCALAR; isa <= P256_IFMA; isa++){
+        if(P256_ISA_supported(isa) == false) continue; 
+        p256_isa = isa; 
+
+        start_time = chrono::steady_clock::now();
+        for(auto n = 0; n < ADD_NUM; n += BATCH_SIZE){
+            for(auto k = 0; k <= BATCH_SIZE; k++){
+                batch.lhs[k] = &startpoint; 
+                batch.rhs[k] = &multiple[k]; 
+            }
+            P256_BATCH_add(batch, BATCH_SIZE+1, native_fingerprint.data(), BATCH_SIZE); 
+            startpoint = batch.result[BATCH_SIZE]; 
+        }
+        end_time = chrono::steady_clock::now();
+        double native_walk = ADD_NUM/chrono::duration <double> (end_time - start_time).count(); 
+
+        start_time = chrono::steady_clock::now();
+        for(auto n = 0; n < ADD_NUM; n += BATCH_SIZE){
+            for(auto k = 0; k < BATCH_SIZE; k++){
+                batch.lhs[k] = &target; 
+                batch.rhs[k] = &native_ladder[k]; 
+            }
+            P256_BATCH_add(batch, BATCH_SIZE, native_fingerprint.data(), BATCH_SIZE); 
+        }
+        end_time = chrono::steady_clock::now();
+        double native_ladder_rate = ADD_NUM/chrono::duration <double> (end_time - start_time).count(); 
+
+        // every instruction set gives the fingerprints of OpenSSL
+        for(auto k = 0; k < BATCH_SIZE; k++){
+            if(fingerprint[k] != native_fingerprint[k]){
+                cout << "the native backend (" << ISA_NAME[isa] << ") is wrong" << endl; 
+                break; 
+            }
+        }
+        cout << "native P-256 (" << ISA_NAME[isa] << (isa == default_isa ? ", default" : "") << "): walk " 
+        << native_walk/1000000 << " M adds/s, ladder " << native_ladder_rate/1000000 << " M adds/s" << endl; 
+    }
+    p256_isa = default_isa; 
+
+    for(auto k = 0; k < BATCH_SIZE; k++){
+        EC_POINT_free(A[k]); 
+        EC_POINT_free(ladder[k]); 
+    }
+    EC_POINT_free(g); 
+    EC_POINT_free(h); 
+    BN_free(r); 
+}
+
 int main()
-{  
+{
     global_initialize(NID_X9_62_prime256v1);
- 
 
-    EC_POINT *pk = EC_POINT_new(group); 
-    BIGNUM *sk = BN_new();    
+    /* benchmark the fixed-base table of a recipient public key */
+    EC_POINT *pk = EC_POINT_new(group);
+    BIGNUM *sk = BN_new();
 
-    EC_POINT_copy(pk, generator); 
     BN_random(sk); // sk \sample Z_p
-    // EC_POINT_mul(group, pk, sk, NULL, NULL, bn_ctx); // pk = g^sk
-
-    // uint64_t window_size = 4; 
+    EC_POINT_mul(group, pk, sk, NULL, NULL, bn_ctx); // pk = g^sk
 
-    // vector<EC_POINT*> pk_precompute_table; 
-    // precompute(pk_precompute_table, pk, window_size); 
+    size_t TEST_NUM = 10000;
 
-    size_t TEST_NUM = 10000; 
-
-    BIGNUM *r[TEST_NUM]; 
+    BIGNUM *r[TEST_NUM];
     for (auto i = 0; i < TEST_NUM; i++){
-        r[i] = BN_new(); 
+        r[i] = BN_new();
         BN_random(r[i]);
-    } 
+    }
 
     EC_POINT *result1[TEST_NUM];
     EC_POINT *result2[TEST_NUM];
 
     for (auto i = 0; i < TEST_NUM; i++){
-        result1[i] = EC_POINT_new(group); 
-        result2[i] = EC_POINT_new(group); 
-    } 
+        result1[i] = EC_POINT_new(group);
+        result2[i] = EC_POINT_new(group);
+    }
 
-    EC_PRE_COMP* pk_pre_comp = EC_precompute_new(group);
-    int success = EC_fast_mul_precompute(group, pk, pk_pre_comp, bn_ctx); 
-    cout << "pre compute success = " << success << endl; 
+    auto start_time = chrono::steady_clock::now();
+    ECP_Precompute_Table pk_table;
+    ECP_Precompute_Table_new(pk_table);
+    ECP_Precompute_Table_build(pk_table, pk);
+    auto end_time = chrono::steady_clock::now();
+    auto running_time = end_time - start_time;
+    cout << "building the table (window size = " << pk_table.window_size << ", "
+    << pk_table.point.size() << " points) takes time = "
+    << chrono::duration <double, milli> (running_time).count() << " ms" << endl;
 
-    // cout << "blocksize =" << pk_pre_comp->blocksize << endl;  
-    // cout << "numblocks =" << pk_pre_comp->numblocks << endl;            
-    // cout << "window_size =" << pk_pre_comp->w << endl;
-    // cout << "num =" << pk_pre_comp->num << endl; 
+    start_time = chrono::steady_clock::now();
+    for(auto i = 0; i < TEST_NUM; i++)
+        EC_POINT_mul(group, result1[i], NULL, pk, r[i], bn_ctx); // result1 = pk^r
+    end_time = chrono::steady_clock::now();
+    running_time = end_time - start_time;
+    cout << "normal mul takes time = "
+    << chrono::duration <double, milli> (running_time).count()/TEST_NUM << " ms" << endl;
 
-    auto start_time = chrono::steady_clock::now(); 
+    start_time = chrono::steady_clock::now();
     for(auto i = 0; i < TEST_NUM; i++)
-        EC_POINT_mul(group, result1[i], r[i], NULL, NULL, bn_ctx); // result1 = pk^r
-    auto end_time = chrono::steady_clock::now(); 
-    auto running_time = end_time - start_time;
-    cout << "normal mul takes time = " 
+        ECP_Precompute_Table_mul(pk_table, result2[i], r[i], bn_ctx); // result2 = pk^r
+    end_time = chrono::steady_clock::now();
+    running_time = end_time - start_time;
+    cout << "fixed-base mul takes time = "
     << chrono::duration <double, milli> (running_time).count()/TEST_NUM << " ms" << endl;
 
+    for(auto i = 0; i < TEST_NUM; i++){
+        if(EC_POINT_cmp(group, result1[i], result2[i], bn_ctx) != 0){
+            cout << "wrong" << endl;
+            break;
+        }
+    }
+
+    /* serialize the table and load it back */
+    string table_file = "pk_precompute.table";
+    ofstream fout(table_file, ios::binary);
+    ECP_Precompute_Table_serialize(pk_table, fout);
+    fout.close();
 
-    start_time = chrono::steady_clock::now(); 
+    start_time = chrono::steady_clock::now();
+    ECP_Precompute_Table pk_table_loaded;
+    ifstream fin(table_file, ios::binary);
+    bool success = ECP_Precompute_Table_deserialize(pk_table_loaded, fin);
+    fin.close();
+    end_time = chrono::steady_clock::now();
+    running_time = end_time - start_time;
+    cout << "loading the table takes time = "
+    << chrono::duration <double, milli> (running_time).count() << " ms" << endl;
+
+    ECP_Precompute_Table_mul(pk_table_loaded, result2[0], r[0], bn_ctx);
+    if(success == false || EC_POINT_cmp(group, result1[0], result2[0], bn_ctx) != 0){
+        cout << "the loaded table is wrong" << endl;
+    }
+
+    /* g^r pk^k in one accumulation over the tables of g and pk, as for Y = g^r h^m */
+    ECP_Precompute_Table g_table;
+    ECP_Precompute_Table_new(g_table);
+    ECP_Precompute_Table_build(g_table, generator);
+
+    start_time = chrono::steady_clock::now();
     for(auto i = 0; i < TEST_NUM; i++)
-        EC_fast_mul(group, result2[i], pk, r[i], pk_pre_comp, bn_ctx); 
-        //EC_POINT_mul(group, result2[i], NULL, pk, r[i], bn_ctx); // result1 = pk^r
-    end_time = chrono::steady_clock::now(); 
+        EC_POINT_mul(group, result1[i], r[i], pk, r[TEST_NUM-1-i], bn_ctx); // result1 = g^r pk^k
+    end_time = chrono::steady_clock::now();
     running_time = end_time - start_time;
-    cout << "faster mul takes time = " 
+    cout << "normal mul2 takes time = "
     << chrono::duration <double, milli> (running_time).count()/TEST_NUM << " ms" << endl;
- 
+
+    start_time = chrono::steady_clock::now();
+    for(auto i = 0; i < TEST_NUM; i++)
+        ECP_Precompute_Table_mul2(g_table, pk_table, result2[i], r[i], r[TEST_NUM-1-i], bn_ctx); // result2 = g^r pk^k
+    end_time = chrono::steady_clock::now();
+    running_time = end_time - start_time;
+    cout << "fixed-base mul2 takes time = "
+    << chrono::duration <double, milli> (running_time).count()/TEST_NUM << " ms" << endl;
+
     for(auto i = 0; i < TEST_NUM; i++){
         if(EC_POINT_cmp(group, result1[i], result2[i], bn_ctx) != 0){
-            cout << "wrong" << endl; 
-            break; 
-        } 
+            cout << "wrong" << endl;
+            break;
+        }
     }
+    ECP_Precompute_Table_free(g_table);
 
-    // ECP_print(result1[0], "normal mul"); 
-    // ECP_print(result2[0], "faster mul"); 
+    BN_free(sk);
+    EC_POINT_free(pk);
 
-
-    BN_free(sk); 
-    EC_POINT_free(pk); 
-    
-    EC_precompute_free(pk_pre_comp); 
+    ECP_Precompute_Table_free(pk_table);
+    ECP_Precompute_Table_free(pk_table_loaded);
 
     for(auto i = 0; i < TEST_NUM; i++){
         EC_POINT_free(result1[i]);
         EC_POINT_free(result2[i]);
-        BN_free(r[i]);          
+        BN_free(r[i]);
     }
 
+    benchmark_prefetch(1 << 24, 1 << 24);
+
+    benchmark_backend(1 << 20);
 
     global_finalize();
-    
-    return 0; 
+
+    return 0;
 }
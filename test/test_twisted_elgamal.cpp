@@ -1,6 +1,7 @@
 //#define DEBUG
 
 #include "../src/twisted_elgamal_pke.hpp"
+#include "../src/ristretto_twisted_elgamal_pke.hpp"
 
 void test_basic_operation(size_t TEST_NUM)
 {
@@ -33,6 +34,14 @@ void test_basic_operation(size_t TEST_NUM)
     }
 }
 
+/* compare the decrypted m' with the plaintext m, a mismatch is reported and counted in FAIL_NUM */
+void check_decryption(BIGNUM *&m, BIGNUM *&m_prime, size_t &FAIL_NUM)
+{
+    if(BN_cmp(m, m_prime) != 0){
+        cout << "decryption fails: m' != m" << endl; 
+        FAIL_NUM++; 
+    }
+}
 
 void test_twisted_elgamal(size_t MSG_LEN, size_t MAP_TUNNING, 
                           size_t IO_THREAD_NUM, size_t DEC_THREAD_NUM)
@@ -56,6 +65,7 @@ void test_twisted_elgamal(size_t MSG_LEN, size_t MAP_TUNNING,
 
     BIGNUM *m = BN_new(); 
     BIGNUM *m_prime = BN_new();
+    size_t FAIL_NUM = 0; 
 
     /* random test */ 
     SplitLine_print('-'); 
@@ -66,6 +76,7 @@ void test_twisted_elgamal(size_t MSG_LEN, size_t MAP_TUNNING,
     Twisted_ElGamal_Enc(pp, keypair.pk, m, CT);
     Twisted_ElGamal_Dec(pp, keypair.sk, CT, m_prime); 
     BN_print(m_prime, "m'"); 
+    check_decryption(m, m_prime, FAIL_NUM); 
 
     // boundary test
     SplitLine_print('-'); 
@@ -75,6 +86,7 @@ void test_twisted_elgamal(size_t MSG_LEN, size_t MAP_TUNNING,
     Twisted_ElGamal_Enc(pp, keypair.pk, m, CT);
     Twisted_ElGamal_Dec(pp, keypair.sk, CT, m_prime); 
     BN_print(m_prime, "m'"); 
+    check_decryption(m, m_prime, FAIL_NUM); 
 
     SplitLine_print('-'); 
     cout << "begin the right boundary test >>>" << endl; 
@@ -83,6 +95,37 @@ void test_twisted_elgamal(size_t MSG_LEN, size_t MAP_TUNNING,
     Twisted_ElGamal_Enc(pp, keypair.pk, m, CT);
     Twisted_ElGamal_Dec(pp, keypair.sk, CT, m_prime); 
     BN_print(m_prime, "m'"); 
+    check_decryption(m, m_prime, FAIL_NUM); 
+
+    // signed boundary test: the centred interval [-2^{MSG_LEN-1}, 2^{MSG_LEN-1})
+    SplitLine_print('-'); 
+    cout << "begin the signed boundary test >>>" << endl; 
+    BN_rshift1(m, pp.BN_MSG_SIZE); 
+    BN_set_negative(m, 1); 
+    BN_print(m, "m"); 
+    Twisted_ElGamal_Enc(pp, keypair.pk, m, CT);
+    Twisted_ElGamal_Signed_Dec(pp, keypair.sk, CT, m_prime); 
+    BN_print(m_prime, "m'"); 
+    check_decryption(m, m_prime, FAIL_NUM); 
+
+    BN_set_word(m, 1); 
+    BN_set_negative(m, 1); 
+    BN_print(m, "m"); 
+    Twisted_ElGamal_Enc(pp, keypair.pk, m, CT);
+    Twisted_ElGamal_Signed_Dec(pp, keypair.sk, CT, m_prime); 
+    BN_print(m_prime, "m'"); 
+    check_decryption(m, m_prime, FAIL_NUM); 
+
+    BN_rshift1(m, pp.BN_MSG_SIZE); 
+    BN_sub(m, m, BN_1); 
+    BN_print(m, "m"); 
+    Twisted_ElGamal_Enc(pp, keypair.pk, m, CT);
+    Twisted_ElGamal_Signed_Dec(pp, keypair.sk, CT, m_prime); 
+    BN_print(m_prime, "m'"); 
+    check_decryption(m, m_prime, FAIL_NUM); 
+
+    SplitLine_print('-'); 
+    cout << "the basic correctness test fails " << FAIL_NUM << " times out of 6" << endl; 
  
     Twisted_ElGamal_PP_free(pp); 
     Twisted_ElGamal_KP_free(keypair); 
@@ -93,6 +136,265 @@ void test_twisted_elgamal(size_t MSG_LEN, size_t MAP_TUNNING,
 
 
 // test encapsulation mechanism
+void test_interval_twisted_elgamal(int64_t MSG_LO, int64_t MSG_HI, uint64_t TABLE_SIZE, 
+                                   size_t IO_THREAD_NUM, size_t DEC_THREAD_NUM)
+{
+    cout << "begin the interval correctness test >>>" << endl; 
+    
+    Twisted_ElGamal_PP pp; 
+    Twisted_ElGamal_PP_new(pp); 
+    
+    Twisted_ElGamal_Interval_Setup(pp, MSG_LO, MSG_HI, TABLE_SIZE, IO_THREAD_NUM, DEC_THREAD_NUM);
+    Twisted_ElGamal_Initialize(pp); 
+
+    Twisted_ElGamal_KP keypair;
+    Twisted_ElGamal_KP_new(keypair);
+    Twisted_ElGamal_KeyGen(pp, keypair); 
+
+    Twisted_ElGamal_CT CT; 
+    Twisted_ElGamal_CT_new(CT); 
+
+    BIGNUM *m = BN_new(); 
+    BIGNUM *m_prime = BN_new();
+    size_t FAIL_NUM = 0; 
+
+    // the left boundary, 0 if it lies in the interval and the right boundary
+    vector<int64_t> message = {MSG_LO, MSG_HI - 1}; 
+    if(MSG_LO < 0 && MSG_HI > 0) message.insert(message.begin() + 1, 0); 
+    for(auto i = 0; i < message.size(); i++)
+    {
+        SplitLine_print('-'); 
+        BN_set_word(m, (message[i] < 0) ? -uint64_t(message[i]) : uint64_t(message[i])); 
+        BN_set_negative(m, message[i] < 0); 
+        BN_print(m, "m"); 
+        Twisted_ElGamal_Enc(pp, keypair.pk, m, CT);
+        Twisted_ElGamal_Dec(pp, keypair.sk, CT, m_prime); 
+        BN_print(m_prime, "m'"); 
+        check_decryption(m, m_prime, FAIL_NUM); 
+    }
+    SplitLine_print('-'); 
+    cout << "the interval correctness test fails " << FAIL_NUM << " times out of " << message.size() << endl; 
+ 
+    Twisted_ElGamal_PP_free(pp); 
+    Twisted_ElGamal_KP_free(keypair); 
+    Twisted_ElGamal_CT_free(CT); 
+    BN_free(m);
+    BN_free(m_prime); 
+}
+
+/* 
+** progressive decryption over [MSG_LO, MSG_HI) with two prior sub-ranges: messages inside a prior, messages outside 
+** every prior (both edges included) must decrypt, the messages just outside the interval must be rejected
+*/
+void test_progressive_twisted_elgamal(int64_t MSG_LO, int64_t MSG_HI, uint64_t TABLE_SIZE, 
+                                      size_t IO_THREAD_NUM, size_t DEC_THREAD_NUM)
+{
+    cout << "begin the progressive decryption test >>>" << endl; 
+
+    Twisted_ElGamal_PP pp; 
+    Twisted_ElGamal_PP_new(pp); 
+    Twisted_ElGamal_Interval_Setup(pp, MSG_LO, MSG_HI, TABLE_SIZE, IO_THREAD_NUM, DEC_THREAD_NUM);
+    Twisted_ElGamal_Initialize(pp); 
+
+    Twisted_ElGamal_KP keypair;
+    Twisted_ElGamal_KP_new(keypair);
+    Twisted_ElGamal_KeyGen(pp, keypair); 
+
+    Twisted_ElGamal_CT CT; 
+    Twisted_ElGamal_CT_new(CT); 
+    BIGNUM *m = BN_new(); 
+    BIGNUM *m_prime = BN_new();
+    size_t FAIL_NUM = 0; 
+
+    // the priors sit in the upper and the lower quarter of the interval
+    int64_t quarter = (MSG_HI - MSG_LO)/4; 
+    vector<DLOG_INTERVAL> prior = {{MSG_HI - quarter, MSG_HI - quarter + 100}, {MSG_LO + quarter, MSG_LO + quarter + 1000}}; 
+    // a hit in either prior, the edges and the middle outside every prior, then the neighbours of the interval
+    vector<int64_t> message = {MSG_HI - quarter + 50, MSG_LO + quarter + 999, 
+                               MSG_LO, MSG_HI - 1, MSG_LO + (MSG_HI - MSG_LO)/2 + 7, 
+                               MSG_LO - 1, MSG_HI}; 
+    size_t IN_RANGE_NUM = 5; 
+    for(auto i = 0; i < message.size(); i++)
+    {
+        BN_set_word(m, (message[i] < 0) ? -uint64_t(message[i]) : uint64_t(message[i])); 
+        BN_set_negative(m, message[i] < 0); 
+        Twisted_ElGamal_Enc(pp, keypair.pk, m, CT);
+        bool success = Twisted_ElGamal_Progressive_Dec(pp, keypair.sk, CT, prior, m_prime); 
+        if(i < IN_RANGE_NUM){
+            if(success == false) BN_zero(m_prime); 
+            check_decryption(m, m_prime, FAIL_NUM); 
+        }
+        else if(success == true){
+            BN_print_dec(m, "progressive decryption accepts the out-of-range message"); 
+            FAIL_NUM++; 
+        }
+    }
+    SplitLine_print('-'); 
+    cout << "the progressive decryption test fails " << FAIL_NUM << " times out of " << message.size() << endl; 
+
+    Twisted_ElGamal_PP_free(pp); 
+    Twisted_ElGamal_KP_free(keypair); 
+    Twisted_ElGamal_CT_free(CT); 
+    BN_free(m);
+    BN_free(m_prime); 
+}
+
+/* 
+** decryption with the x-only table (SHANKS_X_ONLY) over [MSG_LO, MSG_HI): the edges, the neighbours of 0 and random 
+** messages must decrypt by the serial, parallel, batch and decryptor paths, the neighbours of the interval must not
+*/
+void test_x_only_twisted_elgamal(int64_t MSG_LO, int64_t MSG_HI, uint64_t TABLE_SIZE, 
+                                 size_t IO_THREAD_NUM, size_t DEC_THREAD_NUM, size_t TEST_NUM)
+{
+    cout << "begin the x-only decryption test >>>" << endl; 
+
+    Twisted_ElGamal_PP pp; 
+    Twisted_ElGamal_PP_new(pp); 
+    Twisted_ElGamal_Interval_Setup(pp, MSG_LO, MSG_HI, TABLE_SIZE, IO_THREAD_NUM, DEC_THREAD_NUM, SHANKS_X_ONLY);
+    Twisted_ElGamal_Initialize(pp); 
+
+    Twisted_ElGamal_KP keypair;
+    Twisted_ElGamal_KP_new(keypair);
+    Twisted_ElGamal_KeyGen(pp, keypair); 
+
+    vector<int64_t> message = {MSG_LO, MSG_LO + 1, MSG_HI - 2, MSG_HI - 1}; 
+    if(MSG_LO < 0 && MSG_HI > 1){
+        message.push_back(-1); 
+        message.push_back(0); 
+        message.push_back(1); 
+    }
+    BIGNUM *BN_range = BN_new(); 
+    BN_set_word(BN_range, uint64_t(MSG_HI) - uint64_t(MSG_LO)); 
+    BIGNUM *r = BN_new(); 
+    while(message.size() < TEST_NUM)
+    {
+        BN_random(r); 
+        BN_mod(r, r, BN_range, bn_ctx); 
+        message.push_back(int64_t(uint64_t(MSG_LO) + BN_get_word(r))); 
+    }
+    BN_free(r); 
+    BN_free(BN_range); 
+
+    size_t num = message.size(); 
+    vector<Twisted_ElGamal_CT> CT(num); 
+    vector<BIGNUM *> m(num); 
+    vector<BIGNUM *> m_prime(num); 
+    for(auto i = 0; i < num; i++)
+    {
+        m[i] = BN_new(); 
+        m_prime[i] = BN_new(); 
+        BN_set_word(m[i], (message[i] < 0) ? -uint64_t(message[i]) : uint64_t(message[i])); 
+        BN_set_negative(m[i], message[i] < 0); 
+        Twisted_ElGamal_CT_new(CT[i]); 
+        Twisted_ElGamal_Enc(pp, keypair.pk, m[i], CT[i]);
+    }
+
+    size_t FAIL_NUM = 0; 
+    for(auto i = 0; i < num; i++)
+    {
+        Twisted_ElGamal_Dec(pp, keypair.sk, CT[i], m_prime[i]); 
+        check_decryption(m[i], m_prime[i], FAIL_NUM); 
+        Twisted_ElGamal_Parallel_Dec(pp, keypair.sk, CT[i], m_prime[i]); 
+        check_decryption(m[i], m_prime[i], FAIL_NUM); 
+    }
+
+    vector<int> success(num); 
+    Twisted_ElGamal_Batch_Dec(pp, keypair.sk, CT, m_prime, success); 
+    for(auto i = 0; i < num; i++)
+    {
+        if(success[i] == 0) BN_zero(m_prime[i]); 
+        check_decryption(m[i], m_prime[i], FAIL_NUM); 
+    }
+
+    Twisted_ElGamal_Decryptor decryptor; 
+    Twisted_ElGamal_Decryptor_new(pp, keypair.sk, decryptor); 
+    for(auto i = 0; i < num; i++)
+    {
+        if(Twisted_ElGamal_Decryptor_Dec(pp, decryptor, CT[i], m_prime[i]) == false) BN_zero(m_prime[i]); 
+        check_decryption(m[i], m_prime[i], FAIL_NUM); 
+    }
+
+    // the neighbours of the interval must be rejected
+    vector<int64_t> outside = {MSG_LO - 1, MSG_HI}; 
+    for(auto i = 0; i < outside.size(); i++)
+    {
+        BN_set_word(m[0], (outside[i] < 0) ? -uint64_t(outside[i]) : uint64_t(outside[i])); 
+        BN_set_negative(m[0], outside[i] < 0); 
+        Twisted_ElGamal_Enc(pp, keypair.pk, m[0], CT[0]);
+        if(Twisted_ElGamal_Decryptor_Dec(pp, decryptor, CT[0], m_prime[0]) == true){
+            BN_print_dec(m[0], "x-only decryption accepts the out-of-range message"); 
+            FAIL_NUM++; 
+        }
+    }
+    Twisted_ElGamal_Decryptor_free(decryptor); 
+
+    SplitLine_print('-'); 
+    cout << "the x-only decryption test fails " << FAIL_NUM << " times out of " << 4*num + outside.size() << endl; 
+
+    for(auto i = 0; i < num; i++)
+    {
+        BN_free(m[i]); 
+        BN_free(m_prime[i]); 
+        Twisted_ElGamal_CT_free(CT[i]); 
+    }
+    Twisted_ElGamal_PP_free(pp); 
+    Twisted_ElGamal_KP_free(keypair); 
+}
+
+/* 
+** decryption with the table moved by every placement (see HASHMAP_place): the table is remapped and placed 
+** again for each one, the edges and random messages must decrypt serially and in parallel
+*/
+void test_placement_twisted_elgamal(size_t MSG_LEN, size_t MAP_TUNNING, 
+                                    size_t IO_THREAD_NUM, size_t DEC_THREAD_NUM, size_t TEST_NUM)
+{
+    cout << "begin the table placement test >>>" << endl; 
+
+    Twisted_ElGamal_PP pp; 
+    Twisted_ElGamal_PP_new(pp); 
+    Twisted_ElGamal_Setup(pp, MSG_LEN, MAP_TUNNING, IO_THREAD_NUM, DEC_THREAD_NUM);
+
+    Twisted_ElGamal_KP keypair;
+    Twisted_ElGamal_KP_new(keypair);
+    Twisted_ElGamal_KeyGen(pp, keypair); 
+
+    Twisted_ElGamal_CT CT; 
+    Twisted_ElGamal_CT_new(CT); 
+    BIGNUM *m = BN_new(); 
+    BIGNUM *m_prime = BN_new();
+    size_t FAIL_NUM = 0; 
+
+    vector<int> placement = {HASHMAP_HUGEPAGE, HASHMAP_NUMA_REPLICA, HASHMAP_NUMA_INTERLEAVE}; 
+    for(auto k = 0; k < placement.size(); k++)
+    {
+        SplitLine_print('-'); 
+        Twisted_ElGamal_Initialize(pp, placement[k]); 
+        if(point2index_map.replica_num == 0) cout << "the table stays mapped" << endl; 
+        for(auto i = 0; i < TEST_NUM; i++)
+        {
+            if(i == 0) BN_zero(m); 
+            else if(i == 1) BN_sub(m, pp.BN_MSG_SIZE, BN_1); 
+            else{
+                BN_random(m); 
+                BN_mod(m, m, pp.BN_MSG_SIZE, bn_ctx);
+            }
+            Twisted_ElGamal_Enc(pp, keypair.pk, m, CT);
+            Twisted_ElGamal_Dec(pp, keypair.sk, CT, m_prime); 
+            check_decryption(m, m_prime, FAIL_NUM); 
+            Twisted_ElGamal_Parallel_Dec(pp, keypair.sk, CT, m_prime); 
+            check_decryption(m, m_prime, FAIL_NUM); 
+        }
+    }
+    SplitLine_print('-'); 
+    cout << "the table placement test fails " << FAIL_NUM << " times out of " << 2*TEST_NUM*placement.size() << endl; 
+
+    Twisted_ElGamal_PP_free(pp); 
+    Twisted_ElGamal_KP_free(keypair); 
+    Twisted_ElGamal_CT_free(CT); 
+    BN_free(m);
+    BN_free(m_prime); 
+}
+
 void test_twisted_elgamal_encaps(size_t MSG_LEN, size_t MAP_TUNNING, 
                           size_t IO_THREAD_NUM, size_t DEC_THREAD_NUM, size_t TEST_NUM)
 {
@@ -221,6 +523,34 @@ void benchmark_twisted_elgamal(size_t MSG_LEN, size_t MAP_TUNNING,
     cout << "average encryption takes time = " 
     << chrono::duration <double, milli> (running_time).count()/TEST_NUM << " ms" << endl;
 
+    /* test online encryption efficiency: the (pk^r, g^r) pairs are precomputed by a background thread */
+    Twisted_ElGamal_Randomness_Pool pool; 
+    Twisted_ElGamal_Randomness_Pool_new(pp, keypair[0].pk, pool, TEST_NUM); 
+    while(Twisted_ElGamal_Randomness_Pool_size(pool) < TEST_NUM) this_thread::sleep_for(chrono::milliseconds(10)); 
+
+    // every online ciphertext is decrypted right away, only the encryption is timed
+    size_t FAIL_NUM = 0; 
+    Twisted_ElGamal_CT CT_online; 
+    Twisted_ElGamal_CT_new(CT_online); 
+    running_time = chrono::steady_clock::duration::zero(); 
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        start_time = chrono::steady_clock::now(); 
+        Twisted_ElGamal_Online_Enc(pp, pool, m[i], CT_online);
+        end_time = chrono::steady_clock::now(); 
+        running_time += end_time - start_time;
+
+        Twisted_ElGamal_Dec(pp, keypair[0].sk, CT_online, m_prime[i]); 
+        if(BN_cmp(m[i], m_prime[i]) != 0){ 
+            cout << "online encryption fails" << endl;
+            FAIL_NUM++; 
+        } 
+    }
+    cout << "average online encryption takes time = " 
+    << chrono::duration <double, milli> (running_time).count()/TEST_NUM << " ms" << endl;
+    Twisted_ElGamal_CT_free(CT_online); 
+    Twisted_ElGamal_Randomness_Pool_free(pool); 
+
     /* test re-randomization efficiency */
     start_time = chrono::steady_clock::now(); 
     for(auto i = 0; i < TEST_NUM; i++)
@@ -247,9 +577,79 @@ void benchmark_twisted_elgamal(size_t MSG_LEN, size_t MAP_TUNNING,
     {
         if(BN_cmp(m[i], m_prime[i]) != 0){ 
             cout << "decryption fails in the specified range" << endl;
+            FAIL_NUM++; 
         } 
     }
 
+    /* test batch decryption efficiency: all ciphertexts under the first key */
+    vector<Twisted_ElGamal_CT> CT_batch(TEST_NUM); 
+    vector<BIGNUM *> m_batch(TEST_NUM); 
+    vector<int> success(TEST_NUM); 
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        Twisted_ElGamal_CT_new(CT_batch[i]); 
+        Twisted_ElGamal_Enc(pp, keypair[0].pk, m[i], CT_batch[i]); 
+        m_batch[i] = BN_new(); 
+    }
+    start_time = chrono::steady_clock::now(); 
+    Twisted_ElGamal_Batch_Dec(pp, keypair[0].sk, CT_batch, m_batch, success); 
+    end_time = chrono::steady_clock::now(); 
+    running_time = end_time - start_time;
+    cout << "average batch decryption takes time = " 
+    << chrono::duration <double, milli> (running_time).count()/TEST_NUM << " ms" << endl;
+
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        if(success[i] == 0 || BN_cmp(m[i], m_batch[i]) != 0){ 
+            cout << "batch decryption fails in the specified range" << endl;
+            FAIL_NUM++; 
+        } 
+    }
+
+    /* test decryptor efficiency: sk^{-1}, the giant step and the scratch state are cached */
+    Twisted_ElGamal_Decryptor decryptor; 
+    Twisted_ElGamal_Decryptor_new(pp, keypair[0].sk, decryptor); 
+    start_time = chrono::steady_clock::now(); 
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        success[i] = Twisted_ElGamal_Decryptor_Dec(pp, decryptor, CT_batch[i], m_batch[i]); 
+    }
+    end_time = chrono::steady_clock::now(); 
+    running_time = end_time - start_time;
+    cout << "average decryptor decryption takes time = " 
+    << chrono::duration <double, milli> (running_time).count()/TEST_NUM << " ms" << endl;
+
+    // the messages -1 and 2^MSG_LEN just outside the range must be rejected
+    Twisted_ElGamal_CT CT_out; 
+    Twisted_ElGamal_CT_new(CT_out); 
+    BIGNUM *m_out = BN_new(); 
+    BIGNUM *m_out_prime = BN_new(); 
+    for(auto sign = 0; sign < 2; sign++)
+    {
+        if(sign == 0) BN_copy(m_out, pp.BN_MSG_SIZE); 
+        else BN_copy(m_out, BN_1); 
+        BN_set_negative(m_out, sign); 
+        Twisted_ElGamal_Enc(pp, keypair[0].pk, m_out, CT_out); 
+        if(Twisted_ElGamal_Decryptor_Dec(pp, decryptor, CT_out, m_out_prime) == true){
+            BN_print_dec(m_out, "decryptor decryption accepts the out-of-range message"); 
+            FAIL_NUM++; 
+        }
+    }
+    Twisted_ElGamal_CT_free(CT_out); 
+    BN_free(m_out); 
+    BN_free(m_out_prime); 
+    Twisted_ElGamal_Decryptor_free(decryptor); 
+
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        if(success[i] == 0 || BN_cmp(m[i], m_batch[i]) != 0){ 
+            cout << "decryptor decryption fails in the specified range" << endl;
+            FAIL_NUM++; 
+        } 
+        Twisted_ElGamal_CT_free(CT_batch[i]); 
+        BN_free(m_batch[i]); 
+    }
+
     /* test homomorphic add efficiency */
     start_time = chrono::steady_clock::now(); 
     for(auto i = 0; i < TEST_NUM; i++)
@@ -296,6 +696,8 @@ void benchmark_twisted_elgamal(size_t MSG_LEN, size_t MAP_TUNNING,
         Twisted_ElGamal_CT_free(CT_result[i]); 
     }
 
+    cout << "the decryption checks of the benchmark fail " << FAIL_NUM << " times" << endl; 
+
     Twisted_ElGamal_PP_free(pp); 
 }
 
@@ -435,6 +837,398 @@ void benchmark_parallel_twisted_elgamal(size_t MSG_LEN, size_t MAP_TUNNING,
     Twisted_ElGamal_PP_free(pp); 
 }
 
+/* 
+** benchmark the kangaroo decoder: TABLE_LEN is the log of the number of precomputed distinguished points; 
+** the first and the last EDGE_NUM messages are the edges 0, 1, ... and 2^MSG_LEN - 1, 2^MSG_LEN - 2, ... 
+** of the message space, the others are random, every decryption is checked against its plaintext 
+*/
+void benchmark_kangaroo_twisted_elgamal(size_t MSG_LEN, size_t TABLE_LEN, 
+                                        size_t IO_THREAD_NUM, size_t DEC_THREAD_NUM, 
+                                        size_t TEST_NUM)
+{
+    SplitLine_print('-'); 
+    cout << "begin the kangaroo decryption benchmark test, test_num = " << TEST_NUM << endl;
+
+    Twisted_ElGamal_PP pp; 
+    Twisted_ElGamal_PP_new(pp); 
+    Twisted_ElGamal_Setup(pp, MSG_LEN, TABLE_LEN, IO_THREAD_NUM, DEC_THREAD_NUM, KANGAROO);
+    Twisted_ElGamal_Initialize(pp); 
+
+    Twisted_ElGamal_KP keypair; 
+    Twisted_ElGamal_KP_new(keypair); 
+    Twisted_ElGamal_KeyGen(pp, keypair); 
+
+    size_t EDGE_NUM = min<size_t>(8, TEST_NUM/2); 
+    vector<Twisted_ElGamal_CT> CT(TEST_NUM); 
+    vector<BIGNUM *> m(TEST_NUM); 
+    vector<BIGNUM *> m_prime(TEST_NUM); 
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        m[i] = BN_new(); 
+        m_prime[i] = BN_new(); 
+        if(i < EDGE_NUM) BN_set_word(m[i], i); 
+        else if(i >= TEST_NUM - EDGE_NUM){
+            BN_copy(m[i], pp.BN_MSG_SIZE); 
+            BN_sub_word(m[i], TEST_NUM - i); 
+        }
+        else{
+            BN_random(m[i]); 
+            BN_mod(m[i], m[i], pp.BN_MSG_SIZE, bn_ctx);
+        }
+        Twisted_ElGamal_CT_new(CT[i]); 
+        Twisted_ElGamal_Enc(pp, keypair.pk, m[i], CT[i]);
+    }
+
+    /* test decryption efficiency */ 
+    auto start_time = chrono::steady_clock::now(); 
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        Twisted_ElGamal_Dec(pp, keypair.sk, CT[i], m_prime[i]); 
+    }
+    auto end_time = chrono::steady_clock::now(); 
+    auto running_time = end_time - start_time;
+    cout << "average decryption takes time = " 
+    << chrono::duration <double, milli> (running_time).count()/TEST_NUM << " ms" << endl;
+
+    size_t FAIL_NUM = 0; 
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        if(BN_cmp(m[i], m_prime[i]) != 0){ 
+            BN_print_dec(m[i], "decryption fails in the specified range, m"); 
+            FAIL_NUM++; 
+        } 
+    }
+
+    /* test parallel decryption efficiency */ 
+    start_time = chrono::steady_clock::now(); 
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        Twisted_ElGamal_Parallel_Dec(pp, keypair.sk, CT[i], m_prime[i]); 
+    }
+    end_time = chrono::steady_clock::now(); 
+    running_time = end_time - start_time;
+    cout << "average parallel decryption takes time = " 
+    << chrono::duration <double, milli> (running_time).count()/TEST_NUM << " ms" << endl;
+
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        if(BN_cmp(m[i], m_prime[i]) != 0){ 
+            BN_print_dec(m[i], "parallel decryption fails in the specified range, m"); 
+            FAIL_NUM++; 
+        } 
+    }
+
+    /* test batch decryption efficiency */ 
+    vector<int> success(TEST_NUM); 
+    start_time = chrono::steady_clock::now(); 
+    Twisted_ElGamal_Batch_Dec(pp, keypair.sk, CT, m_prime, success); 
+    end_time = chrono::steady_clock::now(); 
+    running_time = end_time - start_time;
+    cout << "average batch decryption takes time = " 
+    << chrono::duration <double, milli> (running_time).count()/TEST_NUM << " ms" << endl;
+
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        if(success[i] == 0 || BN_cmp(m[i], m_prime[i]) != 0){ 
+            BN_print_dec(m[i], "batch decryption fails in the specified range, m"); 
+            FAIL_NUM++; 
+        } 
+        BN_free(m[i]); 
+        BN_free(m_prime[i]); 
+        Twisted_ElGamal_CT_free(CT[i]); 
+    }
+    cout << "kangaroo decryption fails " << FAIL_NUM << " times out of " << 3*TEST_NUM << endl; 
+
+    Twisted_ElGamal_KP_free(keypair); 
+    Twisted_ElGamal_PP_free(pp); 
+}
+
+/* 
+** decryption with the plaintext cache: the messages are drawn from HOT_NUM common values (warmed up) 
+** for the most part and uniformly from the message space otherwise; the common values lie above the small tier, 
+** which would answer them without the cache, and each of them must be a cache hit
+*/
+void benchmark_cache_twisted_elgamal(size_t MSG_LEN, size_t MAP_TUNNING, 
+                                     size_t IO_THREAD_NUM, size_t DEC_THREAD_NUM, 
+                                     size_t CACHE_SIZE, size_t HOT_NUM, size_t TEST_NUM)
+{
+    SplitLine_print('-'); 
+    cout << "begin the plaintext cache benchmark test, test_num = " << TEST_NUM << endl;
+
+    Twisted_ElGamal_PP pp; 
+    Twisted_ElGamal_PP_new(pp); 
+    Twisted_ElGamal_Setup(pp, MSG_LEN, MAP_TUNNING, IO_THREAD_NUM, DEC_THREAD_NUM);
+    Twisted_ElGamal_Initialize(pp); 
+
+    Twisted_ElGamal_KP keypair; 
+    Twisted_ElGamal_KP_new(keypair); 
+    Twisted_ElGamal_KeyGen(pp, keypair); 
+
+    // the common values are spread over [SMALL_TABLE_SIZE, 2^MSG_LEN)
+    vector<int64_t> hot(HOT_NUM); 
+    uint64_t hot_step = (BN_get_word(pp.BN_MSG_SIZE) - SMALL_TABLE_SIZE)/HOT_NUM; 
+    for(auto i = 0; i < HOT_NUM; i++) hot[i] = SMALL_TABLE_SIZE + i*hot_step; 
+    size_t HOT_MSG_NUM = 0; // the messages drawn from the common values
+
+    vector<Twisted_ElGamal_CT> CT(TEST_NUM); 
+    vector<BIGNUM *> m(TEST_NUM); 
+    vector<BIGNUM *> m_prime(TEST_NUM); 
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        m[i] = BN_new(); 
+        m_prime[i] = BN_new(); 
+        BN_random(m[i]); 
+        BN_mod(m[i], m[i], pp.BN_MSG_SIZE, bn_ctx);
+        if(i % 10 != 0){
+            BN_set_word(m[i], hot[BN_mod_word(m[i], HOT_NUM)]); 
+            HOT_MSG_NUM++; 
+        }
+        Twisted_ElGamal_CT_new(CT[i]); 
+        Twisted_ElGamal_Enc(pp, keypair.pk, m[i], CT[i]);
+    }
+
+    /* test decryption efficiency without cache */ 
+    auto start_time = chrono::steady_clock::now(); 
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        Twisted_ElGamal_Dec(pp, keypair.sk, CT[i], m_prime[i]); 
+    }
+    auto end_time = chrono::steady_clock::now(); 
+    auto running_time = end_time - start_time;
+    cout << "average decryption without cache takes time = " 
+    << chrono::duration <double, milli> (running_time).count()/TEST_NUM << " ms" << endl;
+
+    size_t FAIL_NUM = 0; 
+    for(auto i = 0; i < TEST_NUM; i++) check_decryption(m[i], m_prime[i], FAIL_NUM); 
+
+    /* test decryption efficiency with the warmed-up cache */ 
+    Twisted_ElGamal_Cache_new(pp, CACHE_SIZE, CACHE_LRU); 
+    PLAINTEXT_CACHE_warmup(hot); 
+    start_time = chrono::steady_clock::now(); 
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        Twisted_ElGamal_Dec(pp, keypair.sk, CT[i], m_prime[i]); 
+    }
+    end_time = chrono::steady_clock::now(); 
+    running_time = end_time - start_time;
+    cout << "average decryption with cache takes time = " 
+    << chrono::duration <double, milli> (running_time).count()/TEST_NUM << " ms" << endl;
+    PLAINTEXT_CACHE_print_stats(); 
+    if(plaintext_cache.hits < HOT_MSG_NUM){
+        cout << "the cache misses common values: " << plaintext_cache.hits << " hits for " 
+             << HOT_MSG_NUM << " common messages" << endl; 
+        FAIL_NUM++; 
+    }
+    PLAINTEXT_CACHE_free(); 
+
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        check_decryption(m[i], m_prime[i], FAIL_NUM); 
+        BN_free(m[i]); 
+        BN_free(m_prime[i]); 
+        Twisted_ElGamal_CT_free(CT[i]); 
+    }
+    cout << "the cache benchmark fails " << FAIL_NUM << " times out of " << 2*TEST_NUM + 1 << " checks" << endl; 
+
+    Twisted_ElGamal_KP_free(keypair); 
+    Twisted_ElGamal_PP_free(pp); 
+}
+
+/*
+** compare the curves on the variable-base multiplications: Enc (pk^r), Decaps (the X^{sk^{-1}} of Dec) and ScalarMul,
+** secp256k1 runs with GLV and again with OpenSSL. every curve gets its own global environment, so call it outside of one
+*/
+void benchmark_curves_twisted_elgamal(vector<int> curve_id, size_t MSG_LEN, size_t TEST_NUM)
+{
+    SplitLine_print('-'); 
+    cout << "begin the benchmark test of the curves, test_num = " << TEST_NUM << endl;
+
+    for(auto c = 0; c < curve_id.size(); c++)
+    {
+        global_initialize(curve_id[c]); 
+        vector<int> backend = {group_backend}; 
+        if(group_backend == GROUP_SECP256K1_GLV) backend.push_back(GROUP_OPENSSL); 
+
+        Twisted_ElGamal_PP pp; 
+        Twisted_ElGamal_PP_new(pp); 
+        Twisted_ElGamal_Setup(pp, MSG_LEN, 0, 1, 1);
+
+        Twisted_ElGamal_KP keypair; 
+        Twisted_ElGamal_KP_new(keypair); 
+        Twisted_ElGamal_KeyGen(pp, keypair); 
+
+        BIGNUM *m[TEST_NUM];                        // messages  
+        BIGNUM *r[TEST_NUM];                        // randomness
+        BIGNUM *k[TEST_NUM];                        // scalars
+        EC_POINT *KEY[TEST_NUM];                    // encapsulated keys
+        EC_POINT *KEY_prime[TEST_NUM];              // decapsulated keys
+        Twisted_ElGamal_CT CT[TEST_NUM];            // CTs    
+        Twisted_ElGamal_CT CT_result[TEST_NUM];     // scalar multiplication results
+        for(auto i = 0; i < TEST_NUM; i++)
+        {
+            m[i] = BN_new(); 
+            BN_random(m[i]); 
+            BN_mod(m[i], m[i], pp.BN_MSG_SIZE, bn_ctx);
+            r[i] = BN_new(); 
+            BN_random(r[i]); 
+            k[i] = BN_new(); 
+            BN_random(k[i]); 
+            KEY[i] = EC_POINT_new(group); 
+            KEY_prime[i] = EC_POINT_new(group); 
+            Twisted_ElGamal_CT_new(CT[i]); 
+            Twisted_ElGamal_CT_new(CT_result[i]);
+        }
+
+        for(auto b = 0; b < backend.size(); b++)
+        {
+            group_backend = backend[b]; 
+            cout << OBJ_nid2sn(curve_id[c]) << ((group_backend == GROUP_SECP256K1_GLV) ? " (GLV)" : "") << ": " << endl; 
+
+            /* test encryption efficiency */ 
+            auto start_time = chrono::steady_clock::now(); 
+            for(auto i = 0; i < TEST_NUM; i++)
+            {
+                Twisted_ElGamal_Enc(pp, keypair.pk, m[i], r[i], CT[i]);
+            }
+            auto end_time = chrono::steady_clock::now(); 
+            auto running_time = end_time - start_time;
+            cout << "average encryption takes time = " 
+            << chrono::duration <double, milli> (running_time).count()/TEST_NUM << " ms" << endl;
+
+            /* test decapsulation efficiency: X^{sk^{-1}} is the multiplication of decryption */
+            for(auto i = 0; i < TEST_NUM; i++)
+            {
+                Twisted_ElGamal_Encaps(pp, keypair.pk, r[i], CT[i].X, KEY[i]); 
+            }
+            start_time = chrono::steady_clock::now(); 
+            for(auto i = 0; i < TEST_NUM; i++)
+            {
+                Twisted_ElGamal_Decaps(pp, keypair.sk, CT[i].X, KEY_prime[i]); 
+            }
+            end_time = chrono::steady_clock::now(); 
+            running_time = end_time - start_time;
+            cout << "average decapsulation takes time = " 
+            << chrono::duration <double, milli> (running_time).count()/TEST_NUM << " ms" << endl;
+
+            for(auto i = 0; i < TEST_NUM; i++)
+            {
+                if(EC_POINT_cmp(group, KEY[i], KEY_prime[i], bn_ctx) != 0){ 
+                    cout << "decapsulation fails" << endl;
+                } 
+            }
+
+            /* test scalar efficiency */
+            start_time = chrono::steady_clock::now(); 
+            for(auto i = 0; i < TEST_NUM; i++)
+            {
+                Twisted_ElGamal_ScalarMul(CT_result[i], CT[i], k[i]); 
+            }
+            end_time = chrono::steady_clock::now(); 
+            running_time = end_time - start_time;
+            cout << "average scalar operation takes time = " 
+            << chrono::duration <double, milli> (running_time).count()/TEST_NUM << " ms" << endl;
+        }
+
+        for(auto i = 0; i < TEST_NUM; i++)
+        {  
+            BN_free(m[i]);
+            BN_free(r[i]); 
+            BN_free(k[i]);  
+            EC_POINT_free(KEY[i]); 
+            EC_POINT_free(KEY_prime[i]); 
+            Twisted_ElGamal_CT_free(CT[i]); 
+            Twisted_ElGamal_CT_free(CT_result[i]); 
+        }
+        Twisted_ElGamal_KP_free(keypair); 
+        Twisted_ElGamal_PP_free(pp); 
+        global_finalize(); 
+    }
+}
+
+void benchmark_ristretto_twisted_elgamal(size_t MSG_LEN, size_t MAP_TUNNING, 
+                                         size_t IO_THREAD_NUM, size_t DEC_THREAD_NUM, size_t TEST_NUM)
+{
+    SplitLine_print('-'); 
+    cout << "begin the benchmark test of twisted ElGamal over ristretto255, test_num = " << TEST_NUM << endl;
+
+    Ristretto_Twisted_ElGamal_PP pp; 
+    Ristretto_Twisted_ElGamal_Setup(pp, MSG_LEN, MAP_TUNNING, IO_THREAD_NUM, DEC_THREAD_NUM);
+    Ristretto_Twisted_ElGamal_Initialize(pp); 
+
+    Ristretto_Twisted_ElGamal_KP keypair; 
+    Ristretto_Twisted_ElGamal_KP_new(keypair); 
+    Ristretto_Twisted_ElGamal_KeyGen(pp, keypair); 
+
+    BIGNUM *BN_MSG_SIZE = BN_new(); 
+    BN_set_word(BN_MSG_SIZE, uint64_t(pp.MSG_HI) - uint64_t(pp.MSG_LO)); 
+
+    BIGNUM *m[TEST_NUM];                            // messages  
+    BIGNUM *m_prime[TEST_NUM];                      // decrypted messages
+    Ristretto_Twisted_ElGamal_CT CT[TEST_NUM];      // CTs    
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        m[i] = BN_new(); 
+        BN_random(m[i]); 
+        BN_mod(m[i], m[i], BN_MSG_SIZE, bn_ctx);
+        m_prime[i] = BN_new(); 
+    }
+    // the edges of the message space
+    BN_zero(m[0]); 
+    BN_sub(m[TEST_NUM-1], BN_MSG_SIZE, BN_1); 
+
+    /* test encryption efficiency */ 
+    auto start_time = chrono::steady_clock::now(); 
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        Ristretto_Twisted_ElGamal_Enc(pp, keypair.pk, m[i], CT[i]);
+    }
+    auto end_time = chrono::steady_clock::now(); 
+    auto running_time = end_time - start_time;
+    cout << "average encryption takes time = " 
+    << chrono::duration <double, milli> (running_time).count()/TEST_NUM << " ms" << endl;
+
+    /* test decryption efficiency */ 
+    start_time = chrono::steady_clock::now(); 
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        Ristretto_Twisted_ElGamal_Dec(pp, keypair.sk, CT[i], m_prime[i]); 
+    }
+    end_time = chrono::steady_clock::now(); 
+    running_time = end_time - start_time;
+    cout << "average decryption takes time = " 
+    << chrono::duration <double, milli> (running_time).count()/TEST_NUM << " ms" << endl;
+
+    for(auto i = 0; i < TEST_NUM; i++)
+    {
+        if(BN_cmp(m[i], m_prime[i]) != 0){ 
+            cout << "decryption fails" << endl;
+        } 
+    }
+
+    /* the sum of two messages decrypts to their sum if it stays in the message space */
+    Ristretto_Twisted_ElGamal_CT CT_sum; 
+    BIGNUM *m_sum = BN_new(); 
+    BN_rshift1(m[1], m[1]); 
+    BN_rshift1(m[2], m[2]); 
+    Ristretto_Twisted_ElGamal_Enc(pp, keypair.pk, m[1], CT[1]);
+    Ristretto_Twisted_ElGamal_Enc(pp, keypair.pk, m[2], CT[2]);
+    Ristretto_Twisted_ElGamal_HomoAdd(CT_sum, CT[1], CT[2]); 
+    Ristretto_Twisted_ElGamal_Dec(pp, keypair.sk, CT_sum, m_prime[0]); 
+    BN_add(m_sum, m[1], m[2]); 
+    if(BN_cmp(m_sum, m_prime[0]) != 0){ 
+        cout << "homomorphic addition fails" << endl;
+    } 
+
+    for(auto i = 0; i < TEST_NUM; i++)
+    {  
+        BN_free(m[i]);
+        BN_free(m_prime[i]); 
+    }
+    BN_free(m_sum); 
+    BN_free(BN_MSG_SIZE); 
+    Ristretto_Twisted_ElGamal_KP_free(keypair); 
+}
+
 int main()
 {  
     global_initialize(NID_X9_62_prime256v1);   
@@ -457,8 +1251,21 @@ int main()
 
 
     // test_twisted_elgamal(MSG_LEN, MAP_TUNNING, IO_THREAD_NUM, DEC_THREAD_NUM);
+    test_twisted_elgamal(20, MAP_TUNNING, IO_THREAD_NUM, DEC_THREAD_NUM);
+    // test_interval_twisted_elgamal(-1000000, 1000000000, 1000000, IO_THREAD_NUM, DEC_THREAD_NUM);
+    test_interval_twisted_elgamal(-1000000, 1000000, 1024, IO_THREAD_NUM, DEC_THREAD_NUM);
+    test_progressive_twisted_elgamal(-1000000, 1000000, 1024, IO_THREAD_NUM, DEC_THREAD_NUM);
+    test_progressive_twisted_elgamal(0, 1 << 20, 1000, IO_THREAD_NUM, DEC_THREAD_NUM);
+    test_x_only_twisted_elgamal(-1000003, 700001, 1001, IO_THREAD_NUM, DEC_THREAD_NUM, 100);
+    test_x_only_twisted_elgamal(5, 1 << 20, 777, IO_THREAD_NUM, DEC_THREAD_NUM, 100);
+    test_placement_twisted_elgamal(20, MAP_TUNNING, IO_THREAD_NUM, DEC_THREAD_NUM, 100);
     // benchmark_twisted_elgamal(MSG_LEN, MAP_TUNNING, IO_THREAD_NUM, DEC_THREAD_NUM, TEST_NUM); 
+    benchmark_twisted_elgamal(20, MAP_TUNNING, IO_THREAD_NUM, DEC_THREAD_NUM, 300); 
     benchmark_parallel_twisted_elgamal(MSG_LEN, MAP_TUNNING, IO_THREAD_NUM, DEC_THREAD_NUM, TEST_NUM); 
+    // benchmark_kangaroo_twisted_elgamal(48, 16, IO_THREAD_NUM, DEC_THREAD_NUM, TEST_NUM); 
+    benchmark_kangaroo_twisted_elgamal(20, 6, IO_THREAD_NUM, DEC_THREAD_NUM, TEST_NUM); 
+    // benchmark_cache_twisted_elgamal(MSG_LEN, MAP_TUNNING, IO_THREAD_NUM, DEC_THREAD_NUM, 1024, 256, TEST_NUM); 
+    benchmark_cache_twisted_elgamal(20, MAP_TUNNING, IO_THREAD_NUM, DEC_THREAD_NUM, 1024, 256, TEST_NUM); 
 
     // SplitLine_print('-'); 
     // cout << "Twisted ElGamal PKE test finishes <<<<<<" << endl; 
@@ -467,6 +1274,13 @@ int main()
     //test_twisted_elgamal_encaps(MSG_LEN, MAP_TUNNING, IO_THREAD_NUM, DEC_THREAD_NUM, TEST_NUM); 
 
     global_finalize();
+
+    benchmark_curves_twisted_elgamal({NID_X9_62_prime256v1, NID_secp256k1}, MSG_LEN, TEST_NUM); 
+
+    // ristretto255 needs the thread pool and bn_ctx of global_initialize, not its curve
+    global_initialize(NID_X9_62_prime256v1);   
+    benchmark_ristretto_twisted_elgamal(MSG_LEN, MAP_TUNNING, IO_THREAD_NUM, DEC_THREAD_NUM, TEST_NUM); 
+    global_finalize();
     
     return 0; 
 }